@@ -0,0 +1,486 @@
+// Microbenchmarks for the capture, buffering and conversion hot paths, fed by
+// SyntheticSource so they run without a camera. Use Google Benchmark's
+// --benchmark_format=json or --benchmark_out=<file> for machine-readable
+// results.
+
+#include "BurstWriter.h"
+#include "CameraController.h"
+#include "FrameAllocator.h"
+#include "FrameConverter.h"
+#include "FrameGraph.h"
+#include "FrameRing.h"
+#include "FrameSource.h"
+#include "MosaicCompositor.h"
+#include "ParallelDecodeSource.h"
+#include <benchmark/benchmark.h>
+#include <QGuiApplication>
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <thread>
+
+namespace {
+
+// VGA, HD and Full HD; benchmarks take the width and height as arguments
+void resolutions(benchmark::internal::Benchmark* bench)
+{
+    bench->Args({640, 480})->Args({1280, 720})->Args({1920, 1080});
+}
+
+void skipResolutions(benchmark::internal::Benchmark* bench)
+{
+    for (int frames : {1, 10}) {
+        bench->Args({640, 480, frames})->Args({1280, 720, frames})->Args({1920, 1080, frames});
+    }
+}
+
+cv::Mat syntheticFrame(int width, int height)
+{
+    SyntheticSource source(width, height, 0.0);
+    source.open();
+    cv::Mat frame;
+    source.read(frame);
+    return frame;
+}
+
+void setFrameCounters(benchmark::State& state, int width, int height, int channels)
+{
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(width) * height * channels);
+}
+
+// Wait until the capture thread has published a frame newer than the one
+// on screen, so every iteration converts a fresh frame
+void waitForNewFrame(CameraController& controller, int64_t& lastBytes)
+{
+    while (true) {
+        controller.getCurrentImage();
+        int64_t total = static_cast<int64_t>(controller.conversionStats().totalBytes);
+        if (total != lastBytes) {
+            lastBytes = total;
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void BM_GetCurrentFrame(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+
+    CameraController controller;
+    controller.initialize(std::make_unique<SyntheticSource>(width, height, 0.0));
+    controller.start();
+
+    int64_t lastBytes = 0;
+    for (auto _ : state) {
+        waitForNewFrame(controller, lastBytes);
+    }
+
+    controller.stop();
+    setFrameCounters(state, width, height, 3);
+}
+BENCHMARK(BM_GetCurrentFrame)->Apply(resolutions)->UseRealTime();
+
+// Digital zoom on a 4K source, displayed at full size: only the crop is
+// converted, so the cost per frame falls with the square of the zoom
+void BM_DigitalZoom(benchmark::State& state)
+{
+    double zoom = static_cast<double>(state.range(0));
+    
+    CameraController controller;
+    controller.initialize(std::make_unique<SyntheticSource>(3840, 2160, 0.0));
+    controller.zoomAt(zoom);
+    controller.start();
+    
+    int64_t lastBytes = 0;
+    for (auto _ : state) {
+        waitForNewFrame(controller, lastBytes);
+    }
+    
+    controller.stop();
+    state.SetItemsProcessed(state.iterations());
+    state.counters["copied_bytes_per_frame"] = static_cast<double>(controller.conversionStats().lastFrameBytes);
+}
+BENCHMARK(BM_DigitalZoom)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+void BM_MatToQImage(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    cv::Mat frame = syntheticFrame(width, height);
+    FrameConverter converter;
+
+    for (auto _ : state) {
+        QImage image = converter.toImage(frame);
+        benchmark::DoNotOptimize(image.constBits());
+    }
+
+    setFrameCounters(state, width, height, 3);
+    state.counters["copied_bytes_per_frame"] = static_cast<double>(converter.stats().lastFrameBytes);
+}
+BENCHMARK(BM_MatToQImage)->Apply(resolutions);
+
+void BM_MatToQPixmap(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    cv::Mat frame = syntheticFrame(width, height);
+    FrameConverter converter;
+
+    for (auto _ : state) {
+        QPixmap pixmap = converter.toPixmap(frame);
+        benchmark::DoNotOptimize(pixmap.cacheKey());
+    }
+
+    setFrameCounters(state, width, height, 3);
+    state.counters["copied_bytes_per_frame"] = static_cast<double>(converter.stats().lastFrameBytes);
+}
+BENCHMARK(BM_MatToQPixmap)->Apply(resolutions);
+
+// Steady state of a full history: every push overwrites the oldest frame
+void BM_FrameRingPushEvict(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    cv::Mat frame = syntheticFrame(width, height);
+
+    FrameRing ring(100);
+    ring.allocate(width, height, CV_8UC3);
+    int64_t timestamp = 0;
+    for (int i = 0; i <= ring.capacity(); ++i) {
+        frame.copyTo(*ring.beginWrite());
+        ring.commitWrite(++timestamp);
+    }
+
+    for (auto _ : state) {
+        cv::Mat* slot = ring.beginWrite();
+        frame.copyTo(*slot);
+        ring.commitWrite(++timestamp);
+    }
+
+    setFrameCounters(state, width, height, 3);
+}
+BENCHMARK(BM_FrameRingPushEvict)->Apply(resolutions);
+
+// Forward skip reads and discards frames from the source
+void BM_SkipFramesForward(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    int frames = static_cast<int>(state.range(2));
+
+    CameraController controller;
+    controller.initialize(std::make_unique<SyntheticSource>(width, height, 0.0));
+
+    for (auto _ : state) {
+        controller.skipFrames(frames);
+    }
+
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_SkipFramesForward)->Apply(skipResolutions);
+
+// Backward skip seeks within the history while paused; each iteration
+// returns to live first
+void BM_SkipFramesBackward(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    int frames = static_cast<int>(state.range(2));
+
+    CameraController controller;
+    controller.initialize(std::make_unique<SyntheticSource>(width, height, 0.0));
+    controller.start();
+
+    int64_t lastBytes = 0;
+    for (auto _ : state) {
+        // Refill: show a frame with enough history behind it, then freeze
+        state.PauseTiming();
+        controller.jumpToLive();
+        controller.resume();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        waitForNewFrame(controller, lastBytes);
+        controller.pause();
+        state.ResumeTiming();
+
+        controller.skipFrames(-frames);
+    }
+
+    controller.stop();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SkipFramesBackward)->Apply(skipResolutions)->UseRealTime();
+
+// Multi-camera scaling: N unthrottled 720p synthetic cameras, each on its
+// own capture thread, composited into a 1080p mosaic per iteration. Reports
+// aggregate capture FPS and the CPU cores each stream costs (process CPU
+// time from std::clock, so meaningful on POSIX only).
+void BM_MultiCameraMosaic(benchmark::State& state)
+{
+    int cameras = static_cast<int>(state.range(0));
+    
+    std::vector<std::unique_ptr<CameraController>> controllers;
+    for (int i = 0; i < cameras; ++i) {
+        controllers.push_back(std::make_unique<CameraController>());
+        controllers.back()->initialize(std::make_unique<SyntheticSource>(1280, 720, 0.0));
+    }
+    MosaicCompositor compositor;
+    std::vector<cv::Mat> frames(cameras);
+    
+    for (auto& controller : controllers) {
+        controller->start();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    
+    auto wallStart = std::chrono::steady_clock::now();
+    std::clock_t cpuStart = std::clock();
+    uint64_t capturedStart = 0;
+    for (auto& controller : controllers) {
+        capturedStart += controller->metrics().snapshot().framesCaptured;
+    }
+    
+    for (auto _ : state) {
+        for (int i = 0; i < cameras; ++i) {
+            frames[i] = controllers[i]->getCurrentMat();
+        }
+        QImage mosaic = compositor.compose(frames, 1920, 1080);
+        benchmark::DoNotOptimize(mosaic.constBits());
+    }
+    
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    uint64_t captured = 0;
+    for (auto& controller : controllers) {
+        captured += controller->metrics().snapshot().framesCaptured;
+        controller->stop();
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["aggregate_capture_fps"] = (captured - capturedStart) / wallSeconds;
+    state.counters["per_stream_fps"] = (captured - capturedStart) / wallSeconds / cameras;
+    state.counters["cpu_cores_per_stream"] = cpuSeconds / wallSeconds / cameras;
+}
+BENCHMARK(BM_MultiCameraMosaic)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->MinTime(2.0);
+
+// Worker threads, and whether the chain includes a stage that must see
+// frames in order
+void graphConfigurations(benchmark::internal::Benchmark* bench)
+{
+    for (int ordered : {0, 1}) {
+        for (int threads : {1, 2, 4, 8}) {
+            bench->Args({threads, ordered});
+        }
+    }
+}
+
+// Full HD frames through denoise, [temporal denoise,] resize and overlay,
+// with the graph kept full. Throughput should grow with the thread count
+// until the in-order stage, if any, becomes the bottleneck.
+void BM_ProcessingGraph(benchmark::State& state)
+{
+    int threads = static_cast<int>(state.range(0));
+    bool ordered = state.range(1) != 0;
+    cv::Mat frame = syntheticFrame(1920, 1080);
+    
+    FrameGraph graph(threads);
+    graph.addStage(std::make_unique<DenoiseStage>(5));
+    if (ordered) {
+        graph.addStage(std::make_unique<TemporalDenoiseStage>(0.5));
+    }
+    graph.addStage(std::make_unique<ResizeStage>(1280, 720));
+    graph.addStage(std::make_unique<OverlayStage>());
+    
+    std::atomic<int64_t> delivered{0};
+    std::atomic<bool> outOfOrder{false};
+    int64_t expected = 0;
+    graph.setOutputCallback([&](FrameGraph::Output& output) {
+        if (output.sequence != expected) {
+            outOfOrder = true;
+        }
+        expected = output.sequence + 1;
+        ++delivered;
+    });
+    
+    int64_t sequence = 0;
+    for (auto _ : state) {
+        while (!graph.submit(frame, sequence, 0)) {
+            std::this_thread::yield();
+        }
+        ++sequence;
+    }
+    graph.waitIdle();
+    
+    if (outOfOrder) {
+        state.SkipWithError("frames left the graph out of order");
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(delivered), benchmark::Counter::kIsRate);
+    FrameGraph::Stats stats = graph.stats();
+    state.counters["latency_ms"] = stats.latencyMs;
+    for (const auto& stage : stats.stages) {
+        state.counters[stage.name.substr(0, stage.name.find(' ')) + "_ms"] = stage.meanMs;
+    }
+}
+BENCHMARK(BM_ProcessingGraph)->Apply(graphConfigurations)->UseRealTime()->MinTime(2.0);
+
+// A recorded 1080p MJPEG stream standing in for a camera in MJPEG mode:
+// 60 moving synthetic frames, written once per run
+std::string mjpegRecording()
+{
+    static std::string path;
+    if (path.empty()) {
+        path = (std::filesystem::temp_directory_path() / "qtcamera_bench.mjpg").string();
+        SyntheticSource source(1920, 1080, 0.0);
+        source.open();
+        std::ofstream file(path, std::ios::binary);
+        cv::Mat frame;
+        std::vector<uchar> jpeg;
+        for (int i = 0; i < 60; ++i) {
+            source.read(frame);
+            cv::imencode(".jpg", frame, jpeg, {cv::IMWRITE_JPEG_QUALITY, 85});
+            file.write(reinterpret_cast<const char*>(jpeg.data()), static_cast<std::streamsize>(jpeg.size()));
+        }
+    }
+    return path;
+}
+
+// Frames read from the recorded MJPEG stream as fast as they decode. 0
+// threads decodes on the reading thread, as CameraSource does with OpenCV's
+// conversion on; otherwise ParallelDecodeSource decodes ahead on a pool and
+// hands frames out in order.
+void BM_ParallelDecode(benchmark::State& state)
+{
+    int threads = static_cast<int>(state.range(0));
+    std::unique_ptr<FrameSource> source = std::make_unique<MjpegFileSource>(mjpegRecording(), 0.0);
+    if (threads > 0) {
+        source = std::make_unique<ParallelDecodeSource>(std::move(source), threads);
+    }
+    if (!source->open()) {
+        state.SkipWithError("cannot open the MJPEG recording");
+        return;
+    }
+    
+    cv::Mat frame;
+    for (auto _ : state) {
+        if (!source->read(frame)) {
+            state.SkipWithError("read failed");
+            break;
+        }
+    }
+    source->close();
+    
+    setFrameCounters(state, 1920, 1080, 3);
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ParallelDecode)->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->MinTime(2.0);
+
+// A 30-frame 1080p burst pushed at once and written to a temp directory,
+// PNG (0) or JPEG (1) on 1-8 encoder threads. Rates are the writer's own,
+// from the first push to the last file written.
+void BM_BurstWrite(benchmark::State& state)
+{
+    BurstWriter::Format format = state.range(0) == 0 ? BurstWriter::Format::Png : BurstWriter::Format::Jpeg;
+    int threads = static_cast<int>(state.range(1));
+    const int burstFrames = 30;
+    
+    SyntheticSource source(1920, 1080, 0.0);
+    source.open();
+    std::vector<cv::Mat> frames(8);
+    for (auto& frame : frames) {
+        source.read(frame);
+    }
+    
+    std::string directory = (std::filesystem::temp_directory_path() / "qtcamera_bench_burst").string();
+    BurstWriter writer(threads);
+    double fps = 0.0;
+    double megabytes = 0.0;
+    for (auto _ : state) {
+        writer.begin(directory, "burst", format);
+        for (int i = 0; i < burstFrames; ++i) {
+            writer.push(frames[i % frames.size()]);
+        }
+        writer.waitIdle();
+        BurstWriter::Stats stats = writer.stats();
+        if (stats.written != static_cast<uint64_t>(burstFrames)) {
+            state.SkipWithError("burst frames were not written");
+            break;
+        }
+        fps += stats.fps;
+        megabytes += stats.mbPerSecond;
+    }
+    std::filesystem::remove_all(directory);
+    
+    double bursts = static_cast<double>(std::max<int64_t>(state.iterations(), 1));
+    state.SetItemsProcessed(state.iterations() * burstFrames);
+    state.SetBytesProcessed(state.iterations() * burstFrames * static_cast<int64_t>(1920) * 1080 * 3);
+    state.counters["fps"] = fps / bursts;
+    state.counters["MB/s"] = megabytes / bursts;
+}
+BENCHMARK(BM_BurstWrite)->ArgsProduct({{0, 1}, {1, 2, 4, 8}})->UseRealTime()->MinTime(2.0);
+
+// A full-frame buffer handed on and replaced every frame, as the
+// processing graph's output is, with four frames alive at once. 0 takes the
+// buffers from the heap, 1 from the frame pool; the counters show how many
+// blocks the pool still had to take from the system.
+void BM_FrameAllocation(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    bool pooled = state.range(2) != 0;
+    FrameAllocator::Stats before = FrameAllocator::instance()->stats();
+    
+    std::vector<cv::Mat> alive(4);
+    size_t next = 0;
+    for (auto _ : state) {
+        cv::Mat frame;
+        if (pooled) {
+            FrameAllocator::use(frame);
+        }
+        frame.create(height, width, CV_8UC3);
+        frame.data[0] = 1;
+        alive[next] = std::move(frame);
+        next = (next + 1) % alive.size();
+    }
+    alive.clear();
+    
+    FrameAllocator::Stats after = FrameAllocator::instance()->stats();
+    state.counters["system_allocations"] = static_cast<double>(after.systemAllocations - before.systemAllocations);
+    state.counters["huge_page_blocks"] = static_cast<double>(after.hugePageBlocks - before.hugePageBlocks);
+}
+BENCHMARK(BM_FrameAllocation)->ArgsProduct({{1920}, {1080}, {0, 1}})->ArgsProduct({{3840}, {2160}, {0, 1}});
+
+void discardDebugOutput(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    if (type != QtDebugMsg) {
+        std::fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // QPixmap needs a GUI application; the offscreen platform needs no display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    qInstallMessageHandler(discardDebugOutput);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Throughput comparison of the PixelKernels conversions against cv::cvtColor.
+// Every kernel variant is checked byte for byte against OpenCV's output
+// before it is timed; any mismatch is reported and fails the run.
+
+#include "PixelKernels.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace {
+
+struct Resolution {
+    int width;
+    int height;
+    const char* name;
+};
+
+const Resolution RESOLUTIONS[] = {
+    {640, 480, "640x480"},
+    {1280, 720, "1280x720"},
+    {1920, 1080, "1920x1080"},
+};
+
+const PixelKernels::Isa ISAS[] = {
+    PixelKernels::Isa::Scalar,
+    PixelKernels::Isa::Sse41,
+    PixelKernels::Isa::Avx2,
+    PixelKernels::Isa::Neon,
+};
+
+double millisecondsPerRun(const std::function<void()>& run)
+{
+    // Warm up caches and the dispatch tables, then time a fixed batch
+    run();
+    const int iterations = 50;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        run();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+void printRow(const char* format, const Resolution& resolution, const char* variant, double ms)
+{
+    double megapixels = resolution.width * static_cast<double>(resolution.height) / 1e6;
+    std::printf("%-10s %-10s %-8s %8.3f ms %9.1f MP/s\n",
+                format, resolution.name, variant, ms, megapixels / (ms / 1000.0));
+}
+
+// Source layout per format: rows x cols x type of the input Mat
+template <typename Format>
+cv::Mat makeSource(const Resolution& resolution)
+{
+    int rows = Format::planar ? resolution.height * 3 / 2 : resolution.height;
+    cv::Mat source(rows, resolution.width, CV_8UC(Format::srcChannels));
+    cv::randu(source, cv::Scalar::all(0), cv::Scalar::all(256));
+    return source;
+}
+
+template <typename Format>
+int benchmarkFormat(const char* name, int openCvCode)
+{
+    int failures = 0;
+
+    for (const auto& resolution : RESOLUTIONS) {
+        cv::Mat source = makeSource<Format>(resolution);
+        cv::Mat expected;
+        if (openCvCode < 0) {
+            expected = source.clone();
+        }
+        else {
+            cv::cvtColor(source, expected, openCvCode);
+        }
+
+        cv::Mat actual(resolution.height, resolution.width, CV_8UC(Format::dstChannels));
+
+        double ms = millisecondsPerRun([&] {
+            if (openCvCode < 0) {
+                source.copyTo(expected);
+            }
+            else {
+                cv::cvtColor(source, expected, openCvCode);
+            }
+        });
+        printRow(name, resolution, "opencv", ms);
+
+        for (PixelKernels::Isa isa : ISAS) {
+            if (!PixelKernels::isSupported(isa)) {
+                continue;
+            }
+
+            actual.setTo(cv::Scalar::all(0));
+            PixelKernels::convert<Format>(isa, source.data, source.step, actual.data, actual.step,
+                                          resolution.width, resolution.height);
+            if (cv::norm(actual, expected, cv::NORM_INF) != 0) {
+                std::printf("MISMATCH   %-10s %-8s differs from OpenCV\n", resolution.name,
+                            PixelKernels::isaName(isa));
+                ++failures;
+                continue;
+            }
+
+            ms = millisecondsPerRun([&] {
+                PixelKernels::convert<Format>(isa, source.data, source.step, actual.data, actual.step,
+                                              resolution.width, resolution.height);
+            });
+            printRow(name, resolution, PixelKernels::isaName(isa), ms);
+        }
+    }
+
+    return failures;
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("Detected instruction set: %s\n\n", PixelKernels::isaName(PixelKernels::detectIsa()));
+
+    int failures = 0;
+    failures += benchmarkFormat<PixelKernels::Bgr2Rgb>("BGR>RGB", cv::COLOR_BGR2RGB);
+    failures += benchmarkFormat<PixelKernels::Bgr2Bgrx>("BGR>BGRX", cv::COLOR_BGR2BGRA);
+    failures += benchmarkFormat<PixelKernels::Bgra2Rgba>("BGRA>RGBA", cv::COLOR_BGRA2RGBA);
+    failures += benchmarkFormat<PixelKernels::GrayCopy>("GRAY", -1);
+    failures += benchmarkFormat<PixelKernels::Yuyv2Rgb>("YUYV>RGB", cv::COLOR_YUV2RGB_YUYV);
+    failures += benchmarkFormat<PixelKernels::Nv12ToRgb>("NV12>RGB", cv::COLOR_YUV2RGB_NV12);
+
+    if (failures > 0) {
+        std::printf("\n%d kernel variant(s) did not match OpenCV\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Load test for the MJPEG streaming endpoint. Streams a synthetic camera to
+// many local HTTP clients at once, some of which read too slowly to keep up,
+// and reports what the fast and slow clients received and whether capture
+// slowed down compared with a run without clients.
+//
+//   stream_load_test [clients] [slow clients] [seconds] [WxH@fps]
+
+#include "CameraController.h"
+#include "MjpegServer.h"
+#include <QCoreApplication>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Counts multipart boundaries in a byte stream that arrives in arbitrary
+// chunks, so a boundary split across two reads is still seen once
+class FrameCounter
+{
+public:
+    void feed(const QByteArray& data)
+    {
+        QByteArray window = m_tail + data;
+        for (qsizetype at = window.indexOf(BOUNDARY); at >= 0; at = window.indexOf(BOUNDARY, at + 1)) {
+            ++frames;
+        }
+        bytes += data.size();
+        m_tail = window.right(BOUNDARY.size() - 1);
+    }
+
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+
+private:
+    static const QByteArray BOUNDARY;
+    QByteArray m_tail;
+};
+
+const QByteArray FrameCounter::BOUNDARY = "--mjpegframe\r\n";
+
+struct LoadClient {
+    std::unique_ptr<QTcpSocket> socket;
+    FrameCounter counter;
+    bool slow = false;
+};
+
+double measureCaptureFps(CameraController& controller, int seconds)
+{
+    controller.metrics().reset();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    return controller.metrics().snapshot().captureFps;
+}
+
+void printFpsSpread(const char* label, const std::vector<double>& fps)
+{
+    if (fps.empty()) {
+        return;
+    }
+    double total = 0.0;
+    for (double value : fps) {
+        total += value;
+    }
+    std::printf("%-14s %3zu clients  fps min %6.1f  mean %6.1f  max %6.1f\n", label, fps.size(),
+                *std::min_element(fps.begin(), fps.end()), total / fps.size(),
+                *std::max_element(fps.begin(), fps.end()));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int clientCount = argc > 1 ? std::atoi(argv[1]) : 50;
+    int slowCount = argc > 2 ? std::atoi(argv[2]) : 5;
+    int seconds = argc > 3 ? std::atoi(argv[3]) : 10;
+    std::string spec = std::string("synthetic:") + (argc > 4 ? argv[4] : "1280x720@30");
+    slowCount = std::min(slowCount, clientCount);
+
+    CameraController controller;
+    controller.initialize(createFrameSource(spec));
+    controller.start();
+
+    MjpegServer server;
+    if (!server.start(0, QHostAddress::LocalHost)) {
+        std::fprintf(stderr, "Cannot start the MJPEG server\n");
+        return 1;
+    }
+    controller.addFrameListener([&server](const cv::Mat& frame, int64_t, int64_t) { server.pushFrame(frame); });
+
+    std::printf("Source %s, %d clients (%d slow), %d s\n", spec.c_str(), clientCount, slowCount, seconds);
+    double baselineFps = measureCaptureFps(controller, 2);
+
+    // Slow clients keep a small receive buffer and only drain a little of
+    // it now and then, so the server sees their sockets back up
+    std::vector<LoadClient> clients(clientCount);
+    for (int i = 0; i < clientCount; ++i) {
+        LoadClient& client = clients[i];
+        client.slow = i < slowCount;
+        client.socket = std::make_unique<QTcpSocket>();
+        QTcpSocket* socket = client.socket.get();
+        FrameCounter* counter = &client.counter;
+        if (client.slow) {
+            socket->setReadBufferSize(64 * 1024);
+            socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 64 * 1024);
+        } else {
+            QObject::connect(socket, &QTcpSocket::readyRead, [socket, counter] { counter->feed(socket->readAll()); });
+        }
+        QObject::connect(socket, &QTcpSocket::connected, [socket] {
+            socket->write("GET /stream HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        });
+        socket->connectToHost(QHostAddress::LocalHost, server.port());
+    }
+
+    QTimer trickle;
+    QObject::connect(&trickle, &QTimer::timeout, [&clients] {
+        for (LoadClient& client : clients) {
+            if (client.slow) {
+                client.counter.feed(client.socket->read(16 * 1024));
+            }
+        }
+    });
+    trickle.start(100);
+
+    controller.metrics().reset();
+    QTimer::singleShot(seconds * 1000, &app, &QCoreApplication::quit);
+    auto start = std::chrono::steady_clock::now();
+    app.exec();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double loadedFps = controller.metrics().snapshot().captureFps;
+
+    std::vector<double> fastFps;
+    std::vector<double> slowFps;
+    uint64_t bytes = 0;
+    for (const LoadClient& client : clients) {
+        (client.slow ? slowFps : fastFps).push_back(client.counter.frames / elapsed);
+        bytes += client.counter.bytes;
+    }
+
+    MjpegServer::Stats stats = server.stats();
+    std::printf("capture fps    without clients %.1f, with clients %.1f\n", baselineFps, loadedFps);
+    printFpsSpread("fast clients", fastFps);
+    printFpsSpread("slow clients", slowFps);
+    std::printf("server         %llu frames encoded (%.1f ms last), %llu sent, %llu skipped for slow clients, "
+                "%llu arrived while encoding\n",
+                static_cast<unsigned long long>(stats.framesEncoded), stats.encodeMs,
+                static_cast<unsigned long long>(stats.framesSent),
+                static_cast<unsigned long long>(stats.framesSkipped),
+                static_cast<unsigned long long>(stats.framesNotEncoded));
+    std::printf("throughput     %.1f MB/s received in total\n", bytes / elapsed / (1024.0 * 1024.0));
+
+    for (LoadClient& client : clients) {
+        client.socket->abort();
+    }
+    server.stop();
+    controller.stop();
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Sample consumer of the shared-memory frame ring. Maps the ring the
+// application publishes with --shm-name, reads each new frame in place and
+// reports the frame rate, frames missed or overwritten mid-read, and the
+// latency from capture to the frame being available here.
+//
+//   shm_consumer <name> [seconds] [spin|sleep]
+//
+// "spin" polls continuously and shows what the ring itself adds; "sleep"
+// polls every millisecond, which is what a CPU-friendly consumer would do.
+
+#include "SharedFrameReader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+double percentile(std::vector<int64_t>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index] / 1e3;
+}
+
+// Stand-in for real analysis: mean of the first channel, read in place
+double meanLevel(const SharedFrameReader::Frame& frame)
+{
+    int channels = (frame.type >> 3) + 1;
+    uint64_t sum = 0;
+    for (int y = 0; y < frame.height; y += 4) {
+        const uint8_t* row = frame.data + static_cast<size_t>(y) * frame.stride;
+        for (int x = 0; x < frame.width; x += 4) {
+            sum += row[x * channels];
+        }
+    }
+    uint64_t samples = static_cast<uint64_t>((frame.height + 3) / 4) * ((frame.width + 3) / 4);
+    return static_cast<double>(sum) / samples;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <name> [seconds] [spin|sleep]\n", argv[0]);
+        return 2;
+    }
+    std::string name = argv[1];
+    int seconds = argc > 2 ? std::atoi(argv[2]) : 10;
+    bool spin = argc > 3 && std::strcmp(argv[3], "spin") == 0;
+
+    SharedFrameReader reader;
+    if (!reader.open(name)) {
+        std::fprintf(stderr, "%s\n", reader.error().c_str());
+        return 1;
+    }
+    std::printf("Reading %s (%d slots), %s polling, %d s\n", name.c_str(), reader.slotCount(),
+                spin ? "spin" : "sleep", seconds);
+
+    std::vector<int64_t> latencies;
+    uint64_t seen = reader.latestSequence();
+    uint64_t frames = 0;
+    uint64_t missed = 0;
+    uint64_t torn = 0;
+    double level = 0.0;
+    SharedFrameReader::Frame frame;
+
+    int64_t start = SharedFrameReader::now();
+    int64_t end = start + static_cast<int64_t>(seconds) * 1000000000;
+    while (SharedFrameReader::now() < end && !reader.publisherClosed()) {
+        if (!reader.acquire(frame, seen)) {
+            if (spin) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            continue;
+        }
+        latencies.push_back(SharedFrameReader::now() - frame.timestamp);
+
+        double result = meanLevel(frame);
+        if (!reader.isValid(frame)) {
+            ++torn;
+            continue;
+        }
+        if (seen > 0 && frame.sequence > seen + 1) {
+            missed += frame.sequence - seen - 1;
+        }
+        seen = frame.sequence;
+        level = result;
+        ++frames;
+    }
+    double elapsed = (SharedFrameReader::now() - start) / 1e9;
+
+    if (reader.publisherClosed()) {
+        std::printf("Publisher closed the ring\n");
+    }
+    std::printf("frames         %llu (%.1f fps), last %dx%d, mean level %.1f\n",
+                static_cast<unsigned long long>(frames), frames / elapsed, frame.width, frame.height, level);
+    std::printf("missed         %llu skipped by the publisher, %llu overwritten while reading\n",
+                static_cast<unsigned long long>(missed), static_cast<unsigned long long>(torn));
+    std::printf("latency us     capture to available: p50 %.1f  p99 %.1f  max %.1f\n",
+                percentile(latencies, 0.50), percentile(latencies, 0.99), percentile(latencies, 1.0));
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include "BurstWriter.h"
+#include "FrameAllocator.h"
+#include "PipelineMetrics.h"
+#include <opencv2/imgcodecs.hpp>
+#include <QDebug>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+BurstWriter::BurstWriter(int threads, size_t budgetBytes)
+    : m_budget(budgetBytes)
+    , m_quality(95)
+    , m_format(Format::Png)
+    , m_nextIndex(0)
+    , m_pendingBytes(0)
+    , m_pendingFrames(0)
+    , m_frames(0)
+    , m_written(0)
+    , m_dropped(0)
+    , m_failed(0)
+    , m_bytesWritten(0)
+    , m_rawBytesWritten(0)
+    , m_encodeNs(0)
+    , m_firstPush(0)
+    , m_lastWrite(0)
+    , m_pool(threads)
+{
+}
+
+BurstWriter::~BurstWriter()
+{
+    waitIdle();
+}
+
+bool BurstWriter::begin(const std::string& directory, const std::string& prefix, Format format)
+{
+    waitIdle();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        qDebug() << "Cannot create snapshot directory" << QString::fromStdString(directory);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directory = directory;
+    m_prefix = prefix;
+    m_format = format;
+    m_nextIndex = 0;
+    m_frames = 0;
+    m_written = 0;
+    m_dropped = 0;
+    m_failed = 0;
+    m_bytesWritten = 0;
+    m_rawBytesWritten = 0;
+    m_encodeNs = 0;
+    m_firstPush = 0;
+    m_lastWrite = 0;
+    return true;
+}
+
+bool BurstWriter::push(const cv::Mat& frame)
+{
+    if (frame.empty()) {
+        return false;
+    }
+
+    size_t bytes = frame.total() * frame.elemSize();
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_frames;
+        if (m_firstPush == 0) {
+            m_firstPush = PipelineMetrics::now();
+        }
+        if (m_pendingBytes + bytes > m_budget) {
+            ++m_dropped;
+            return false;
+        }
+        m_pendingBytes += bytes;
+        ++m_pendingFrames;
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "-%04d.", m_nextIndex++);
+        path = (std::filesystem::path(m_directory) / (m_prefix + name + extension(m_format))).string();
+    }
+
+    // The one copy made on the calling thread; the source frame may be
+    // overwritten as soon as this returns. Copies of the same size recycle
+    // each other's buffers through the frame pool. The task moves its copy
+    // into encode(), so the buffer is released there, when it leaves the
+    // budget, rather than when the task is destroyed.
+    cv::Mat copy;
+    FrameAllocator::use(copy);
+    frame.copyTo(copy);
+    m_pool.submit([this, copy, path]() mutable { encode(std::move(copy), std::move(path)); });
+    return true;
+}
+
+void BurstWriter::setQuality(int quality)
+{
+    m_quality = std::clamp(quality, 1, 100);
+}
+
+bool BurstWriter::isIdle() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pendingFrames == 0;
+}
+
+void BurstWriter::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_pendingFrames == 0; });
+}
+
+BurstWriter::Stats BurstWriter::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.frames = m_frames;
+    stats.written = m_written;
+    stats.dropped = m_dropped;
+    stats.failed = m_failed;
+    stats.pending = m_pendingFrames;
+    stats.bytesWritten = m_bytesWritten;
+
+    // Still running bursts are measured up to now
+    int64_t end = m_pendingFrames > 0 ? PipelineMetrics::now() : m_lastWrite;
+    stats.seconds = m_firstPush > 0 && end > m_firstPush ? (end - m_firstPush) / 1e9 : 0.0;
+    if (stats.seconds > 0.0) {
+        stats.fps = m_written / stats.seconds;
+        stats.mbPerSecond = m_rawBytesWritten / (1024.0 * 1024.0) / stats.seconds;
+        stats.diskMbPerSecond = m_bytesWritten / (1024.0 * 1024.0) / stats.seconds;
+    }
+    uint64_t encoded = m_written + m_failed;
+    stats.encodeMs = encoded > 0 ? m_encodeNs / 1e6 / encoded : 0.0;
+    return stats;
+}
+
+const char* BurstWriter::extension(Format format)
+{
+    return format == Format::Jpeg ? "jpg" : "png";
+}
+
+bool BurstWriter::parseFormat(const std::string& name, Format& format)
+{
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lower == "png") {
+        format = Format::Png;
+        return true;
+    }
+    if (lower == "jpg" || lower == "jpeg") {
+        format = Format::Jpeg;
+        return true;
+    }
+    return false;
+}
+
+void BurstWriter::encode(cv::Mat frame, std::string path)
+{
+    int64_t start = PipelineMetrics::now();
+
+    // Level 1 PNG is several times faster than the default and only a
+    // little larger, which matters more for bursts than file size
+    std::vector<int> params;
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".png") == 0) {
+        params = {cv::IMWRITE_PNG_COMPRESSION, 1};
+    } else {
+        params = {cv::IMWRITE_JPEG_QUALITY, m_quality.load()};
+    }
+
+    std::vector<uchar> encoded;
+    bool ok = false;
+    try {
+        ok = cv::imencode(path.substr(path.find_last_of('.')), frame, encoded, params);
+    }
+    catch (const cv::Exception& e) {
+        qDebug() << "Cannot encode snapshot:" << e.what();
+    }
+    if (ok) {
+        std::ofstream file(path, std::ios::binary);
+        ok = file && file.write(reinterpret_cast<const char*>(encoded.data()),
+                                static_cast<std::streamsize>(encoded.size()));
+    }
+    if (!ok) {
+        qDebug() << "Cannot write snapshot" << QString::fromStdString(path);
+    }
+    int64_t end = PipelineMetrics::now();
+
+    size_t bytes = frame.total() * frame.elemSize();
+    frame.release();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingBytes -= bytes;
+        --m_pendingFrames;
+        m_encodeNs += end - start;
+        m_lastWrite = end;
+        if (ok) {
+            ++m_written;
+            m_bytesWritten += encoded.size();
+            m_rawBytesWritten += bytes;
+        } else {
+            ++m_failed;
+        }
+    }
+    m_idle.notify_all();
+}
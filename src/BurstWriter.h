@@ -0,0 +1,101 @@
+#ifndef BURSTWRITER_H
+#define BURSTWRITER_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "ThreadPool.h"
+
+// Saves bursts of full-resolution snapshots as image files.
+//
+// push() copies the frame and returns; a pool of encoder threads compresses
+// the copies to PNG or JPEG and writes them to disk in parallel, so the
+// thread that pushes (the capture thread) never waits for an encoder or the
+// disk. Copies waiting for an encoder are bounded by a memory budget, beyond
+// which frames are dropped and counted. Files are named
+// <directory>/<prefix>-NNNN.<ext>, numbered from 0 within each burst.
+class BurstWriter
+{
+public:
+    enum class Format {
+        Png,
+        Jpeg
+    };
+
+    // Current or last burst. Rates are over the time from the first frame
+    // pushed to the last file written.
+    struct Stats {
+        uint64_t frames = 0;        // pushed
+        uint64_t written = 0;
+        uint64_t dropped = 0;       // over the memory budget
+        uint64_t failed = 0;        // could not be encoded or written
+        size_t pending = 0;         // copied, not yet written
+        uint64_t bytesWritten = 0;  // encoded file sizes
+        double seconds = 0.0;
+        double fps = 0.0;
+        double mbPerSecond = 0.0;   // raw frame data encoded per second
+        double diskMbPerSecond = 0.0;
+        double encodeMs = 0.0;      // mean per frame on one thread
+    };
+
+    static const size_t DEFAULT_BUDGET_MB = 1024;
+
+    // 0 threads means one per hardware thread
+    explicit BurstWriter(int threads = 0, size_t budgetBytes = DEFAULT_BUDGET_MB * 1024 * 1024);
+    ~BurstWriter();
+
+    // Start a new burst and reset the stats. Waits for the previous burst's
+    // files first. False if the directory cannot be created.
+    bool begin(const std::string& directory, const std::string& prefix, Format format);
+
+    // Queue a copy of frame for the current burst; false if it was dropped
+    bool push(const cv::Mat& frame);
+
+    // JPEG quality, 1-100; PNG is always written at a fast compression level
+    void setQuality(int quality);
+
+    bool isIdle() const;
+    void waitIdle();
+
+    Stats stats() const;
+    int threads() const { return m_pool.size(); }
+
+    static const char* extension(Format format);
+    static bool parseFormat(const std::string& name, Format& format);
+
+private:
+    void encode(cv::Mat frame, std::string path);
+
+    size_t m_budget;
+    std::atomic<int> m_quality;
+
+    // Current burst, changed by begin() only while idle
+    std::string m_directory;
+    std::string m_prefix;
+    Format m_format;
+    int m_nextIndex;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_idle;
+    size_t m_pendingBytes;
+    size_t m_pendingFrames;
+    uint64_t m_frames;
+    uint64_t m_written;
+    uint64_t m_dropped;
+    uint64_t m_failed;
+    uint64_t m_bytesWritten;
+    uint64_t m_rawBytesWritten;
+    int64_t m_encodeNs;
+    int64_t m_firstPush;
+    int64_t m_lastWrite;
+
+    // Last, so workers are joined before anything they use goes away
+    ThreadPool m_pool;
+};
+
+#endif // BURSTWRITER_H
@@ -1,52 +1,103 @@
 #include "CameraController.h"
 #include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <tuple>
 
 CameraController::CameraController()
-    : m_camera(std::make_unique<cv::VideoCapture>())
+    : m_source(nullptr)
+    , m_decodeThreads(0)
+    , m_decoder(nullptr)
     , m_initialized(false)
     , m_running(false)
     , m_paused(false)
     , m_currentWidth(640)
     , m_currentHeight(480)
-    , m_cameraIndex(0)
-    , m_bufferIndex(0)
+    , m_pendingMode(0)
+    , m_modeRequestTime(0)
+    , m_lastFrameTime(0)
+    , m_awaitingModeFrame(false)
+    , m_stopRequested(false)
+    , m_captureFailed(false)
+    , m_processedSequence(-1)
+    , m_processedTimestamp(0)
+    , m_frameRing(MAX_BUFFER_SIZE)
+    , m_currentSequence(-1)
+    , m_currentTimestamp(0)
+    , m_lastLiveSequence(-1)
+    , m_reviewing(false)
+    , m_pendingGrabs(0)
+    , m_burstRemaining(0)
+    , m_burstNext(-1)
+    , m_burstEnd(-1)
+    , m_burstActive(false)
+    , m_burstBuffered(false)
+    , m_nextListenerId(1)
+    , m_frameReadyPending(false)
+    , m_frameGeneration(0)
+    , m_imageGeneration(0)
+    , m_displayWidth(0)
+    , m_displayHeight(0)
 {
-    m_frameBuffer.reserve(MAX_BUFFER_SIZE);
 }
 
 CameraController::~CameraController()
 {
     stop();
+    if (m_processing) {
+        m_processing->setOutputCallback(nullptr);
+    }
 }
 
 void CameraController::initialize(int cameraIndex)
+{
+    initialize(std::make_unique<CameraSource>(cameraIndex));
+}
+
+void CameraController::initialize(std::unique_ptr<FrameSource> source, const CaptureMode& mode)
 {
     if (m_initialized) {
         stop();
     }
     
-    m_cameraIndex = cameraIndex;
+    if (!source) {
+        throw CameraException("No frame source given");
+    }
+    
+    // Decode off the capture thread where the source has a native format
+    m_decoder = nullptr;
+    if (m_decodeThreads > 0) {
+        auto decoder = std::make_unique<ParallelDecodeSource>(std::move(source), m_decodeThreads);
+        m_decoder = decoder.get();
+        source = std::move(decoder);
+    }
+    m_source = std::move(source);
     
-    // Try to open the camera
-    if (!m_camera->open(cameraIndex)) {
-        throw CameraException("Failed to open camera with index " + std::to_string(cameraIndex));
+    // Try to open the source
+    if (!m_source->open()) {
+        throw CameraException("Failed to open " + m_source->description());
     }
     
-    // Verify camera is working
+    if (mode.width > 0 && mode.height > 0) {
+        m_source->setResolution(mode.width, mode.height);
+    }
+    
+    // Verify the source is working
     cv::Mat testFrame;
-    if (!m_camera->read(testFrame) || testFrame.empty()) {
-        m_camera->release();
+    if (!m_source->read(testFrame) || testFrame.empty()) {
+        m_source->close();
         throw CameraException("Camera opened but failed to capture test frame");
     }
     
-    // Set initial resolution
-    setResolution(m_currentWidth, m_currentHeight);
+    // Adopt the resolution the source opened with
+    std::tie(m_currentWidth, m_currentHeight) = m_source->resolution();
     
     m_initialized = true;
     m_running = false;
     m_paused = false;
     
-    qDebug() << "Camera initialized successfully with index" << cameraIndex;
+    qDebug() << "Camera initialized successfully:" << QString::fromStdString(m_source->description());
 }
 
 void CameraController::start()
@@ -60,9 +111,23 @@ void CameraController::start()
     m_running = true;
     m_paused = false;
     
-    // Clear frame buffer when starting
-    m_frameBuffer.clear();
-    m_bufferIndex = 0;
+    // Clear frame buffer when starting; slots are allocated once per
+    // session and reused for every captured frame
+    m_currentFrame.release();
+#ifndef QTCAMERA_NO_GUI
+    m_currentImage = QImage();
+#endif
+    ++m_frameGeneration;
+    m_currentSequence = -1;
+    m_lastLiveSequence = -1;
+    m_reviewing = false;
+    m_pendingGrabs = 0;
+    m_metrics.reset();
+    m_frameRing.allocate(m_currentWidth, m_currentHeight, CV_8UC3);
+    m_diskHistory.clear();
+    m_history.start(m_currentWidth, m_currentHeight, CV_8UC3);
+    
+    startCaptureThread();
     
     qDebug() << "Camera started";
 }
@@ -73,16 +138,38 @@ void CameraController::stop()
         return;
     }
     
+    stopCaptureThread();
+    {
+        // A burst cut short keeps writing what it was handed
+        std::lock_guard<std::mutex> lock(m_burstMutex);
+        finishBurst();
+    }
+    m_history.stop();
+    if (m_processing) {
+        m_processing->waitIdle();
+    }
+    
     m_running = false;
     m_paused = false;
     
-    if (m_camera && m_camera->isOpened()) {
-        m_camera->release();
+    if (m_source && m_source->isOpened()) {
+        m_source->close();
     }
     
     m_initialized = false;
-    m_frameBuffer.clear();
-    m_bufferIndex = 0;
+    m_currentFrame.release();
+#ifndef QTCAMERA_NO_GUI
+    m_currentImage = QImage();
+#endif
+    ++m_frameGeneration;
+    m_currentSequence = -1;
+    m_reviewing = false;
+    m_frameRing.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_processedMutex);
+        m_processedFrame.release();
+        m_processedSequence = -1;
+    }
     
     qDebug() << "Camera stopped";
 }
@@ -95,13 +182,13 @@ void CameraController::pause()
         return;
     }
     
-    m_paused = true;
-    
-    // Store the current frame for display during pause
-    if (!m_currentFrame.empty()) {
-        m_pausedFrame = m_currentFrame.clone();
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_paused = true;
     }
     
+    // The frame on screen stays pinned in its slot and the capture thread is
+    // parked, so getCurrentImage keeps returning the cached image
     qDebug() << "Camera paused";
 }
 
@@ -113,7 +200,18 @@ void CameraController::resume()
         return;
     }
     
-    m_paused = false;
+    // Still reviewing history: copy the frame out of its slot so the capture
+    // thread does not stall on the pin once it laps the ring
+    if (m_reviewing && !m_currentFrame.empty()) {
+        m_currentFrame = m_currentFrame.clone();
+        m_frameRing.unpin();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_paused = false;
+    }
+    m_stateChanged.notify_all();
     qDebug() << "Camera resumed";
 }
 
@@ -121,13 +219,79 @@ void CameraController::setResolution(int width, int height)
 {
     validateCamera();
     
-    // Set the resolution
-    m_camera->set(cv::CAP_PROP_FRAME_WIDTH, width);
-    m_camera->set(cv::CAP_PROP_FRAME_HEIGHT, height);
+    if (width <= 0 || height <= 0) {
+        throw CameraException("Invalid resolution");
+    }
+    
+    int64_t requested = PipelineMetrics::now();
+    if (m_running && !m_paused) {
+        // Hand the switch to the capture thread, so it happens between two
+        // reads and the GUI does not wait on the driver
+        m_modeRequestTime = requested;
+        m_pendingMode = (static_cast<uint64_t>(width) << 32) | static_cast<uint32_t>(height);
+        return;
+    }
+    
+    // Stopped, or paused with the capture thread parked: switch right here.
+    // A paused session picks up the new frame size when it resumes.
+    m_pendingMode = 0;
+    applyResolution(width, height);
+    
+    std::lock_guard<std::mutex> lock(m_modeSwitchMutex);
+    m_lastModeSwitch.width = m_currentWidth;
+    m_lastModeSwitch.height = m_currentHeight;
+    m_lastModeSwitch.switchMs = (PipelineMetrics::now() - requested) / 1e6;
+    m_lastModeSwitch.gapMs = 0.0;
+    ++m_lastModeSwitch.count;
+}
+
+CameraController::ModeSwitch CameraController::lastModeSwitch() const
+{
+    std::lock_guard<std::mutex> lock(m_modeSwitchMutex);
+    return m_lastModeSwitch;
+}
+
+void CameraController::applyPendingMode()
+{
+    uint64_t mode = m_pendingMode.exchange(0);
+    if (mode == 0) {
+        return;
+    }
+    
+    // Ring slots and history staging buffers are resized in place as the
+    // first frames of the new size are written into them; older frames in
+    // the history keep their size
+    applyResolution(static_cast<int>(mode >> 32), static_cast<int>(mode & 0xffffffff));
+    m_awaitingModeFrame = true;
+}
+
+void CameraController::finishModeSwitch(int64_t captured)
+{
+    int64_t requested = m_modeRequestTime;
     
-    // Verify the resolution was set
-    int actualWidth = static_cast<int>(m_camera->get(cv::CAP_PROP_FRAME_WIDTH));
-    int actualHeight = static_cast<int>(m_camera->get(cv::CAP_PROP_FRAME_HEIGHT));
+    std::lock_guard<std::mutex> lock(m_modeSwitchMutex);
+    m_lastModeSwitch.width = m_currentWidth;
+    m_lastModeSwitch.height = m_currentHeight;
+    m_lastModeSwitch.switchMs = (captured - requested) / 1e6;
+    m_lastModeSwitch.gapMs = m_lastFrameTime > 0 ? (captured - m_lastFrameTime) / 1e6 : 0.0;
+    ++m_lastModeSwitch.count;
+    
+    qDebug() << "Switched to" << m_lastModeSwitch.width << "x" << m_lastModeSwitch.height << "in"
+             << m_lastModeSwitch.switchMs << "ms," << m_lastModeSwitch.gapMs << "ms between frames";
+}
+
+void CameraController::applyResolution(int width, int height)
+{
+    int actualWidth = 0;
+    int actualHeight = 0;
+    
+    {
+        // The capture thread holds this lock only for the duration of one read
+        std::lock_guard<std::mutex> lock(m_deviceMutex);
+        
+        // Set the resolution; the source reports what it actually applied
+        std::tie(actualWidth, actualHeight) = m_source->setResolution(width, height);
+    }
     
     m_currentWidth = actualWidth;
     m_currentHeight = actualHeight;
@@ -143,125 +307,784 @@ void CameraController::setResolution(int width, int height)
 
 std::pair<int, int> CameraController::getCurrentResolution() const
 {
-    return std::make_pair(m_currentWidth, m_currentHeight);
+    return std::make_pair(m_currentWidth.load(), m_currentHeight.load());
 }
 
-QPixmap CameraController::getCurrentFrame()
+std::vector<CaptureMode> CameraController::probeCaptureModes()
+{
+    validateCamera();
+    
+    if (m_running) {
+        throw CameraException("Cannot probe capture modes while the camera is running");
+    }
+    
+    int64_t probeStart = PipelineMetrics::now();
+    std::vector<CaptureMode> modes = m_source->probeModes();
+    std::tie(m_currentWidth, m_currentHeight) = m_source->resolution();
+    
+    qDebug() << "Probed" << modes.size() << "capture modes of" << QString::fromStdString(m_source->description())
+             << "in" << (PipelineMetrics::now() - probeStart) / 1000000 << "ms";
+    return modes;
+}
+
+std::string CameraController::deviceIdentity() const
+{
+    return m_source ? m_source->identity() : std::string();
+}
+
+void CameraController::setDecodeThreads(int threads)
+{
+    m_decodeThreads = std::max(0, threads);
+}
+
+ParallelDecodeSource::Stats CameraController::decodeStats() const
+{
+    return m_decoder ? m_decoder->stats() : ParallelDecodeSource::Stats();
+}
+
+double CameraController::sourceFps()
+{
+    std::lock_guard<std::mutex> lock(m_deviceMutex);
+    return m_source ? m_source->fps() : 0.0;
+}
+
+#ifndef QTCAMERA_NO_GUI
+QImage CameraController::getCurrentImage()
 {
     validateCamera();
     
     if (!m_running) {
-        return QPixmap(); // Return empty pixmap if not running
+        return QImage();
     }
     
-    if (m_paused) {
-        // Return the paused frame
-        if (!m_pausedFrame.empty()) {
-            return matToQPixmap(m_pausedFrame);
-        }
-        return QPixmap();
+    refreshCurrentFrame();
+    
+    // Scale and convert once per frame, or when the display is resized or
+    // zoomed; only the visible region is read
+    QSize displaySize(m_displayWidth, m_displayHeight);
+    if (m_imageGeneration != m_frameGeneration || m_imageSize != displaySize
+        || m_imageRegion != m_regionOfInterest) {
+        int64_t convertStart = PipelineMetrics::now();
+        m_currentImage = m_converter.toDisplayImage(visibleRegion(), displaySize);
+        m_imageGeneration = m_frameGeneration;
+        m_imageSize = displaySize;
+        m_imageRegion = m_regionOfInterest;
+        m_metrics.record(PipelineMetrics::Convert, PipelineMetrics::now() - convertStart);
+    }
+    return m_currentImage;
+}
+#endif
+
+void CameraController::setDisplaySize(int width, int height)
+{
+    m_displayWidth = width;
+    m_displayHeight = height;
+}
+
+cv::Mat CameraController::getCurrentMat()
+{
+    validateCamera();
+    
+    if (!m_running) {
+        return cv::Mat();
+    }
+    
+    refreshCurrentFrame();
+    return visibleRegion();
+}
+
+void CameraController::setRegionOfInterest(const cv::Rect2d& region)
+{
+    if (region.width <= 0.0 || region.height <= 0.0) {
+        m_regionOfInterest = cv::Rect2d();
+        return;
+    }
+    
+    // Clamp into the frame, keeping the size where possible
+    double width = std::clamp(region.width, 1.0 / MAX_ZOOM, 1.0);
+    double height = std::clamp(region.height, 1.0 / MAX_ZOOM, 1.0);
+    double x = std::clamp(region.x, 0.0, 1.0 - width);
+    double y = std::clamp(region.y, 0.0, 1.0 - height);
+    
+    // The whole frame is no crop at all
+    if (width >= 1.0 && height >= 1.0) {
+        m_regionOfInterest = cv::Rect2d();
+    } else {
+        m_regionOfInterest = cv::Rect2d(x, y, width, height);
+    }
+}
+
+double CameraController::zoomFactor() const
+{
+    return m_regionOfInterest.width > 0.0 ? 1.0 / m_regionOfInterest.width : 1.0;
+}
+
+void CameraController::zoomAt(double factor, double x, double y)
+{
+    cv::Rect2d current = m_regionOfInterest.width > 0.0 ? m_regionOfInterest : cv::Rect2d(0.0, 0.0, 1.0, 1.0);
+    double zoom = std::clamp(zoomFactor() * factor, 1.0, MAX_ZOOM);
+    if (zoom < 1.01) {
+        // Zooming back out by the same steps lands here, give or take rounding
+        setRegionOfInterest(cv::Rect2d());
+        return;
+    }
+    
+    // The frame point under (x, y) stays under it
+    double pointX = current.x + x * current.width;
+    double pointY = current.y + y * current.height;
+    double size = 1.0 / zoom;
+    setRegionOfInterest(cv::Rect2d(pointX - x * size, pointY - y * size, size, size));
+}
+
+cv::Mat CameraController::visibleRegion() const
+{
+    if (m_currentFrame.empty() || m_regionOfInterest.width <= 0.0) {
+        return m_currentFrame;
+    }
+    
+    // Rounded to whole pixels, at least one, inside the frame
+    int x = static_cast<int>(m_regionOfInterest.x * m_currentFrame.cols + 0.5);
+    int y = static_cast<int>(m_regionOfInterest.y * m_currentFrame.rows + 0.5);
+    int width = std::max(1, static_cast<int>(m_regionOfInterest.width * m_currentFrame.cols + 0.5));
+    int height = std::max(1, static_cast<int>(m_regionOfInterest.height * m_currentFrame.rows + 0.5));
+    x = std::clamp(x, 0, m_currentFrame.cols - width);
+    y = std::clamp(y, 0, m_currentFrame.rows - height);
+    return m_currentFrame(cv::Rect(x, y, width, height));
+}
+
+void CameraController::refreshCurrentFrame()
+{
+    // Re-arm the frame-ready notification before looking, so a frame
+    // committed from here on triggers the next one
+    m_frameReadyPending = false;
+    
+    // Paused or reviewing history: keep showing the current frame
+    if (!m_paused && !m_reviewing) {
+        pickUpLatestFrame();
+    }
+}
+
+bool CameraController::pickUpLatestFrame()
+{
+    if (m_captureFailed) {
+        throw CameraException("Failed to read frame from camera");
+    }
+    
+    if (m_processing) {
+        return pickUpProcessedFrame();
+    }
+    
+    // Pick up the newest frame from the capture thread; frames captured
+    // since the last call stay in the history but are not displayed
+    int64_t latest = m_frameRing.latestSequence();
+    if (latest < 0 || latest == m_currentSequence) {
+        return false;
     }
     
-    // Capture new frame
-    cv::Mat frame = captureFrame();
-    if (frame.empty()) {
+    int64_t pickedUp = PipelineMetrics::now();
+    cv::Mat frame;
+    if (!m_frameRing.pin(latest, frame) || frame.empty()) {
         throw CameraException("Failed to capture frame from camera");
     }
     
-    m_currentFrame = frame.clone();
+    // Live frames that were captured but never picked up count as dropped
+    if (m_lastLiveSequence >= 0 && latest - m_lastLiveSequence > 1) {
+        m_metrics.framesDropped(static_cast<uint64_t>(latest - m_lastLiveSequence - 1));
+    }
+    m_lastLiveSequence = latest;
     
-    // Add to frame buffer for forward/rewind functionality
-    if (m_frameBuffer.size() >= MAX_BUFFER_SIZE) {
-        // Remove oldest frame
-        m_frameBuffer.erase(m_frameBuffer.begin());
-        m_bufferIndex = std::max(0, m_bufferIndex - 1);
+    m_currentSequence = latest;
+    m_currentFrame = frame;
+    ++m_frameGeneration;
+    m_currentTimestamp = m_frameRing.timestamp(latest);
+    m_metrics.record(PipelineMetrics::Queue, pickedUp - m_currentTimestamp);
+    return true;
+}
+
+bool CameraController::pickUpProcessedFrame()
+{
+    int64_t pickedUp = PipelineMetrics::now();
+    {
+        std::lock_guard<std::mutex> lock(m_processedMutex);
+        if (m_processedSequence < 0 || m_processedSequence == m_currentSequence) {
+            return false;
+        }
+        // The graph handed the frame over, so sharing it is safe
+        m_currentFrame = m_processedFrame;
+        m_currentSequence = m_processedSequence;
+        m_currentTimestamp = m_processedTimestamp;
+    }
+    ++m_frameGeneration;
+    
+    // Nothing from the ring is on screen now; let the capture thread lap it
+    m_frameRing.unpin();
+    
+    // Frames skipped by the graph or never picked up count as dropped
+    if (m_lastLiveSequence >= 0 && m_currentSequence - m_lastLiveSequence > 1) {
+        m_metrics.framesDropped(static_cast<uint64_t>(m_currentSequence - m_lastLiveSequence - 1));
     }
-    m_frameBuffer.push_back(frame.clone());
-    m_bufferIndex = m_frameBuffer.size() - 1;
+    m_lastLiveSequence = m_currentSequence;
     
-    return matToQPixmap(frame);
+    // Includes the time spent in the graph
+    m_metrics.record(PipelineMetrics::Queue, pickedUp - m_currentTimestamp);
+    return true;
 }
 
 void CameraController::skipFrames(int frameCount)
+{
+    if (frameCount > 0) {
+        stepForward(frameCount);
+    }
+    else if (frameCount < 0) {
+        stepBackward(-frameCount);
+    }
+}
+
+bool CameraController::seekTo(int64_t sequence)
 {
     validateCamera();
     
-    if (frameCount > 0) {
-        // Forward: Skip frames by reading and discarding them
+    if (m_running && sequence >= m_frameRing.latestSequence()) {
+        jumpToLive();
+        return true;
+    }
+    
+    if (!showHistoryFrame(sequence)) {
+        qDebug() << "Cannot seek to frame" << sequence << ": not in history";
+        return false;
+    }
+    
+    m_reviewing = true;
+    return true;
+}
+
+bool CameraController::seekToTime(int64_t timestamp)
+{
+    validateCamera();
+    
+    // Newest frame captured at or before timestamp, searching the tiers from
+    // the most recent down
+    int64_t sequence = -1;
+    int64_t oldest = m_frameRing.oldestSequence();
+    if (oldest >= 0 && m_frameRing.timestamp(oldest) <= timestamp) {
+        int64_t low = oldest;
+        int64_t high = m_frameRing.latestSequence();
+        while (low < high) {
+            int64_t mid = low + (high - low + 1) / 2;
+            if (m_frameRing.timestamp(mid) <= timestamp) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        sequence = low;
+    }
+    if (sequence < 0) {
+        sequence = m_history.sequenceAt(timestamp);
+    }
+    if (sequence < 0) {
+        sequence = m_diskHistory.sequenceAt(timestamp);
+    }
+    if (sequence < 0) {
+        qDebug() << "Cannot seek to time: older than the history";
+        return false;
+    }
+    
+    return seekTo(sequence);
+}
+
+bool CameraController::stepForward(int frameCount)
+{
+    validateCamera();
+    
+    if (frameCount <= 0) {
+        return false;
+    }
+    
+    if (m_reviewing) {
+        // Move back toward live through the history. Lookups resolve to the
+        // frame at or before a sequence, which in a gap the encoder skipped
+        // is the one already on screen, so step to the next frame stored
+        qDebug() << "Stepping" << frameCount << "frames forward in history";
+        int64_t next = nextStoredSequence(m_currentSequence + frameCount);
+        if (next < 0) {
+            if (!m_running) {
+                return false;
+            }
+            jumpToLive();
+            return true;
+        }
+        return seekTo(next);
+    }
+    
+    if (m_running) {
+        // Live: the capture thread grabs and discards the frames, so the GUI
+        // never blocks on the device
+        m_pendingGrabs += frameCount;
+    }
+    else {
+        std::lock_guard<std::mutex> lock(m_deviceMutex);
         for (int i = 0; i < frameCount; ++i) {
-            cv::Mat dummyFrame;
-            if (!m_camera->read(dummyFrame)) {
+            if (!m_source->grab()) {
                 break; // Can't read more frames
             }
         }
-        qDebug() << "Skipped" << frameCount << "frames forward";
     }
-    else if (frameCount < 0) {
-        // Backward: Use frame buffer if available
-        int skipCount = -frameCount;
-        if (!m_frameBuffer.empty() && m_bufferIndex >= skipCount) {
-            m_bufferIndex -= skipCount;
-            m_currentFrame = m_frameBuffer[m_bufferIndex].clone();
-            qDebug() << "Skipped" << skipCount << "frames backward using buffer";
-        }
-        else {
-            qDebug() << "Cannot skip backward: insufficient frame buffer";
-            // Note: For a live camera feed, true backward skipping is not possible
-            // This implementation uses a limited frame buffer
+    qDebug() << "Skipped" << frameCount << "frames forward";
+    return true;
+}
+
+bool CameraController::stepBackward(int frameCount)
+{
+    validateCamera();
+    
+    if (frameCount <= 0 || m_currentSequence < 0) {
+        qDebug() << "Cannot skip backward: insufficient frame buffer";
+        return false;
+    }
+    
+    if (!seekTo(std::max<int64_t>(m_currentSequence - frameCount, oldestSequence()))) {
+        return false;
+    }
+    qDebug() << "Skipped backward to frame" << m_currentSequence;
+    return true;
+}
+
+void CameraController::jumpToLive()
+{
+    validateCamera();
+    
+    m_reviewing = false;
+    m_lastLiveSequence = -1;
+    
+    // While paused the capture thread is parked, so show the newest frame it
+    // captured; otherwise getCurrentImage picks it up on the next call
+    if (m_paused) {
+        showHistoryFrame(m_frameRing.latestSequence());
+    }
+    qDebug() << "Jumped to live";
+}
+
+int64_t CameraController::latestSequence() const
+{
+    return m_frameRing.latestSequence();
+}
+
+int64_t CameraController::oldestSequence() const
+{
+    int64_t oldest = m_frameRing.oldestSequence();
+    CompressedHistory::Stats memory = m_history.stats();
+    if (memory.oldestSequence >= 0 && (oldest < 0 || memory.oldestSequence < oldest)) {
+        oldest = memory.oldestSequence;
+    }
+    int64_t disk = m_diskHistory.oldestSequence();
+    if (disk >= 0 && (oldest < 0 || disk < oldest)) {
+        oldest = disk;
+    }
+    return oldest;
+}
+
+int64_t CameraController::nextStoredSequence(int64_t sequence) const
+{
+    // The ring holds every sequence from its oldest on
+    int64_t ringOldest = m_frameRing.oldestSequence();
+    if (ringOldest >= 0 && sequence >= ringOldest) {
+        return sequence <= m_frameRing.latestSequence() ? sequence : -1;
+    }
+    
+    int64_t next = -1;
+    for (int64_t candidate : {m_history.nextSequence(sequence), m_diskHistory.nextSequence(sequence), ringOldest}) {
+        if (candidate >= 0 && (next < 0 || candidate < next)) {
+            next = candidate;
         }
     }
+    return next;
 }
 
-cv::Mat CameraController::captureFrame()
+bool CameraController::showHistoryFrame(int64_t sequence)
 {
+    if (sequence < 0) {
+        return false;
+    }
+    
+    // Recent frames are still raw in the ring; older ones are decoded from
+    // the compressed history in memory, then from disk
+    int64_t timestamp = 0;
     cv::Mat frame;
+    if (m_frameRing.pin(sequence, frame)) {
+        timestamp = m_frameRing.timestamp(sequence);
+        if (!m_paused) {
+            // Capture is still running; a pinned slot would stall it once it
+            // laps the ring, so keep a copy instead
+            frame = frame.clone();
+            m_frameRing.unpin();
+        }
+    }
+    else if (m_history.decode(sequence, timestamp, frame) ||
+             m_diskHistory.decode(sequence, timestamp, frame)) {
+        // The decoded frame owns its pixels, so no ring slot stays pinned
+        m_frameRing.unpin();
+    }
+    else {
+        return false;
+    }
     
-    if (!m_camera->read(frame)) {
-        throw CameraException("Failed to read frame from camera");
+    m_currentSequence = sequence;
+    m_currentTimestamp = timestamp;
+    m_currentFrame = frame;
+    ++m_frameGeneration;
+    return true;
+}
+
+void CameraController::enableDiskHistory(const std::string& directory, size_t megabytes)
+{
+    if (m_running) {
+        throw CameraException("Cannot change disk history while the camera is running");
     }
     
-    return frame;
+    if (megabytes * 1024 * 1024 < SegmentStore::MIN_BUDGET_BYTES) {
+        throw CameraException("Disk history needs at least " +
+                              std::to_string(SegmentStore::MIN_BUDGET_BYTES / (1024 * 1024)) + " MB, got " +
+                              std::to_string(megabytes) + " MB");
+    }
+    
+    m_history.setArchive(nullptr);
+    if (!m_diskHistory.open(QString::fromStdString(directory), megabytes * 1024 * 1024)) {
+        throw CameraException("Failed to create disk history in " + directory);
+    }
+    m_history.setArchive(&m_diskHistory);
 }
 
-QImage CameraController::matToQImage(const cv::Mat& mat)
+void CameraController::disableDiskHistory()
 {
-    if (mat.empty()) {
-        return QImage();
+    if (m_running) {
+        throw CameraException("Cannot change disk history while the camera is running");
+    }
+    
+    m_history.setArchive(nullptr);
+    m_diskHistory.close();
+}
+
+void CameraController::setChangeThreshold(double threshold)
+{
+    // Picked up by the capture thread on its next frame
+    m_changeDetector.setThreshold(threshold);
+}
+
+void CameraController::setProcessingGraph(std::shared_ptr<FrameGraph> graph)
+{
+    if (m_running) {
+        throw CameraException("Cannot change frame processing while the camera is running");
+    }
+    
+    if (m_processing) {
+        m_processing->setOutputCallback(nullptr);
+    }
+    m_processing = std::move(graph);
+    if (m_processing) {
+        m_processing->setOutputCallback([this](FrameGraph::Output& output) {
+            if (output.frame.empty()) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_processedMutex);
+                m_processedFrame = std::move(output.frame);
+                m_processedSequence = output.sequence;
+                m_processedTimestamp = output.timestamp;
+            }
+            notifyFrameReady();
+        });
+    }
+}
+
+void CameraController::enableSharedFrames(const std::string& name, size_t slots)
+{
+    if (m_running) {
+        throw CameraException("Cannot change shared-memory export while the camera is running");
+    }
+    
+    if (!m_sharedFrames.open(name, slots)) {
+        throw CameraException("Failed to create shared memory " + name);
+    }
+}
+
+void CameraController::disableSharedFrames()
+{
+    if (m_running) {
+        throw CameraException("Cannot change shared-memory export while the camera is running");
+    }
+    
+    m_sharedFrames.close();
+}
+
+int CameraController::addFrameListener(FrameListener listener)
+{
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    int id = m_nextListenerId++;
+    m_frameListeners.emplace_back(id, std::move(listener));
+    return id;
+}
+
+void CameraController::removeFrameListener(int id)
+{
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    m_frameListeners.erase(std::remove_if(m_frameListeners.begin(), m_frameListeners.end(),
+                                          [id](const auto& listener) { return listener.first == id; }),
+                           m_frameListeners.end());
+}
+
+bool CameraController::captureBurst(std::shared_ptr<BurstWriter> writer, int frames)
+{
+    validateCamera();
+    
+    if (!m_running) {
+        throw CameraException("Cannot take a burst while the camera is stopped");
+    }
+    if (!writer) {
+        throw CameraException("No burst writer given");
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_burstMutex);
+        if (m_burst) {
+            return false;
+        }
+        m_burst = std::move(writer);
+        if (frames > 0) {
+            m_burstRemaining = frames;
+            m_burstNext = -1;
+            m_burstEnd = -1;
+        } else {
+            m_burstRemaining = 0;
+            m_burstNext = m_frameRing.oldestSequence();
+            m_burstEnd = m_frameRing.latestSequence() + 1;
+            if (m_burstNext < 0) {
+                m_burst.reset();
+                return true;
+            }
+        }
+        m_burstActive = true;
     }
     
-    switch (mat.type()) {
-        case CV_8UC1: {
-            // Grayscale
-            QImage qimg(mat.data, mat.cols, mat.rows, mat.step, QImage::Format_Grayscale8);
-            return qimg.copy(); // Deep copy
+    if (frames <= 0) {
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            m_burstBuffered = true;
         }
-        case CV_8UC3: {
-            // BGR to RGB
-            cv::Mat rgbMat;
-            cv::cvtColor(mat, rgbMat, cv::COLOR_BGR2RGB);
-            QImage qimg(rgbMat.data, rgbMat.cols, rgbMat.rows, rgbMat.step, QImage::Format_RGB888);
-            return qimg.copy(); // Deep copy
+        m_stateChanged.notify_all();
+    }
+    
+    qDebug() << "Burst of" << (frames > 0 ? QString::number(frames) : QString("buffered")) << "frames started";
+    return true;
+}
+
+void CameraController::continueBurst(const cv::Mat* frame)
+{
+    std::lock_guard<std::mutex> lock(m_burstMutex);
+    if (!m_burst) {
+        return;
+    }
+    
+    if (m_burstNext < 0) {
+        if (frame) {
+            m_burst->push(*frame);
+            if (--m_burstRemaining <= 0) {
+                finishBurst();
+            }
         }
-        case CV_8UC4: {
-            // BGRA to RGBA
-            cv::Mat rgbaMat;
-            cv::cvtColor(mat, rgbaMat, cv::COLOR_BGRA2RGBA);
-            QImage qimg(rgbaMat.data, rgbaMat.cols, rgbaMat.rows, rgbaMat.step, QImage::Format_RGBA8888);
-            return qimg.copy(); // Deep copy
+        return;
+    }
+    
+    // Frames evicted before we got to them are lost; this only happens if
+    // the burst started just as the ring was about to lap
+    int64_t oldest = m_frameRing.oldestSequence();
+    if (m_burstNext < oldest) {
+        qDebug() << "Burst missed" << oldest - m_burstNext << "buffered frames";
+        m_burstNext = oldest;
+    }
+    
+    // Paused, nothing is evicted: take the rest of the buffer at once
+    int count = frame ? BURST_FRAMES_PER_CAPTURE : static_cast<int>(m_burstEnd - m_burstNext);
+    cv::Mat view;
+    for (int i = 0; i < count && m_burstNext < m_burstEnd; ++i, ++m_burstNext) {
+        if (m_frameRing.peek(m_burstNext, view)) {
+            m_burst->push(view);
         }
-        default:
-            qDebug() << "Unsupported cv::Mat format:" << mat.type();
-            return QImage();
     }
+    if (m_burstNext >= m_burstEnd) {
+        finishBurst();
+    }
+}
+
+void CameraController::finishBurst()
+{
+    // Called with m_burstMutex held
+    if (!m_burst) {
+        return;
+    }
+    BurstWriter::Stats stats = m_burst->stats();
+    qDebug() << "Burst handed" << stats.frames << "frames to the writer," << stats.dropped << "dropped";
+    m_burst.reset();
+    m_burstBuffered = false;
+    m_burstActive = false;
+}
+
+void CameraController::setFrameReadyCallback(FrameReadyCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    m_frameReadyCallback = std::move(callback);
+    m_frameReadyPending = false;
 }
 
-QPixmap CameraController::matToQPixmap(const cv::Mat& mat)
+void CameraController::notifyFrameReady()
 {
-    QImage qimg = matToQImage(mat);
-    if (qimg.isNull()) {
-        return QPixmap();
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    if (m_frameReadyCallback && !m_frameReadyPending.exchange(true)) {
+        m_frameReadyCallback();
     }
-    return QPixmap::fromImage(qimg);
+}
+
+void CameraController::setHistoryBudget(size_t megabytes)
+{
+    m_history.setBudget(megabytes * 1024 * 1024);
+    qDebug() << "Rewind history budget set to" << megabytes << "MB";
+}
+
+size_t CameraController::historyBudget() const
+{
+    return m_history.budget() / (1024 * 1024);
+}
+
+void CameraController::startCaptureThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_stopRequested = false;
+    }
+    m_captureFailed = false;
+    m_lastFrameTime = 0;
+    m_awaitingModeFrame = false;
+    m_changeDetector.reset();
+    m_captureThread = std::thread(&CameraController::captureLoop, this);
+}
+
+void CameraController::stopCaptureThread()
+{
+    if (!m_captureThread.joinable()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_stopRequested = true;
+    }
+    m_stateChanged.notify_all();
+    m_captureThread.join();
+}
+
+void CameraController::captureLoop()
+{
+    while (true) {
+        {
+            // Sleep while paused; no frames are read from the device. A
+            // buffer burst requested meanwhile is taken from the ring.
+            std::unique_lock<std::mutex> lock(m_stateMutex);
+            m_stateChanged.wait(lock, [this] { return m_stopRequested || !m_paused || m_burstBuffered; });
+            if (m_stopRequested) {
+                break;
+            }
+        }
+        if (m_paused) {
+            continueBurst(nullptr);
+            continue;
+        }
+        
+        // Resolution change requested while running
+        applyPendingMode();
+        
+        // Forward skips requested by the GUI: advance the device without
+        // decoding the frames
+        int grabs = m_pendingGrabs.exchange(0);
+        if (grabs > 0) {
+            std::lock_guard<std::mutex> lock(m_deviceMutex);
+            for (int i = 0; i < grabs; ++i) {
+                if (!m_source->grab()) {
+                    break;
+                }
+            }
+        }
+        
+        // Read straight into the next history slot, then publish it. If we
+        // have lapped the ring and reached the frame on screen, wait for the
+        // GUI to move on rather than overwrite it.
+        cv::Mat* frame = m_frameRing.beginWrite();
+        if (!frame) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        int64_t readStart = PipelineMetrics::now();
+        if (!captureFrame(*frame)) {
+            m_captureFailed = true;
+            qDebug() << "Capture thread stopped: failed to read frame";
+            // Wake the display so it picks up the failure
+            m_frameReadyPending = false;
+            notifyFrameReady();
+            break;
+        }
+        int64_t captured = PipelineMetrics::now();
+        m_metrics.record(PipelineMetrics::Capture, captured - readStart);
+        m_metrics.frameCaptured(captured);
+        
+        // A frame that adds nothing to a static scene is not committed; its
+        // slot is read into again next time
+        bool changed = m_changeDetector.update(*frame);
+        int64_t sequence = m_frameRing.latestSequence();
+        if (changed) {
+            ++sequence;
+            m_history.push(sequence, captured, *frame);
+            m_frameRing.commitWrite(captured);
+        }
+        if (m_awaitingModeFrame) {
+            m_awaitingModeFrame = false;
+            finishModeSwitch(captured);
+        }
+        m_lastFrameTime = captured;
+        
+        if (m_sharedFrames.isOpen()) {
+            m_sharedFrames.publish(*frame, captured);
+        }
+        
+        // Listeners read the slot in place, so they must be done with it (or
+        // have copied it) when they return: an uncommitted slot is read into
+        // again on the next pass
+        {
+            std::lock_guard<std::mutex> lock(m_listenerMutex);
+            for (const auto& listener : m_frameListeners) {
+                listener.second(*frame, sequence, captured);
+            }
+        }
+        if (m_burstActive) {
+            continueBurst(frame);
+        }
+        
+        // Nothing new to show
+        if (!changed) {
+            continue;
+        }
+        
+        // With processing, the display is woken by the graph's output instead
+        if (m_processing) {
+            m_processing->submit(*frame, sequence, captured);
+        } else {
+            notifyFrameReady();
+        }
+    }
+}
+
+bool CameraController::captureFrame(cv::Mat& frame)
+{
+    std::lock_guard<std::mutex> lock(m_deviceMutex);
+    return m_source->read(frame) && !frame.empty();
 }
 
 void CameraController::validateCamera() const
@@ -270,7 +1093,7 @@ void CameraController::validateCamera() const
         throw CameraException("Camera is not initialized");
     }
     
-    if (!m_camera || !m_camera->isOpened()) {
+    if (!m_source || !m_source->isOpened()) {
         throw CameraException("Camera is not opened");
     }
 } 
\ No newline at end of file
@@ -2,11 +2,33 @@
 #define CAMERACONTROLLER_H
 
 #include <opencv2/opencv.hpp>
-#include <QPixmap>
+#ifndef QTCAMERA_NO_GUI
 #include <QImage>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
 #include <memory>
-#include <vector>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <stdexcept>
+#include <vector>
+
+#include "BurstWriter.h"
+#include "ChangeDetector.h"
+#include "CompressedHistory.h"
+#include "FrameGraph.h"
+#ifndef QTCAMERA_NO_GUI
+#include "FrameConverter.h"
+#endif
+#include "FrameRing.h"
+#include "FrameSource.h"
+#include "ParallelDecodeSource.h"
+#include "PipelineMetrics.h"
+#include "SegmentStore.h"
+#include "SharedFramePublisher.h"
 
 class CameraController
 {
@@ -16,46 +38,292 @@ public:
 
     // Camera lifecycle
     void initialize(int cameraIndex = 0);
+    // A non-empty mode is applied right after opening, before the first
+    // frame is read, so the device is configured only once
+    void initialize(std::unique_ptr<FrameSource> source, const CaptureMode& mode = CaptureMode());
     void start();
     void stop();
     void pause();
     void resume();
     
-    // Camera settings
+    // Camera settings. While running, the capture thread switches the mode
+    // between two reads without releasing the device; capture, history and
+    // listeners carry on, with frames changing size at the switch. The
+    // resolution reported below changes once the switch has happened.
     void setResolution(int width, int height);
     std::pair<int, int> getCurrentResolution() const;
     
-    // Frame operations
-    QPixmap getCurrentFrame();
+    struct ModeSwitch {
+        int width = 0;
+        int height = 0;
+        double switchMs = 0.0;  // requested until the first frame in the new mode
+        double gapMs = 0.0;     // last frame before until first frame after
+        uint64_t count = 0;     // switches completed so far
+    };
+    ModeSwitch lastModeSwitch() const;
+    
+    // Capture in the device's native format (MJPEG, YUYV) and decode on
+    // threads workers in capture order, instead of letting OpenCV convert
+    // each frame inside read() on the capture thread (see
+    // ParallelDecodeSource). 0 turns it off. Takes effect at the next
+    // initialize().
+    void setDecodeThreads(int threads);
+    int decodeThreads() const { return m_decodeThreads; }
+    ParallelDecodeSource::Stats decodeStats() const;
+    
+    // Modes the device supports, found by switching through them; slow on
+    // real cameras. Only while stopped.
+    std::vector<CaptureMode> probeCaptureModes();
+    std::string deviceIdentity() const;
+    
+    // Frame rate the source reports, 0 if unknown
+    double sourceFps();
+    
+    // Frame operations. Nothing here needs a GUI application, so the
+    // controller also runs under QCoreApplication (headless mode). Built
+    // with QTCAMERA_NO_GUI, it does without Qt Gui altogether and has no
+    // display conversion.
+    
+#ifndef QTCAMERA_NO_GUI
+    // Current frame as an RGB32 image scaled to the display size, ready to
+    // be painted 1:1, or at full size if no display size is set. Converted
+    // once per frame.
+    QImage getCurrentImage();
+#endif
+    void setDisplaySize(int width, int height);
+    
+    // Same frame as a BGR cv::Mat without conversion, for compositing. The
+    // view stays valid until the next call on this controller.
+    cv::Mat getCurrentMat();
+    
+    // Digital zoom: the two calls above return only this region of the
+    // frame, given in fractions of the frame size (0-1) so it survives
+    // resolution switches. The crop is a view into the frame taken before
+    // any conversion or copy, so their cost scales with the visible area
+    // rather than the sensor size. Capture, history, processing, recording
+    // and streaming still get the full frame. An empty region shows all of
+    // it. Not applied on the device: OpenCV has no portable crop control.
+    void setRegionOfInterest(const cv::Rect2d& region);
+    cv::Rect2d regionOfInterest() const { return m_regionOfInterest; }
+    double zoomFactor() const;
+    
+    // Multiply the zoom by factor (1 is the whole frame, at most MAX_ZOOM),
+    // keeping the point at (x, y) of the visible region, in fractions, in place
+    void zoomAt(double factor, double x = 0.5, double y = 0.5);
+    static constexpr double MAX_ZOOM = 16.0;
     void skipFrames(int frameCount);
     
+    // Timeline navigation. Frames are addressed by sequence number (counting
+    // from 0 at start()) or capture timestamp in PipelineMetrics::now() units.
+    // Seeking into history freezes the display on that frame until
+    // jumpToLive(); capture carries on unless paused.
+    bool seekTo(int64_t sequence);
+    bool seekToTime(int64_t timestamp);
+    bool stepForward(int frameCount = 1);
+    bool stepBackward(int frameCount = 1);
+    void jumpToLive();
+    bool isLive() const { return !m_reviewing; }
+    int64_t latestSequence() const;
+    int64_t oldestSequence() const;
+    
+    // Rewind history beyond the raw frame buffer, stored compressed
+    void setHistoryBudget(size_t megabytes);
+    size_t historyBudget() const;
+    CompressedHistory::Stats historyStats() const { return m_history.stats(); }
+    
+    // Keep history on disk as well, for rewinds beyond the memory budget.
+    // Only while stopped; the files are removed when disabled.
+    void enableDiskHistory(const std::string& directory, size_t megabytes);
+    void disableDiskHistory();
+    SegmentStore::Stats diskHistoryStats() const { return m_diskHistory.stats(); }
+    
+    // Publish every captured frame into a named shared-memory ring for other
+    // local processes (see SharedFrameReader). Only while stopped.
+    void enableSharedFrames(const std::string& name, size_t slots = SharedFramePublisher::DEFAULT_SLOTS);
+    void disableSharedFrames();
+    SharedFramePublisher::Stats sharedFrameStats() const { return m_sharedFrames.stats(); }
+    
+    // Run live frames through a processing graph before display. The capture
+    // thread submits each frame and the display shows the graph's output, in
+    // order; frames the graph has no room for are dropped. Rewinding shows
+    // the unprocessed history. Only while stopped; nullptr turns it off.
+    void setProcessingGraph(std::shared_ptr<FrameGraph> graph);
+    std::shared_ptr<FrameGraph> processingGraph() const { return m_processing; }
+    
+    // Skip frames of a static scene: a frame that differs from the last one
+    // kept by no more than threshold grey levels (see ChangeDetector) is not
+    // added to the history, processed or shown, so it costs no conversion
+    // or repaint. Frame listeners and shared memory still get every frame.
+    // 0 turns detection off.
+    void setChangeThreshold(double threshold);
+    double changeThreshold() const { return m_changeDetector.threshold(); }
+    ChangeDetector::Stats changeStats() const { return m_changeDetector.stats(); }
+    
+#ifndef QTCAMERA_NO_GUI
+    // Bytes copied by frame conversion, for checking the display path cost
+    FrameConverter::Stats conversionStats() const { return m_converter.stats(); }
+#endif
+    
+    // Per-stage timing; the display side records Paint and EndToEnd itself
+    PipelineMetrics& metrics() { return m_metrics; }
+    int64_t currentSequence() const { return m_currentSequence; }
+    int64_t currentFrameTimestamp() const { return m_currentTimestamp; }
+    
+    // Save full-resolution snapshots through writer (see BurstWriter): the
+    // next frames captured, or with frames <= 0 every frame currently in
+    // the raw frame buffer. The capture thread hands the frames over as it
+    // goes and the writer encodes them on its own threads, so the live
+    // display carries on. A buffer burst also runs while paused. False if a
+    // burst is still being taken; throws if not running.
+    bool captureBurst(std::shared_ptr<BurstWriter> writer, int frames = 0);
+    bool isBurstActive() const { return m_burstActive; }
+    
+    // Called on the capture thread with every captured frame, sequence and
+    // timestamp. The frame is only valid during the call; copy what you keep
+    // and return quickly, since capture waits for listeners. The sequence is
+    // the rewind history's and only advances on frames it keeps: frames
+    // skipped as unchanged repeat the sequence of the last frame kept, even
+    // though their pixels differ. Use the timestamp to tell frames apart.
+    using FrameListener = std::function<void(const cv::Mat&, int64_t, int64_t)>;
+    int addFrameListener(FrameListener listener);
+    void removeFrameListener(int id);
+    
+    // Called on the capture thread when a new frame is ready, or capture has
+    // failed. At most one notification is outstanding: the next is only sent
+    // once the display has asked for a frame, so a slow display skips to the
+    // newest frame instead of falling behind. Post to the GUI thread from it.
+    using FrameReadyCallback = std::function<void()>;
+    void setFrameReadyCallback(FrameReadyCallback callback);
+    
     // State queries
     bool isInitialized() const { return m_initialized; }
     bool isRunning() const { return m_running; }
     bool isPaused() const { return m_paused; }
 
 private:
-    cv::Mat captureFrame();
-    QImage matToQImage(const cv::Mat& mat);
-    QPixmap matToQPixmap(const cv::Mat& mat);
+    // Capture thread
+    void startCaptureThread();
+    void stopCaptureThread();
+    void captureLoop();
+
+    void applyResolution(int width, int height);
+    void applyPendingMode();
+    void finishModeSwitch(int64_t captured);
+    void refreshCurrentFrame();
+    bool pickUpLatestFrame();
+    bool pickUpProcessedFrame();
+    void notifyFrameReady();
+    void continueBurst(const cv::Mat* frame);
+    void finishBurst();
+    bool showHistoryFrame(int64_t sequence);
+    int64_t nextStoredSequence(int64_t sequence) const;
+
+    bool captureFrame(cv::Mat& frame);
+    cv::Mat visibleRegion() const;
     void validateCamera() const;
 
-    std::unique_ptr<cv::VideoCapture> m_camera;
+    std::unique_ptr<FrameSource> m_source;
+    std::atomic<int> m_decodeThreads;
+    ParallelDecodeSource* m_decoder;    // m_source when decoding in parallel
     cv::Mat m_currentFrame;
-    cv::Mat m_pausedFrame;
+#ifndef QTCAMERA_NO_GUI
+    QImage m_currentImage;
+    FrameConverter m_converter;
+#endif
+    PipelineMetrics m_metrics;
+    
+    // Set last by initialize(), which may run on another thread
+    std::atomic<bool> m_initialized;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_paused;
+    
+    // Capture thread state. The device is shared between the capture thread
+    // and control calls (setResolution, stop), so access goes through
+    // m_deviceMutex; frames cross the thread boundary lock-free.
+    std::thread m_captureThread;
+    std::mutex m_deviceMutex;
+    std::mutex m_stateMutex;
+    std::condition_variable m_stateChanged;
+    bool m_stopRequested;
+    std::atomic<bool> m_captureFailed;
+    
+    std::atomic<int> m_currentWidth;
+    std::atomic<int> m_currentHeight;
     
-    bool m_initialized;
-    bool m_running;
-    bool m_paused;
+    // Mode switch requested from a control call, packed as width << 32 |
+    // height (0 if none) for the capture thread to apply
+    std::atomic<uint64_t> m_pendingMode;
+    std::atomic<int64_t> m_modeRequestTime;
+    int64_t m_lastFrameTime;
+    bool m_awaitingModeFrame;
+    mutable std::mutex m_modeSwitchMutex;
+    ModeSwitch m_lastModeSwitch;
     
-    int m_currentWidth;
-    int m_currentHeight;
-    int m_cameraIndex;
+    // Newest output of the processing graph, written from its pool threads
+    std::shared_ptr<FrameGraph> m_processing;
+    std::mutex m_processedMutex;
+    cv::Mat m_processedFrame;
+    int64_t m_processedSequence;
+    int64_t m_processedTimestamp;
+    
+    // Capture thread only, apart from the threshold and stats
+    ChangeDetector m_changeDetector;
+    
+    // Frame export to other local processes
+    SharedFramePublisher m_sharedFrames;
+    
+    // Frame buffer for forward/rewind functionality. The capture thread
+    // writes into preallocated slots; m_currentFrame is a view into the slot
+    // identified by m_currentSequence, which stays pinned while displayed.
+    // Only the most recent frames are kept raw; m_history holds older ones
+    // compressed and is decoded only when rewinding past the raw buffer.
+    static const int MAX_BUFFER_SIZE = 30;
+    FrameRing m_frameRing;
+    SegmentStore m_diskHistory;
+    CompressedHistory m_history;
+    int64_t m_currentSequence;
+    int64_t m_currentTimestamp;
+    int64_t m_lastLiveSequence;
+    
+    // Showing a history frame rather than following live capture
+    bool m_reviewing;
+    
+    // Forward skips for the capture thread to apply with grab()
+    std::atomic<int> m_pendingGrabs;
+    
+    // Burst being taken, advanced by the capture thread. A buffer burst
+    // walks m_burstNext up to m_burstEnd a few frames per captured frame,
+    // which stays ahead of the ring evicting one; a live burst takes the
+    // next m_burstRemaining frames.
+    static const int BURST_FRAMES_PER_CAPTURE = 3;
+    std::mutex m_burstMutex;
+    std::shared_ptr<BurstWriter> m_burst;
+    int m_burstRemaining;
+    int64_t m_burstNext;
+    int64_t m_burstEnd;
+    std::atomic<bool> m_burstActive;
+    std::atomic<bool> m_burstBuffered;   // wakes a paused capture thread
+    
+    // Frame taps on the capture thread (recording, streaming)
+    std::mutex m_listenerMutex;
+    std::vector<std::pair<int, FrameListener>> m_frameListeners;
+    int m_nextListenerId;
+    FrameReadyCallback m_frameReadyCallback;
+    std::atomic<bool> m_frameReadyPending;
+
+    // Bumped whenever m_currentFrame changes; the display caches record the
+    // generation they were converted from
+    uint64_t m_frameGeneration;
+    uint64_t m_imageGeneration;
+#ifndef QTCAMERA_NO_GUI
+    QSize m_imageSize;
+#endif
+    cv::Rect2d m_imageRegion;
+    int m_displayWidth;
+    int m_displayHeight;
     
-    // Frame buffer for forward/rewind functionality
-    std::vector<cv::Mat> m_frameBuffer;
-    int m_bufferIndex;
-    static const int MAX_BUFFER_SIZE = 100;
+    // Digital zoom, on the display side only
+    cv::Rect2d m_regionOfInterest;
 };
 
 // Custom exception for camera errors
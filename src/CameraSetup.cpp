@@ -0,0 +1,173 @@
+#include "CameraSetup.h"
+#include "FrameGraph.h"
+#include "ProcessingStage.h"
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+
+QString setUpDiskHistory(const CameraList& cameras, const QString& directory, int megabytes)
+{
+    try {
+        size_t count = cameras.size();
+        for (size_t i = 0; i < count; ++i) {
+            QString path = count > 1 ? QString("%1/cam%2").arg(directory).arg(i) : directory;
+            cameras[i]->enableDiskHistory(path.toStdString(), static_cast<size_t>(std::max(0, megabytes)) / count);
+        }
+    }
+    catch (const std::exception& e) {
+        return QString("Failed to enable disk history: %1").arg(e.what());
+    }
+    return QString();
+}
+
+QString setUpSharedFrames(const CameraList& cameras, const QString& name)
+{
+    try {
+        size_t count = cameras.size();
+        for (size_t i = 0; i < count; ++i) {
+            QString ringName = count > 1 ? QString("%1-cam%2").arg(name).arg(i) : name;
+            cameras[i]->enableSharedFrames(ringName.toStdString());
+        }
+    }
+    catch (const std::exception& e) {
+        return QString("Failed to enable shared-memory export: %1").arg(e.what());
+    }
+    return QString();
+}
+
+QString setUpProcessing(const CameraList& cameras, const QString& chain)
+{
+    QStringList specs = chain.split(',', Qt::SkipEmptyParts);
+
+    // Check every stage before any camera is changed
+    for (const QString& spec : specs) {
+        if (!createProcessingStage(spec.trimmed().toStdString())) {
+            return QString("Unknown processing stage '%1'").arg(spec);
+        }
+    }
+
+    size_t count = std::max<size_t>(1, cameras.size());
+    int threads = std::max(1, QThread::idealThreadCount() / static_cast<int>(count));
+    try {
+        for (const auto& camera : cameras) {
+            std::shared_ptr<FrameGraph> graph;
+            if (!specs.isEmpty()) {
+                graph = std::make_shared<FrameGraph>(threads);
+                for (const QString& spec : specs) {
+                    graph->addStage(createProcessingStage(spec.trimmed().toStdString()));
+                }
+            }
+            camera->setProcessingGraph(graph);
+        }
+    }
+    catch (const std::exception& e) {
+        return QString("Failed to set up frame processing: %1").arg(e.what());
+    }
+    return QString();
+}
+
+QString startRecorders(const CameraList& cameras, const RecordingOptions& options,
+                       std::vector<std::unique_ptr<Recorder>>& recorders, std::vector<int>& listeners,
+                       QStringList& files)
+{
+    QString directory = options.directory;
+    if (directory.isEmpty()) {
+        directory = QStandardPaths::writableLocation(QStandardPaths::MoviesLocation);
+    }
+    QDir().mkpath(directory);
+    QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+
+    for (size_t i = 0; i < cameras.size(); ++i) {
+        CameraController& camera = *cameras[i];
+        QString name = cameras.size() > 1
+            ? QString("recording-%1-cam%2.avi").arg(stamp).arg(i)
+            : QString("recording-%1.avi").arg(stamp);
+        QString path = QDir(directory).filePath(name);
+
+        // Record at the rate the camera is actually delivering; right after
+        // start nothing has been measured, so fall back to the nominal rate
+        double fps = camera.metrics().snapshot().captureFps;
+        if (fps <= 1.0) {
+            fps = camera.sourceFps();
+        }
+        auto resolution = camera.getCurrentResolution();
+
+        auto recorder = std::make_unique<Recorder>(static_cast<size_t>(std::max(1, options.queueFrames)),
+                                                   options.policy);
+        if (!recorder->start(path.toStdString(), fps > 1.0 ? fps : 30.0,
+                             cv::Size(resolution.first, resolution.second))) {
+            stopRecorders(cameras, recorders, listeners);
+            return QString("Failed to start recording to %1").arg(path);
+        }
+
+        Recorder* target = recorder.get();
+        recorders.push_back(std::move(recorder));
+        listeners.push_back(camera.addFrameListener(
+            [target](const cv::Mat& frame, int64_t, int64_t) { target->push(frame); }));
+        files << path;
+    }
+    return QString();
+}
+
+void stopRecorders(const CameraList& cameras, std::vector<std::unique_ptr<Recorder>>& recorders,
+                   std::vector<int>& listeners)
+{
+    // Detach from capture first so nothing is pushed into a stopped recorder
+    for (size_t i = 0; i < listeners.size(); ++i) {
+        cameras[i]->removeFrameListener(listeners[i]);
+    }
+    listeners.clear();
+    for (auto& recorder : recorders) {
+        recorder->stop();
+    }
+    recorders.clear();
+}
+
+QString startBursts(const CameraList& cameras, const QString& directory, BurstWriter::Format format, int frames,
+                    std::vector<std::shared_ptr<BurstWriter>>& writers, QString& savedTo)
+{
+    savedTo = directory;
+    if (savedTo.isEmpty()) {
+        savedTo = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
+    }
+    QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+
+    // The cameras burst at the same time, so each writer gets a share
+    if (writers.empty()) {
+        int threads = std::max(1, QThread::idealThreadCount() / static_cast<int>(std::max<size_t>(1, cameras.size())));
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            writers.push_back(std::make_shared<BurstWriter>(threads));
+        }
+    }
+
+    // begin() resets a writer, which must not happen under a running burst
+    for (const auto& camera : cameras) {
+        if (camera->isBurstActive()) {
+            return QString("A burst is still being taken");
+        }
+    }
+
+    try {
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            CameraController& camera = *cameras[i];
+            if (!camera.isRunning()) {
+                continue;
+            }
+            QString prefix = cameras.size() > 1
+                ? QString("burst-%1-cam%2").arg(stamp).arg(i)
+                : QString("burst-%1").arg(stamp);
+            if (!writers[i]->begin(savedTo.toStdString(), prefix.toStdString(), format)) {
+                return QString("Cannot save snapshots to %1").arg(savedTo);
+            }
+            if (!camera.captureBurst(writers[i], frames)) {
+                return QString("A burst is still being taken");
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        return QString("Failed to start burst: %1").arg(e.what());
+    }
+    return QString();
+}
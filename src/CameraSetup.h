@@ -0,0 +1,61 @@
+#ifndef CAMERASETUP_H
+#define CAMERASETUP_H
+
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+#include "BurstWriter.h"
+#include "CameraController.h"
+#include "Recorder.h"
+
+// Per-camera setup shared by MainWindow and HeadlessSession, so both front
+// ends split budgets and name directories, rings, recordings and bursts the
+// same way. Each function returns an empty string on success, or the error
+// for the caller to report.
+
+using CameraList = std::vector<std::unique_ptr<CameraController>>;
+
+// Disk rewind history in directory, up to megabytes in all. Several cameras
+// each get a subdirectory cam<N> and an equal share.
+QString setUpDiskHistory(const CameraList& cameras, const QString& directory, int megabytes);
+
+// Shared-memory export under name. Several cameras each get their own ring,
+// named <name>-cam<N>.
+QString setUpSharedFrames(const CameraList& cameras, const QString& name);
+
+// Processing chain such as "resize:1280x720,denoise,overlay"; empty turns
+// processing off. Each camera gets its own graph, since stages such as
+// temporal denoise keep per-stream state, and the cores are shared out
+// between them.
+QString setUpProcessing(const CameraList& cameras, const QString& chain);
+
+struct RecordingOptions {
+    QString directory;      // empty for the user's Movies folder
+    int queueFrames = 30;
+    Recorder::DropPolicy policy = Recorder::DropPolicy::DropOldest;
+};
+
+// Record every camera to recording-<stamp>[-cam<N>].avi, at the rate it is
+// measured to deliver or else its nominal rate. Recorders and their frame
+// listeners are appended to recorders and listeners, the files written to
+// files. On failure whatever was started is stopped again.
+QString startRecorders(const CameraList& cameras, const RecordingOptions& options,
+                       std::vector<std::unique_ptr<Recorder>>& recorders, std::vector<int>& listeners,
+                       QStringList& files);
+
+// Detach the listeners, then stop and drop the recorders
+void stopRecorders(const CameraList& cameras, std::vector<std::unique_ptr<Recorder>>& recorders,
+                   std::vector<int>& listeners);
+
+// Save a burst of the next frames from every running camera, or with
+// frames <= 0 of the frames buffered, to burst-<stamp>[-cam<N>]-NNNN.<ext>
+// in directory (empty for the user's Pictures folder). writers holds one
+// per camera and is filled on first use, sharing the cores between the
+// cameras. savedTo is set to the directory actually used. Fails without
+// touching the writers while any camera is still taking a burst.
+QString startBursts(const CameraList& cameras, const QString& directory, BurstWriter::Format format, int frames,
+                    std::vector<std::shared_ptr<BurstWriter>>& writers, QString& savedTo);
+
+#endif // CAMERASETUP_H
@@ -0,0 +1,112 @@
+#include "ChangeDetector.h"
+#include "PipelineMetrics.h"
+#include <algorithm>
+#include <cstdlib>
+
+ChangeDetector::ChangeDetector(double threshold)
+    : m_threshold(threshold)
+    , m_referenceType(-1)
+    , m_hasReference(false)
+    , m_tileSums(GRID_COLUMNS * GRID_ROWS)
+    , m_tileCounts(GRID_COLUMNS * GRID_ROWS)
+    , m_frames(0)
+    , m_unchanged(0)
+    , m_lastDifference(0.0)
+    , m_detectNs(0)
+{
+}
+
+void ChangeDetector::setThreshold(double threshold)
+{
+    m_threshold = std::max(0.0, threshold);
+}
+
+bool ChangeDetector::update(const cv::Mat& frame)
+{
+    if (m_threshold <= 0.0 || frame.empty() || frame.depth() != CV_8U) {
+        m_hasReference = false;
+        return true;
+    }
+
+    int64_t start = PipelineMetrics::now();
+    bool comparable = m_hasReference && frame.size() == m_referenceSize && frame.type() == m_referenceType;
+    sample(frame);
+
+    double difference = 0.0;
+    if (comparable) {
+        for (size_t tile = 0; tile < m_tileSums.size(); ++tile) {
+            if (m_tileCounts[tile] > 0) {
+                difference = std::max(difference, static_cast<double>(m_tileSums[tile]) / m_tileCounts[tile]);
+            }
+        }
+    }
+
+    bool changed = !comparable || difference > m_threshold;
+    if (changed) {
+        std::swap(m_reference, m_current);
+        m_referenceSize = frame.size();
+        m_referenceType = frame.type();
+        m_hasReference = true;
+    } else {
+        ++m_unchanged;
+    }
+
+    ++m_frames;
+    m_lastDifference = difference;
+    m_detectNs += PipelineMetrics::now() - start;
+    return changed;
+}
+
+void ChangeDetector::reset()
+{
+    m_hasReference = false;
+}
+
+ChangeDetector::Stats ChangeDetector::stats() const
+{
+    Stats stats;
+    stats.frames = m_frames;
+    stats.unchanged = m_unchanged;
+    stats.lastDifference = m_lastDifference;
+    stats.detectMs = stats.frames > 0 ? m_detectNs / 1e6 / stats.frames : 0.0;
+    return stats;
+}
+
+void ChangeDetector::sample(const cv::Mat& frame)
+{
+    int columns = (frame.cols + SAMPLE_STEP - 1) / SAMPLE_STEP;
+    int rows = (frame.rows + SAMPLE_STEP - 1) / SAMPLE_STEP;
+    int channels = frame.channels();
+    m_current.resize(static_cast<size_t>(columns) * rows);
+    std::fill(m_tileSums.begin(), m_tileSums.end(), 0);
+    std::fill(m_tileCounts.begin(), m_tileCounts.end(), 0);
+
+    // Tile column of each sample column, so the inner loop does no division
+    if (static_cast<int>(m_columnTiles.size()) != columns) {
+        m_columnTiles.resize(columns);
+        for (int x = 0; x < columns; ++x) {
+            m_columnTiles[x] = x * GRID_COLUMNS / columns;
+        }
+    }
+
+    // The reference has the same layout whenever it is comparable at all
+    bool compare = m_reference.size() == m_current.size();
+    for (int y = 0; y < rows; ++y) {
+        const uchar* pixels = frame.ptr(y * SAMPLE_STEP);
+        uint8_t* current = &m_current[static_cast<size_t>(y) * columns];
+        const uint8_t* reference = compare ? &m_reference[static_cast<size_t>(y) * columns] : nullptr;
+        int tileRow = y * GRID_ROWS / rows * GRID_COLUMNS;
+
+        for (int x = 0; x < columns; ++x) {
+            const uchar* pixel = pixels + x * SAMPLE_STEP * channels;
+            // Approximate luma from BGR(A); grey frames are used as they are
+            uint8_t luma = channels >= 3 ? static_cast<uint8_t>((pixel[0] + 2 * pixel[1] + pixel[2]) >> 2) : pixel[0];
+            current[x] = luma;
+            if (reference) {
+                int tile = tileRow + m_columnTiles[x];
+                m_tileSums[tile] += static_cast<uint32_t>(std::abs(luma - reference[x]));
+                ++m_tileCounts[tile];
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef CHANGEDETECTOR_H
+#define CHANGEDETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Cheap test for whether a frame differs visibly from the last one kept.
+//
+// Every 4th pixel of every 4th row is reduced to luma and compared with the
+// same sample of the reference frame, summing absolute differences per tile
+// of a 16x9 grid. A frame counts as changed if any tile's mean difference
+// exceeds the threshold, so a small moving object is not averaged away by a
+// large static background. Changed frames become the new reference; the
+// reference is not advanced by unchanged ones, so slow drift such as
+// daylight still triggers once it adds up. Reads 1/16 of the pixels.
+class ChangeDetector
+{
+public:
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t unchanged = 0;
+        double lastDifference = 0.0;    // largest tile difference, grey levels
+        double detectMs = 0.0;          // mean per frame
+    };
+
+    // Threshold in grey levels (0-255) of mean absolute difference per tile;
+    // 0 disables detection and every frame counts as changed
+    explicit ChangeDetector(double threshold = 0.0);
+
+    void setThreshold(double threshold);
+    double threshold() const { return m_threshold; }
+
+    // True if frame differs from the reference, in which case it becomes the
+    // new reference. Always true while disabled, for the first frame and
+    // after a change of size or format. One thread at a time.
+    bool update(const cv::Mat& frame);
+
+    // Forget the reference; the next frame counts as changed
+    void reset();
+
+    Stats stats() const;
+
+    static const int GRID_COLUMNS = 16;
+    static const int GRID_ROWS = 9;
+    static const int SAMPLE_STEP = 4;
+
+private:
+    void sample(const cv::Mat& frame);
+
+    std::atomic<double> m_threshold;
+    std::vector<uint8_t> m_reference;
+    std::vector<uint8_t> m_current;
+    cv::Size m_referenceSize;
+    int m_referenceType;
+    bool m_hasReference;
+    std::vector<uint32_t> m_tileSums;
+    std::vector<uint32_t> m_tileCounts;
+    std::vector<int> m_columnTiles;
+
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_unchanged;
+    std::atomic<double> m_lastDifference;
+    std::atomic<int64_t> m_detectNs;
+};
+
+#endif // CHANGEDETECTOR_H
@@ -0,0 +1,242 @@
+#include "CompressedHistory.h"
+#include "FrameAllocator.h"
+#include "SegmentStore.h"
+#include <opencv2/imgcodecs.hpp>
+#include <QDebug>
+#include <algorithm>
+#include <iterator>
+
+CompressedHistory::CompressedHistory(size_t budgetBytes)
+    : m_bytes(0)
+    , m_budget(budgetBytes)
+    , m_encoded(0)
+    , m_skipped(0)
+    , m_stopRequested(false)
+    , m_quality(90)
+    , m_archive(nullptr)
+{
+}
+
+CompressedHistory::~CompressedHistory()
+{
+    stop();
+}
+
+void CompressedHistory::setBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    m_budget = bytes;
+    evictLocked();
+}
+
+size_t CompressedHistory::budget() const
+{
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    return m_budget;
+}
+
+void CompressedHistory::setQuality(int quality)
+{
+    std::lock_guard<std::mutex> lock(m_stagingMutex);
+    m_quality = std::clamp(quality, 1, 100);
+}
+
+void CompressedHistory::start(int width, int height, int type)
+{
+    stop();
+
+    {
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        m_entries.clear();
+        m_spareBuffers.clear();
+        m_bytes = 0;
+        m_encoded = 0;
+        m_skipped = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_stagingMutex);
+        m_slots.resize(STAGING_SLOTS);
+        m_freeSlots.clear();
+        for (int i = 0; i < STAGING_SLOTS; ++i) {
+            FrameAllocator::use(m_slots[i]);
+            m_slots[i].create(height, width, type);
+            m_freeSlots.push_back(i);
+        }
+        m_pending.clear();
+        m_stopRequested = false;
+    }
+
+    m_encodeThread = std::thread(&CompressedHistory::encodeLoop, this);
+}
+
+void CompressedHistory::stop()
+{
+    if (!m_encodeThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_stagingMutex);
+        m_stopRequested = true;
+    }
+    m_staged.notify_all();
+    m_encodeThread.join();
+}
+
+bool CompressedHistory::push(int64_t sequence, int64_t timestamp, const cv::Mat& frame)
+{
+    int slot;
+    {
+        std::lock_guard<std::mutex> lock(m_stagingMutex);
+        if (m_freeSlots.empty() || m_stopRequested) {
+            ++m_skipped;
+            return false;
+        }
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+
+    // The slot is ours until it is queued; copy outside the lock. copyTo
+    // reallocates only if the source changed size.
+    frame.copyTo(m_slots[slot]);
+
+    {
+        std::lock_guard<std::mutex> lock(m_stagingMutex);
+        m_pending.push_back({sequence, timestamp, slot});
+    }
+    m_staged.notify_one();
+    return true;
+}
+
+bool CompressedHistory::decode(int64_t& sequence, int64_t& timestamp, cv::Mat& frame) const
+{
+    std::vector<uchar> data;
+    {
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        auto it = std::upper_bound(m_entries.begin(), m_entries.end(), sequence,
+                                   [](int64_t value, const Entry& entry) { return value < entry.sequence; });
+        if (it == m_entries.begin()) {
+            return false;
+        }
+        --it;
+        sequence = it->sequence;
+        timestamp = it->timestamp;
+        data = it->data;
+    }
+
+    // Decode outside the lock so the encoder is not held up
+    frame = cv::imdecode(data, cv::IMREAD_UNCHANGED);
+    return !frame.empty();
+}
+
+int64_t CompressedHistory::sequenceAt(int64_t timestamp) const
+{
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), timestamp,
+                               [](int64_t value, const Entry& entry) { return value < entry.timestamp; });
+    if (it == m_entries.begin()) {
+        return -1;
+    }
+    return std::prev(it)->sequence;
+}
+
+int64_t CompressedHistory::nextSequence(int64_t sequence) const
+{
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), sequence,
+                               [](const Entry& entry, int64_t value) { return entry.sequence < value; });
+    if (it == m_entries.end()) {
+        return -1;
+    }
+    return it->sequence;
+}
+
+CompressedHistory::Stats CompressedHistory::stats() const
+{
+    Stats stats;
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    stats.bytes = m_bytes;
+    stats.frames = m_entries.size();
+    stats.encoded = m_encoded;
+    stats.skipped = m_skipped;
+    if (!m_entries.empty()) {
+        stats.oldestSequence = m_entries.front().sequence;
+        stats.latestSequence = m_entries.back().sequence;
+        stats.secondsCovered = (m_entries.back().timestamp - m_entries.front().timestamp) / 1e9;
+    }
+    return stats;
+}
+
+void CompressedHistory::encodeLoop()
+{
+    std::vector<uchar> buffer;
+
+    while (true) {
+        StagedFrame staged;
+        int quality;
+        {
+            std::unique_lock<std::mutex> lock(m_stagingMutex);
+            m_staged.wait(lock, [this] { return m_stopRequested || !m_pending.empty(); });
+            if (m_stopRequested) {
+                break;
+            }
+            staged = m_pending.front();
+            m_pending.pop_front();
+            quality = m_quality;
+        }
+
+        bool encoded = cv::imencode(".jpg", m_slots[staged.slot], buffer,
+                                    {cv::IMWRITE_JPEG_QUALITY, quality});
+
+        {
+            std::lock_guard<std::mutex> lock(m_stagingMutex);
+            m_freeSlots.push_back(staged.slot);
+        }
+
+        if (!encoded) {
+            qDebug() << "Failed to encode history frame" << staged.sequence;
+            continue;
+        }
+
+        if (m_archive) {
+            m_archive->append(staged.sequence, staged.timestamp, buffer);
+        }
+
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        Entry entry{staged.sequence, staged.timestamp, takeBufferLocked(buffer.size())};
+        entry.data.assign(buffer.begin(), buffer.end());
+        m_bytes += entry.data.capacity();
+        m_entries.push_back(std::move(entry));
+        ++m_encoded;
+        evictLocked();
+    }
+}
+
+void CompressedHistory::evictLocked()
+{
+    while (!m_entries.empty() && m_bytes > m_budget) {
+        m_bytes -= m_entries.front().data.capacity();
+        if (m_spareBuffers.size() < SPARE_BUFFERS) {
+            m_spareBuffers.push_back(std::move(m_entries.front().data));
+        }
+        m_entries.pop_front();
+    }
+}
+
+std::vector<uchar> CompressedHistory::takeBufferLocked(size_t size)
+{
+    std::vector<uchar> buffer;
+    if (!m_spareBuffers.empty()) {
+        buffer = std::move(m_spareBuffers.back());
+        m_spareBuffers.pop_back();
+    }
+
+    // JPEG sizes wander from frame to frame; a little headroom lets a
+    // recycled buffer take the next few without growing
+    if (buffer.capacity() < size) {
+        buffer.clear();
+        buffer.reserve(size + size / 8);
+    }
+    return buffer;
+}
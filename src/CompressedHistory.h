@@ -0,0 +1,117 @@
+#ifndef COMPRESSEDHISTORY_H
+#define COMPRESSEDHISTORY_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SegmentStore;
+
+// Long rewind history kept as JPEG-compressed frames under a byte budget.
+//
+// The capture thread hands each frame to push(), which copies it into one of
+// a few preallocated staging slots; a background thread encodes the staged
+// frames and appends them to the history, evicting the oldest entries once the
+// budget is exceeded. If the encoder falls behind, frames are skipped rather
+// than stalling capture. Frames are only decoded when a backward seek asks
+// for them. Evicted entries hand their buffers on to new ones, so a full
+// history encodes without allocating.
+class CompressedHistory
+{
+public:
+    struct Stats {
+        size_t bytes = 0;
+        size_t frames = 0;
+        int64_t oldestSequence = -1;
+        int64_t latestSequence = -1;
+        double secondsCovered = 0.0;
+        uint64_t encoded = 0;
+        uint64_t skipped = 0;
+    };
+
+    explicit CompressedHistory(size_t budgetBytes = DEFAULT_BUDGET_MB * 1024 * 1024);
+    ~CompressedHistory();
+
+    // Memory budget for the compressed frames; shrinking it evicts at once
+    void setBudget(size_t bytes);
+    size_t budget() const;
+
+    // JPEG quality, 1-100
+    void setQuality(int quality);
+    
+    // Also hand every encoded frame to a disk store; only while stopped
+    void setArchive(SegmentStore* archive) { m_archive = archive; }
+
+    // Start/stop the encoder thread; start() drops any previous history
+    void start(int width, int height, int type);
+    void stop();
+
+    // Producer side: stage a frame for encoding. Returns false if every
+    // staging slot is busy and the frame was skipped.
+    bool push(int64_t sequence, int64_t timestamp, const cv::Mat& frame);
+
+    // Decode the newest stored frame at or before sequence. On success
+    // sequence and timestamp are updated to the frame actually returned.
+    bool decode(int64_t& sequence, int64_t& timestamp, cv::Mat& frame) const;
+
+    // Newest stored sequence captured at or before timestamp, or -1
+    int64_t sequenceAt(int64_t timestamp) const;
+
+    // Oldest stored sequence at or after sequence, or -1. The encoder skips
+    // frames, so this is how stepping forward gets past the gaps.
+    int64_t nextSequence(int64_t sequence) const;
+
+    Stats stats() const;
+
+    static const size_t DEFAULT_BUDGET_MB = 256;
+
+private:
+    struct Entry {
+        int64_t sequence;
+        int64_t timestamp;
+        std::vector<uchar> data;
+    };
+
+    struct StagedFrame {
+        int64_t sequence;
+        int64_t timestamp;
+        int slot;
+    };
+
+    void encodeLoop();
+    void evictLocked();
+    std::vector<uchar> takeBufferLocked(size_t size);
+
+    // Encoded history, oldest first
+    mutable std::mutex m_historyMutex;
+    std::deque<Entry> m_entries;
+    size_t m_bytes;     // buffer capacity, so the budget covers the slack
+    size_t m_budget;
+    uint64_t m_encoded;
+    std::atomic<uint64_t> m_skipped;
+
+    // Buffers of evicted entries, reused for the next ones
+    static const size_t SPARE_BUFFERS = 8;
+    std::vector<std::vector<uchar>> m_spareBuffers;
+
+    // Staging slots shared with the capture thread
+    static const int STAGING_SLOTS = 4;
+    std::mutex m_stagingMutex;
+    std::condition_variable m_staged;
+    std::vector<cv::Mat> m_slots;
+    std::vector<int> m_freeSlots;
+    std::deque<StagedFrame> m_pending;
+    bool m_stopRequested;
+    int m_quality;
+
+    SegmentStore* m_archive;
+    std::thread m_encodeThread;
+};
+
+#endif // COMPRESSEDHISTORY_H
@@ -0,0 +1,159 @@
+#include "DeviceCapabilityCache.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+const int FORMAT_VERSION = 1;
+
+QJsonObject modeToJson(const CaptureMode& mode)
+{
+    QJsonObject object;
+    object["width"] = mode.width;
+    object["height"] = mode.height;
+    object["fps"] = mode.fps;
+    return object;
+}
+
+CaptureMode modeFromJson(const QJsonObject& object)
+{
+    CaptureMode mode;
+    mode.width = object["width"].toInt();
+    mode.height = object["height"].toInt();
+    mode.fps = object["fps"].toDouble();
+    return mode;
+}
+
+} // namespace
+
+DeviceCapabilityCache::DeviceCapabilityCache(const QString& path)
+    : m_path(path)
+{
+    load();
+}
+
+QString DeviceCapabilityCache::defaultPath()
+{
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (directory.isEmpty()) {
+        return QString();
+    }
+    return QDir(directory).filePath("device-capabilities.json");
+}
+
+bool DeviceCapabilityCache::lookup(const std::string& device, Entry& entry) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_entries.find(device);
+    if (found == m_entries.end() || found->second.modes.empty()) {
+        return false;
+    }
+    entry = found->second;
+    return true;
+}
+
+void DeviceCapabilityCache::store(const std::string& device, const Entry& entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[device] = entry;
+}
+
+bool DeviceCapabilityCache::setLastMode(const std::string& device, const CaptureMode& mode)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_entries.find(device);
+    if (found == m_entries.end()) {
+        return false;
+    }
+    CaptureMode& last = found->second.lastMode;
+    if (last.width == mode.width && last.height == mode.height) {
+        return false;
+    }
+    last = mode;
+    return true;
+}
+
+void DeviceCapabilityCache::remove(const std::string& device)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(device);
+}
+
+bool DeviceCapabilityCache::load()
+{
+    if (m_path.isEmpty()) {
+        return false;
+    }
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false; // first launch
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    QJsonObject root = document.object();
+    if (error.error != QJsonParseError::NoError || root["version"].toInt() != FORMAT_VERSION) {
+        qDebug() << "Ignoring unreadable device capability cache" << m_path;
+        return false;
+    }
+
+    std::map<std::string, Entry> entries;
+    QJsonObject devices = root["devices"].toObject();
+    for (auto device = devices.begin(); device != devices.end(); ++device) {
+        QJsonObject object = device.value().toObject();
+        Entry entry;
+        for (const QJsonValue& mode : object["modes"].toArray()) {
+            entry.modes.push_back(modeFromJson(mode.toObject()));
+        }
+        entry.lastMode = modeFromJson(object["last"].toObject());
+        entries[device.key().toStdString()] = entry;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries = std::move(entries);
+    return true;
+}
+
+bool DeviceCapabilityCache::save() const
+{
+    if (m_path.isEmpty()) {
+        return false;
+    }
+
+    // Held throughout so concurrent saves do not race on the file
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QJsonObject devices;
+    for (const auto& device : m_entries) {
+        QJsonArray modes;
+        for (const CaptureMode& mode : device.second.modes) {
+            modes.append(modeToJson(mode));
+        }
+        QJsonObject object;
+        object["modes"] = modes;
+        object["last"] = modeToJson(device.second.lastMode);
+        devices[QString::fromStdString(device.first)] = object;
+    }
+
+    QJsonObject root;
+    root["version"] = FORMAT_VERSION;
+    root["devices"] = devices;
+
+    // Written to a temporary file and renamed, so a crash never leaves a
+    // half-written cache behind
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Cannot write device capability cache" << m_path;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    return file.commit();
+}
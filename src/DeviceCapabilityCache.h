@@ -0,0 +1,47 @@
+#ifndef DEVICECAPABILITYCACHE_H
+#define DEVICECAPABILITYCACHE_H
+
+#include <QString>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "FrameSource.h"
+
+// Capture modes probed per device, persisted as JSON so that probing (one
+// mode switch per candidate resolution) only happens on the first launch.
+// Also remembers the mode each device was last used in. Safe to use from
+// several initialization threads at once.
+class DeviceCapabilityCache
+{
+public:
+    struct Entry {
+        std::vector<CaptureMode> modes;
+        CaptureMode lastMode;
+    };
+
+    // An empty path keeps the cache in memory only
+    explicit DeviceCapabilityCache(const QString& path = defaultPath());
+
+    // device-capabilities.json in the per-user cache directory
+    static QString defaultPath();
+
+    QString path() const { return m_path; }
+
+    bool lookup(const std::string& device, Entry& entry) const;
+    void store(const std::string& device, const Entry& entry);
+    // Returns false if the device is unknown or already in that mode
+    bool setLastMode(const std::string& device, const CaptureMode& mode);
+    void remove(const std::string& device);
+
+    bool load();
+    bool save() const;
+
+private:
+    QString m_path;
+    mutable std::mutex m_mutex;
+    std::map<std::string, Entry> m_entries;
+};
+
+#endif // DEVICECAPABILITYCACHE_H
@@ -0,0 +1,234 @@
+#include "FrameAllocator.h"
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+const size_t SMALL_CLASS_STEP = 64 * 1024;
+const size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+// How a block was obtained, kept in UMatData::allocatorFlags_
+enum BlockKind {
+    HeapBlock = 0,
+    MappedBlock = 1,
+    HugePageBlock = 2,
+    UnpooledBlock = 3
+};
+
+} // namespace
+
+FrameAllocator::FrameAllocator()
+    : m_maxPooledBytes(DEFAULT_MAX_POOLED_MB * 1024 * 1024)
+{
+}
+
+FrameAllocator* FrameAllocator::instance()
+{
+    static FrameAllocator* allocator = new FrameAllocator;
+    return allocator;
+}
+
+void FrameAllocator::use(cv::Mat& mat)
+{
+    mat.allocator = instance();
+}
+
+void FrameAllocator::setMaxPooledBytes(size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxPooledBytes = bytes;
+        if (m_stats.bytesPooled <= bytes) {
+            return;
+        }
+    }
+    trim();
+}
+
+FrameAllocator::Stats FrameAllocator::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.sizeClasses = static_cast<int>(m_free.size());
+    return stats;
+}
+
+void FrameAllocator::trim()
+{
+    std::map<size_t, std::vector<cv::UMatData*>> blocks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        blocks.swap(m_free);
+        for (const auto& sizeClass : blocks) {
+            m_stats.systemFrees += sizeClass.second.size();
+        }
+        m_stats.bytesPooled = 0;
+    }
+    for (auto& sizeClass : blocks) {
+        for (cv::UMatData* u : sizeClass.second) {
+            freeBlock(u, sizeClass.first);
+        }
+    }
+}
+
+size_t FrameAllocator::sizeClass(size_t bytes)
+{
+    size_t step = bytes >= HUGE_PAGE_BYTES ? HUGE_PAGE_BYTES : SMALL_CLASS_STEP;
+    return (bytes + step - 1) / step * step;
+}
+
+cv::UMatData* FrameAllocator::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                       cv::AccessFlag, cv::UMatUsageFlags) const
+{
+    // Steps as cv::Mat's own allocator lays them out
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    // Headers for someone else's data, and small buffers, are not pooled
+    if (data || total < MIN_POOLED_BYTES) {
+        cv::UMatData* u = new cv::UMatData(this);
+        if (data) {
+            u->data = u->origdata = static_cast<uchar*>(data);
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+        } else {
+            u->data = u->origdata = static_cast<uchar*>(cv::fastMalloc(total));
+            u->allocatorFlags_ = UnpooledBlock;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.unpooled;
+        }
+        u->size = total;
+        return u;
+    }
+
+    size_t size = sizeClass(total);
+    cv::UMatData* u = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.allocations;
+        m_stats.bytesInUse += size;
+        auto free = m_free.find(size);
+        if (free != m_free.end() && !free->second.empty()) {
+            u = free->second.back();
+            free->second.pop_back();
+            m_stats.bytesPooled -= size;
+            ++m_stats.reused;
+        }
+    }
+
+    if (u) {
+        // A fresh header in place, keeping the block
+        uchar* block = u->origdata;
+        int kind = u->allocatorFlags_;
+        u->~UMatData();
+        new (u) cv::UMatData(this);
+        u->data = u->origdata = block;
+        u->allocatorFlags_ = kind;
+    } else {
+        int kind = HeapBlock;
+        uchar* block = allocateBlock(size, kind);
+        u = new cv::UMatData(this);
+        u->data = u->origdata = block;
+        u->allocatorFlags_ = kind;
+    }
+    u->size = total;
+    return u;
+}
+
+bool FrameAllocator::allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const
+{
+    return data != nullptr;
+}
+
+void FrameAllocator::deallocate(cv::UMatData* u) const
+{
+    if (!u) {
+        return;
+    }
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+
+    if (u->flags & cv::UMatData::USER_ALLOCATED) {
+        delete u;
+        return;
+    }
+    if (u->allocatorFlags_ == UnpooledBlock) {
+        cv::fastFree(u->origdata);
+        delete u;
+        return;
+    }
+
+    size_t size = sizeClass(u->size);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.bytesInUse -= size;
+        if (m_stats.bytesPooled + size <= m_maxPooledBytes) {
+            m_free[size].push_back(u);
+            m_stats.bytesPooled += size;
+            return;
+        }
+        ++m_stats.systemFrees;
+    }
+    freeBlock(u, size);
+}
+
+uchar* FrameAllocator::allocateBlock(size_t size, int& kind) const
+{
+    bool hugePages = false;
+    void* block = nullptr;
+#ifdef __linux__
+    if (size >= HUGE_PAGE_BYTES) {
+        // Reserved huge pages first (vm.nr_hugepages); most systems have
+        // none, so fall back to transparent huge pages
+        block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (block != MAP_FAILED) {
+            hugePages = true;
+            kind = HugePageBlock;
+        } else {
+            block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (block != MAP_FAILED) {
+                madvise(block, size, MADV_HUGEPAGE);
+                kind = MappedBlock;
+            } else {
+                block = nullptr;
+            }
+        }
+    }
+#endif
+    if (!block) {
+        // Throws cv::Exception when out of memory, like any Mat allocation
+        block = cv::fastMalloc(size);
+        kind = HeapBlock;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.systemAllocations;
+    if (hugePages) {
+        ++m_stats.hugePageBlocks;
+    }
+    return static_cast<uchar*>(block);
+}
+
+void FrameAllocator::freeBlock(cv::UMatData* u, size_t size)
+{
+    if (u->allocatorFlags_ == HeapBlock) {
+        cv::fastFree(u->origdata);
+    } else {
+#ifdef __linux__
+        munmap(u->origdata, size);
+#endif
+    }
+    delete u;
+}
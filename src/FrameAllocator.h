@@ -0,0 +1,77 @@
+#ifndef FRAMEALLOCATOR_H
+#define FRAMEALLOCATOR_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// cv::MatAllocator that recycles frame buffers instead of returning them
+// to the heap.
+//
+// Buffers of 64 KB and up are rounded to a size class (64 KB steps, 2 MB
+// steps from 2 MB) and go back to that class's free list when the last Mat
+// sharing them is released, together with their UMatData header, so a
+// steady stream of same-sized frames never reaches malloc or free. On
+// Linux, blocks of 2 MB and up are mapped on huge pages where some are
+// reserved, and otherwise advised for transparent huge pages, which saves
+// TLB misses when whole frames are walked. Free blocks beyond
+// maxPooledBytes go back to the system.
+//
+// Mats opt in with use() before their data is allocated. The setting is
+// kept across release() and create(), but not carried by a move, so slots
+// that hand their frame on by moving need use() again.
+class FrameAllocator : public cv::MatAllocator
+{
+public:
+    struct Stats {
+        uint64_t allocations = 0;       // pooled blocks handed out
+        uint64_t reused = 0;            // of those, served from a free list
+        uint64_t systemAllocations = 0; // blocks taken from the system
+        uint64_t systemFrees = 0;       // blocks given back over the cap
+        uint64_t unpooled = 0;          // small buffers, passed to the heap
+        uint64_t hugePageBlocks = 0;    // mapped on reserved huge pages
+        size_t bytesInUse = 0;
+        size_t bytesPooled = 0;         // free, kept for reuse
+        int sizeClasses = 0;
+    };
+
+    static const size_t MIN_POOLED_BYTES = 64 * 1024;
+    static const size_t DEFAULT_MAX_POOLED_MB = 512;
+
+    // The process-wide pool. Never destroyed, so Mats may outlive whoever
+    // allocated them.
+    static FrameAllocator* instance();
+
+    // Allocate mat's future buffers from the pool
+    static void use(cv::Mat& mat);
+
+    void setMaxPooledBytes(size_t bytes);
+    Stats stats() const;
+
+    // Give every free block back to the system
+    void trim();
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    FrameAllocator();
+
+    static size_t sizeClass(size_t bytes);
+    uchar* allocateBlock(size_t size, int& kind) const;
+    static void freeBlock(cv::UMatData* u, size_t size);
+
+    // Blocks and their headers, by size class. The MatAllocator interface
+    // is const, so all of it is mutable.
+    mutable std::mutex m_mutex;
+    mutable std::map<size_t, std::vector<cv::UMatData*>> m_free;
+    size_t m_maxPooledBytes;
+    mutable Stats m_stats;
+};
+
+#endif // FRAMEALLOCATOR_H
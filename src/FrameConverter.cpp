@@ -0,0 +1,213 @@
+#include "FrameConverter.h"
+#include "PixelKernels.h"
+#include <opencv2/imgproc.hpp>
+#include <QDebug>
+#include <QtGlobal>
+#include <algorithm>
+
+namespace {
+
+struct PooledImageData {
+    std::shared_ptr<ImageBufferPool> pool;
+    uchar* data;
+    size_t size;
+};
+
+void releasePooledImageData(void* info)
+{
+    auto* pooled = static_cast<PooledImageData*>(info);
+    pooled->pool->release(pooled->data, pooled->size);
+    delete pooled;
+}
+
+// Pixel writers; each fills a preallocated target of the right size
+template <typename Format>
+void convertWithKernel(const cv::Mat& src, cv::Mat& dst)
+{
+    PixelKernels::convert<Format>(src.data, src.step, dst.data, dst.step, src.cols, src.rows);
+}
+
+void copyPixels(const cv::Mat& src, cv::Mat& dst)
+{
+    src.copyTo(dst);
+}
+
+void grayToBgrx(const cv::Mat& src, cv::Mat& dst)
+{
+    cv::cvtColor(src, dst, cv::COLOR_GRAY2BGRA);
+}
+
+// QImage scanlines must be 32-bit aligned
+int alignedStride(int width, int channels)
+{
+    return (width * channels + 3) & ~3;
+}
+
+} // namespace
+
+ImageBufferPool::ImageBufferPool(size_t maxFreeBuffers)
+    : m_maxFreeBuffers(maxFreeBuffers)
+    , m_allocations(0)
+{
+}
+
+uchar* ImageBufferPool::acquire(size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find_if(m_free.begin(), m_free.end(),
+                               [size](const Buffer& buffer) { return buffer.size == size; });
+        if (it != m_free.end()) {
+            uchar* data = it->data.release();
+            m_free.erase(it);
+            return data;
+        }
+        ++m_allocations;
+    }
+    return new uchar[size];
+}
+
+void ImageBufferPool::release(uchar* buffer, size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_free.size() >= m_maxFreeBuffers) {
+        // Drop the oldest free buffer; after a resolution change the pool
+        // drains the old size naturally
+        m_free.erase(m_free.begin());
+    }
+    m_free.push_back(Buffer{size, std::unique_ptr<uchar[]>(buffer)});
+}
+
+size_t ImageBufferPool::allocationCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocations;
+}
+
+FrameConverter::FrameConverter()
+    : m_pool(std::make_shared<ImageBufferPool>())
+{
+}
+
+QImage FrameConverter::toImage(const cv::Mat& mat)
+{
+    QImage image;
+
+    switch (mat.type()) {
+        case CV_8UC1:
+            image = convert(mat, QImage::Format_Grayscale8, 1, convertWithKernel<PixelKernels::GrayCopy>);
+            break;
+        case CV_8UC2:
+            // Packed YUYV as delivered by devices with RGB conversion disabled
+            image = convert(mat, QImage::Format_RGB888, 3, convertWithKernel<PixelKernels::Yuyv2Rgb>);
+            break;
+        case CV_8UC3:
+            image = convert(mat, QImage::Format_BGR888, 3, copyPixels);
+            break;
+        case CV_8UC4:
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+            // ARGB32 is stored as B, G, R, A bytes on little-endian
+            image = convert(mat, QImage::Format_ARGB32, 4, copyPixels);
+#else
+            image = convert(mat, QImage::Format_RGBA8888, 4, convertWithKernel<PixelKernels::Bgra2Rgba>);
+#endif
+            break;
+        default:
+            qDebug() << "Unsupported cv::Mat format:" << mat.type();
+            return QImage();
+    }
+
+    accountCopy(image.sizeInBytes());
+    return image;
+}
+
+QPixmap FrameConverter::toPixmap(const cv::Mat& mat)
+{
+    // RGB32 is the raster backend's native pixmap format, so fromImage()
+    // below can take the buffer over instead of converting it again
+    QImage image = convertToRgb32(mat);
+    if (image.isNull()) {
+        return QPixmap();
+    }
+
+    size_t bytes = image.sizeInBytes();
+    QPixmap pixmap = QPixmap::fromImage(std::move(image));
+
+    // Platforms whose native pixmap depth is not 32 bits convert once more
+    if (pixmap.depth() != 32) {
+        bytes += static_cast<size_t>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+    }
+
+    accountCopy(bytes);
+    return pixmap;
+}
+
+QImage FrameConverter::toDisplayImage(const cv::Mat& mat, const QSize& fitSize)
+{
+    if (mat.empty()) {
+        return QImage();
+    }
+
+    const cv::Mat* source = &mat;
+    size_t bytes = 0;
+
+    if (fitSize.isValid() && !fitSize.isEmpty()) {
+        double scale = std::min(static_cast<double>(fitSize.width()) / mat.cols,
+                                static_cast<double>(fitSize.height()) / mat.rows);
+        cv::Size scaled(std::max(1, static_cast<int>(mat.cols * scale + 0.5)),
+                        std::max(1, static_cast<int>(mat.rows * scale + 0.5)));
+        if (scaled != mat.size()) {
+            // Scale in the source format first, so the format conversion
+            // only touches display-sized pixels
+            cv::resize(mat, m_scaled, scaled, 0, 0, scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+            source = &m_scaled;
+            bytes += m_scaled.total() * m_scaled.elemSize();
+        }
+    }
+
+    QImage image = convertToRgb32(*source);
+    if (!image.isNull()) {
+        accountCopy(bytes + image.sizeInBytes());
+    }
+    return image;
+}
+
+QImage FrameConverter::convertToRgb32(const cv::Mat& mat)
+{
+    switch (mat.type()) {
+        case CV_8UC1:
+            return convert(mat, QImage::Format_RGB32, 4, grayToBgrx);
+        case CV_8UC3:
+            return convert(mat, QImage::Format_RGB32, 4, convertWithKernel<PixelKernels::Bgr2Bgrx>);
+        case CV_8UC4:
+            return convert(mat, QImage::Format_RGB32, 4, copyPixels);
+        default:
+            qDebug() << "Unsupported cv::Mat format:" << mat.type();
+            return QImage();
+    }
+}
+
+QImage FrameConverter::convert(const cv::Mat& mat, QImage::Format format, int channels, PixelWriter writer)
+{
+    if (mat.empty()) {
+        return QImage();
+    }
+
+    int stride = alignedStride(mat.cols, channels);
+    size_t size = static_cast<size_t>(stride) * mat.rows;
+    uchar* data = m_pool->acquire(size);
+
+    // Wrap the pooled buffer so the pixels are written exactly once
+    cv::Mat target(mat.rows, mat.cols, CV_8UC(channels), data, stride);
+    writer(mat, target);
+
+    auto* pooled = new PooledImageData{m_pool, data, size};
+    return QImage(data, mat.cols, mat.rows, stride, format, releasePooledImageData, pooled);
+}
+
+void FrameConverter::accountCopy(size_t bytes)
+{
+    m_stats.lastFrameBytes = bytes;
+    m_stats.totalBytes += bytes;
+    ++m_stats.frames;
+}
@@ -0,0 +1,83 @@
+#ifndef FRAMECONVERTER_H
+#define FRAMECONVERTER_H
+
+#include <opencv2/core.hpp>
+#include <QImage>
+#include <QPixmap>
+#include <QSize>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Pool of image buffers handed to QImage with a cleanup callback, so a
+// buffer returns to the pool when the last QImage/QPixmap sharing it dies.
+// Shared ownership keeps the pool alive for images that outlive their
+// converter.
+class ImageBufferPool
+{
+public:
+    explicit ImageBufferPool(size_t maxFreeBuffers = 8);
+
+    uchar* acquire(size_t size);
+    void release(uchar* buffer, size_t size);
+
+    size_t allocationCount() const;
+
+private:
+    struct Buffer {
+        size_t size;
+        std::unique_ptr<uchar[]> data;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<Buffer> m_free;
+    size_t m_maxFreeBuffers;
+    size_t m_allocations;
+};
+
+// Converts cv::Mat frames to QImage/QPixmap with at most one full-frame copy.
+// The pixel data is written once, straight into a pooled buffer that the
+// resulting QImage wraps; QPixmap::fromImage then adopts that buffer in place
+// on the raster backend because the display format is already native.
+class FrameConverter
+{
+public:
+    struct Stats {
+        size_t lastFrameBytes = 0;   // bytes copied for the most recent frame
+        uint64_t totalBytes = 0;
+        uint64_t frames = 0;
+    };
+
+    FrameConverter();
+
+    // Native layout where Qt has one (BGR888, Grayscale8, ARGB32 on
+    // little-endian), so the single copy is a plain memcpy
+    QImage toImage(const cv::Mat& mat);
+
+    // Display layout (RGB32); the conversion itself is the only copy
+    QPixmap toPixmap(const cv::Mat& mat);
+
+    // RGB32 image scaled to fit fitSize (aspect preserved), so it can be
+    // painted without further scaling; an invalid size keeps the frame size
+    QImage toDisplayImage(const cv::Mat& mat, const QSize& fitSize = QSize());
+
+    Stats stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+private:
+    using PixelWriter = void (*)(const cv::Mat& src, cv::Mat& dst);
+
+    QImage convert(const cv::Mat& mat, QImage::Format format, int channels, PixelWriter writer);
+    QImage convertToRgb32(const cv::Mat& mat);
+    void accountCopy(size_t bytes);
+
+    std::shared_ptr<ImageBufferPool> m_pool;
+    Stats m_stats;
+
+    // Scratch for frames scaled to display size, reused between frames
+    cv::Mat m_scaled;
+};
+
+#endif // FRAMECONVERTER_H
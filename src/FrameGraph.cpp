@@ -0,0 +1,285 @@
+#include "FrameGraph.h"
+#include "FrameAllocator.h"
+#include "PipelineMetrics.h"
+#include <QDebug>
+#include <algorithm>
+
+FrameGraph::FrameGraph(int threads, int maxInFlight)
+    : m_maxInFlight(maxInFlight)
+    , m_nextIndex(0)
+    , m_inFlight(0)
+    , m_nextOutput(0)
+    , m_submitted(0)
+    , m_completed(0)
+    , m_rejected(0)
+    , m_latencyNs(0)
+    , m_pool(threads)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+    waitIdle();
+}
+
+int FrameGraph::addStage(std::unique_ptr<ProcessingStage> stage, std::vector<int> inputs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!stage || !m_jobs.empty()) {
+        return -1;
+    }
+
+    int id = static_cast<int>(m_stages.size());
+    if (inputs.empty()) {
+        inputs.push_back(id - 1);   // the previous stage, or SOURCE for the first
+    }
+    for (int input : inputs) {
+        if (input < SOURCE || input >= id) {
+            qDebug() << "Processing stage" << stage->name().c_str() << "has an invalid input" << input;
+            return -1;
+        }
+    }
+
+    auto entry = std::make_unique<Stage>();
+    entry->stateless = stage->isStateless();
+    entry->stage = std::move(stage);
+    entry->inputs = inputs;
+    for (int input : inputs) {
+        if (input == SOURCE) {
+            m_sourceConsumers.push_back(id);
+        } else {
+            m_stages[input]->consumers.push_back(id);
+        }
+    }
+    m_stages.push_back(std::move(entry));
+    return id;
+}
+
+void FrameGraph::setOutputCallback(OutputCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    m_outputCallback = std::move(callback);
+}
+
+bool FrameGraph::submit(const cv::Mat& frame, int64_t sequence, int64_t timestamp)
+{
+    Job* job = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_jobs.empty()) {
+            allocateJobs();
+        }
+        if (m_freeJobs.empty()) {
+            ++m_rejected;
+            return false;
+        }
+        job = m_freeJobs.back();
+        m_freeJobs.pop_back();
+        job->index = m_nextIndex++;
+        ++m_inFlight;
+    }
+
+    // Reuses the slot's buffer from the last frame it carried
+    frame.copyTo(job->input);
+    job->context.sequence = sequence;
+    job->context.timestamp = timestamp;
+    job->submitted = PipelineMetrics::now();
+    for (size_t i = 0; i < m_stages.size(); ++i) {
+        job->pendingInputs[i] = static_cast<int>(m_stages[i]->inputs.size());
+    }
+    job->remainingStages = static_cast<int>(m_stages.size());
+    ++m_submitted;
+
+    if (m_stages.empty()) {
+        complete(job);
+        return true;
+    }
+    for (int consumer : m_sourceConsumers) {
+        if (--job->pendingInputs[consumer] == 0) {
+            schedule(consumer, job);
+        }
+    }
+    return true;
+}
+
+void FrameGraph::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_inFlight == 0; });
+}
+
+FrameGraph::Stats FrameGraph::stats() const
+{
+    Stats stats;
+    for (const auto& stage : m_stages) {
+        StageStats entry;
+        entry.name = stage->stage->name();
+        entry.stateless = stage->stateless;
+        entry.frames = stage->frames;
+        entry.errors = stage->errors;
+        entry.meanMs = entry.frames > 0 ? stage->totalNs / 1e6 / entry.frames : 0.0;
+        entry.maxMs = stage->maxNs / 1e6;
+        stats.stages.push_back(entry);
+    }
+    stats.submitted = m_submitted;
+    stats.completed = m_completed;
+    stats.rejected = m_rejected;
+    stats.latencyMs = stats.completed > 0 ? m_latencyNs / 1e6 / stats.completed : 0.0;
+    return stats;
+}
+
+void FrameGraph::resetStats()
+{
+    for (auto& stage : m_stages) {
+        stage->frames = 0;
+        stage->errors = 0;
+        stage->totalNs = 0;
+        stage->maxNs = 0;
+    }
+    m_submitted = 0;
+    m_completed = 0;
+    m_rejected = 0;
+    m_latencyNs = 0;
+}
+
+void FrameGraph::allocateJobs()
+{
+    // Enough frames in flight to keep every thread busy and every stage of
+    // a long chain occupied at once
+    int count = m_maxInFlight > 0 ? m_maxInFlight
+                                  : std::max(2 * m_pool.size(), static_cast<int>(m_stages.size()) + 1);
+    for (int i = 0; i < count; ++i) {
+        auto job = std::make_unique<Job>();
+        job->outputs.resize(m_stages.size());
+        FrameAllocator::use(job->input);
+        for (auto& output : job->outputs) {
+            FrameAllocator::use(output);
+        }
+        job->pendingInputs = std::make_unique<std::atomic<int>[]>(m_stages.size());
+        m_freeJobs.push_back(job.get());
+        m_jobs.push_back(std::move(job));
+    }
+    m_maxInFlight = count;
+}
+
+void FrameGraph::schedule(int stage, Job* job)
+{
+    Stage& entry = *m_stages[stage];
+    if (entry.stateless) {
+        m_pool.submit([this, stage, job] { run(stage, job); });
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        entry.ready.emplace(job->index, job);
+    }
+    runNextInOrder(stage);
+}
+
+void FrameGraph::runNextInOrder(int stage)
+{
+    Stage& entry = *m_stages[stage];
+    Job* job = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        if (entry.busy || entry.ready.empty() || entry.ready.begin()->first != entry.nextIndex) {
+            return;
+        }
+        job = entry.ready.begin()->second;
+        entry.ready.erase(entry.ready.begin());
+        entry.busy = true;
+    }
+    m_pool.submit([this, stage, job] { run(stage, job); });
+}
+
+void FrameGraph::run(int stage, Job* job)
+{
+    Stage& entry = *m_stages[stage];
+    std::vector<const cv::Mat*> inputs;
+    inputs.reserve(entry.inputs.size());
+    for (int input : entry.inputs) {
+        inputs.push_back(input == SOURCE ? &job->input : &job->outputs[input]);
+    }
+
+    // Pool tasks must not throw; a failing stage passes on an empty frame
+    int64_t start = PipelineMetrics::now();
+    try {
+        entry.stage->process(inputs, job->context, job->outputs[stage]);
+    }
+    catch (const std::exception& e) {
+        if (entry.errors++ == 0) {
+            qDebug() << "Processing stage" << entry.stage->name().c_str() << "failed:" << e.what();
+        }
+        job->outputs[stage].release();
+    }
+    int64_t elapsed = PipelineMetrics::now() - start;
+
+    ++entry.frames;
+    entry.totalNs += elapsed;
+    int64_t longest = entry.maxNs;
+    while (elapsed > longest && !entry.maxNs.compare_exchange_weak(longest, elapsed)) {
+    }
+
+    finishStage(stage, job);
+}
+
+void FrameGraph::finishStage(int stage, Job* job)
+{
+    Stage& entry = *m_stages[stage];
+    if (!entry.stateless) {
+        {
+            std::lock_guard<std::mutex> lock(entry.mutex);
+            entry.busy = false;
+            ++entry.nextIndex;
+        }
+        runNextInOrder(stage);
+    }
+
+    for (int consumer : entry.consumers) {
+        if (--job->pendingInputs[consumer] == 0) {
+            schedule(consumer, job);
+        }
+    }
+
+    // Last, since the job may be recycled as soon as it completes
+    if (--job->remainingStages == 0) {
+        complete(job);
+    }
+}
+
+void FrameGraph::complete(Job* job)
+{
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    m_finished.emplace(job->index, job);
+    while (!m_finished.empty() && m_finished.begin()->first == m_nextOutput) {
+        Job* next = m_finished.begin()->second;
+        m_finished.erase(m_finished.begin());
+        ++m_nextOutput;
+        deliver(next);
+    }
+}
+
+void FrameGraph::deliver(Job* job)
+{
+    // Hand the frame over; the slot takes a fresh output from the frame
+    // pool next time, and this one goes back to it once the receiver is done
+    Output output;
+    cv::Mat& delivered = m_stages.empty() ? job->input : job->outputs.back();
+    output.frame = std::move(delivered);
+    FrameAllocator::use(delivered);
+    output.sequence = job->context.sequence;
+    output.timestamp = job->context.timestamp;
+    if (m_outputCallback) {
+        m_outputCallback(output);
+    }
+    m_latencyNs += PipelineMetrics::now() - job->submitted;
+    ++m_completed;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeJobs.push_back(job);
+        --m_inFlight;
+    }
+    m_idle.notify_all();
+}
@@ -0,0 +1,152 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ProcessingStage.h"
+#include "ThreadPool.h"
+
+// Runs captured frames through a chain or DAG of ProcessingStages on a
+// thread pool, pipelined: a stage starts on a frame as soon as its inputs for
+// that frame are done, so different stages work on different frames at the
+// same time, and stateless stages also run several frames in parallel.
+// Stateful stages see frames strictly in order. Finished frames are handed
+// to the output callback in submission order, whatever order they finish in.
+//
+// A fixed number of frames may be in the graph at once; further frames are
+// rejected rather than queued, so a graph slower than the camera drops
+// frames instead of adding latency.
+class FrameGraph
+{
+public:
+    // Input id meaning the submitted frame itself
+    static const int SOURCE = -1;
+
+    struct Output {
+        cv::Mat frame;
+        int64_t sequence = 0;
+        int64_t timestamp = 0;
+    };
+
+    struct StageStats {
+        std::string name;
+        bool stateless = true;
+        uint64_t frames = 0;
+        uint64_t errors = 0;
+        double meanMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    struct Stats {
+        std::vector<StageStats> stages;
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        uint64_t rejected = 0;      // graph full when submitted
+        double latencyMs = 0.0;     // mean, submitted until handed to the output
+    };
+
+    // Called on a pool thread, one frame at a time and in submission order.
+    // The frame is handed over: the graph keeps no reference to it.
+    using OutputCallback = std::function<void(Output&)>;
+
+    // 0 threads means one per hardware thread; 0 frames in flight means
+    // enough to keep every thread and every stage busy
+    explicit FrameGraph(int threads = 0, int maxInFlight = 0);
+    ~FrameGraph();
+
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    // Add a stage fed by the given stages (ids returned earlier, or SOURCE).
+    // No inputs means the previously added stage, or SOURCE for the first.
+    // The last stage added produces the output. Returns the stage id, or -1
+    // if an input is invalid or frames have already been submitted.
+    int addStage(std::unique_ptr<ProcessingStage> stage, std::vector<int> inputs = {});
+    int stageCount() const { return static_cast<int>(m_stages.size()); }
+
+    void setOutputCallback(OutputCallback callback);
+
+    // Copy a frame into the graph; from one thread at a time. Returns false,
+    // dropping the frame, if the graph is full.
+    bool submit(const cv::Mat& frame, int64_t sequence, int64_t timestamp);
+
+    // Block until every submitted frame has been handed to the output
+    void waitIdle();
+
+    Stats stats() const;
+    void resetStats();
+
+private:
+    struct Job {
+        cv::Mat input;
+        std::vector<cv::Mat> outputs;                       // per stage
+        std::unique_ptr<std::atomic<int>[]> pendingInputs;  // per stage
+        std::atomic<int> remainingStages{0};
+        uint64_t index = 0;
+        ProcessingStage::Context context;
+        int64_t submitted = 0;
+    };
+
+    struct Stage {
+        std::unique_ptr<ProcessingStage> stage;
+        bool stateless = true;
+        std::vector<int> inputs;
+        std::vector<int> consumers;
+
+        // Stateful stages: frames ready for this stage, run strictly by index
+        std::mutex mutex;
+        std::map<uint64_t, Job*> ready;
+        uint64_t nextIndex = 0;
+        bool busy = false;
+
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<int64_t> totalNs{0};
+        std::atomic<int64_t> maxNs{0};
+    };
+
+    void allocateJobs();
+    void schedule(int stage, Job* job);
+    void runNextInOrder(int stage);
+    void run(int stage, Job* job);
+    void finishStage(int stage, Job* job);
+    void complete(Job* job);
+    void deliver(Job* job);
+
+    int m_maxInFlight;
+    std::vector<std::unique_ptr<Stage>> m_stages;
+    std::vector<int> m_sourceConsumers;
+
+    // Job slots, recycled so intermediate buffers are reused frame to frame
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    std::vector<std::unique_ptr<Job>> m_jobs;
+    std::vector<Job*> m_freeJobs;
+    uint64_t m_nextIndex;
+    int m_inFlight;
+
+    // Finished frames waiting for an earlier one before they can be output
+    std::mutex m_outputMutex;
+    std::map<uint64_t, Job*> m_finished;
+    uint64_t m_nextOutput;
+    OutputCallback m_outputCallback;
+
+    std::atomic<uint64_t> m_submitted;
+    std::atomic<uint64_t> m_completed;
+    std::atomic<uint64_t> m_rejected;
+    std::atomic<int64_t> m_latencyNs;
+
+    // Last, so its workers are joined before the stages and jobs go away
+    ThreadPool m_pool;
+};
+
+#endif // FRAMEGRAPH_H
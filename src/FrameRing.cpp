@@ -0,0 +1,102 @@
+#include "FrameRing.h"
+#include "FrameAllocator.h"
+
+FrameRing::FrameRing(int capacity)
+    : m_capacity(capacity)
+    , m_slots(capacity + 1)
+    , m_timestamps(capacity + 1, 0)
+    , m_written(0)
+    , m_pinnedSlot(-1)
+{
+}
+
+void FrameRing::allocate(int width, int height, int type)
+{
+    for (auto& slot : m_slots) {
+        FrameAllocator::use(slot);
+        slot.create(height, width, type);
+    }
+    clear();
+}
+
+void FrameRing::clear()
+{
+    m_written = 0;
+    m_pinnedSlot = -1;
+}
+
+cv::Mat* FrameRing::beginWrite()
+{
+    // Sequentially consistent with pin(): either the consumer sees this
+    // frame's predecessor commit and backs off, or we see its pin here
+    int slot = slotIndex(m_written.load());
+    if (m_pinnedSlot.load() == slot) {
+        return nullptr;
+    }
+    return &m_slots[slot];
+}
+
+void FrameRing::commitWrite(int64_t timestamp)
+{
+    m_timestamps[slotIndex(m_written.load())] = timestamp;
+    m_written.fetch_add(1);
+}
+
+bool FrameRing::peek(int64_t sequence, cv::Mat& view) const
+{
+    if (!contains(sequence)) {
+        return false;
+    }
+    view = m_slots[slotIndex(sequence)];
+    return true;
+}
+
+int64_t FrameRing::latestSequence() const
+{
+    return m_written.load() - 1;
+}
+
+int64_t FrameRing::oldestSequence() const
+{
+    int64_t written = m_written.load();
+    if (written == 0) {
+        return -1;
+    }
+    return written > m_capacity ? written - m_capacity : 0;
+}
+
+bool FrameRing::contains(int64_t sequence) const
+{
+    int64_t written = m_written.load();
+    return sequence >= 0 && sequence < written && sequence >= written - m_capacity;
+}
+
+int64_t FrameRing::timestamp(int64_t sequence) const
+{
+    return m_timestamps[slotIndex(sequence)];
+}
+
+bool FrameRing::pin(int64_t sequence, cv::Mat& view)
+{
+    m_pinnedSlot = slotIndex(sequence);
+
+    // Re-check after publishing the pin: the producer may have reached the
+    // slot before it saw our pin
+    if (!contains(sequence)) {
+        m_pinnedSlot = -1;
+        return false;
+    }
+
+    view = m_slots[slotIndex(sequence)];
+    return true;
+}
+
+void FrameRing::unpin()
+{
+    m_pinnedSlot = -1;
+}
+
+int FrameRing::slotIndex(int64_t sequence) const
+{
+    return static_cast<int>(sequence % static_cast<int64_t>(m_slots.size()));
+}
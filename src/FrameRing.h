@@ -0,0 +1,62 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity ring of preallocated frame slots shared between one
+// producer (the capture thread) and one consumer (the GUI thread).
+//
+// The producer reads straight into the next slot and commits it; slots are
+// reused in place, so steady-state capture performs no heap allocation.
+// Frames are addressed by a sequence number that counts up from zero after
+// clear(). The consumer pins the slot it is looking at so the producer never
+// overwrites a frame that is being displayed, even if it laps the ring.
+class FrameRing
+{
+public:
+    explicit FrameRing(int capacity);
+
+    // Preallocate every slot; only valid while the producer is stopped
+    void allocate(int width, int height, int type);
+    void clear();
+
+    int capacity() const { return m_capacity; }
+
+    // Producer side: returns nullptr while the next slot is pinned.
+    // The timestamp is the frame's capture time in PipelineMetrics::now() units.
+    cv::Mat* beginWrite();
+    void commitWrite(int64_t timestamp);
+
+    // Producer side: a view of a retained frame without pinning it. The
+    // producer is the only thread that overwrites slots, so the view stays
+    // valid until its next beginWrite() reaches the slot.
+    bool peek(int64_t sequence, cv::Mat& view) const;
+
+    // Consumer side
+    int64_t latestSequence() const;
+    int64_t oldestSequence() const;
+    bool contains(int64_t sequence) const;
+    int64_t timestamp(int64_t sequence) const;
+
+    // Pin a frame and return a view into its slot. Only one frame is pinned
+    // at a time; pinning another frame releases the previous one.
+    bool pin(int64_t sequence, cv::Mat& view);
+    void unpin();
+
+private:
+    int slotIndex(int64_t sequence) const;
+
+    int m_capacity;
+
+    // One spare slot so that the slot being written never holds a frame that
+    // is still part of the retained history
+    std::vector<cv::Mat> m_slots;
+    std::vector<int64_t> m_timestamps;
+    std::atomic<int64_t> m_written;
+    std::atomic<int> m_pinnedSlot;
+};
+
+#endif // FRAMERING_H
@@ -0,0 +1,817 @@
+#include "FrameSource.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <QDebug>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <tuple>
+
+namespace {
+
+// Split "body@fps" into its parts; fps stays at fallback if absent
+std::string splitFps(const std::string& spec, double& fps)
+{
+    size_t at = spec.rfind('@');
+    if (at == std::string::npos) {
+        return spec;
+    }
+    try {
+        fps = std::stod(spec.substr(at + 1));
+    }
+    catch (const std::exception&) {
+        return spec;
+    }
+    return spec.substr(0, at);
+}
+
+constexpr uint32_t makeFourcc(char a, char b, char c, char d)
+{
+    return static_cast<uint32_t>(static_cast<unsigned char>(a))
+           | static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8
+           | static_cast<uint32_t>(static_cast<unsigned char>(c)) << 16
+           | static_cast<uint32_t>(static_cast<unsigned char>(d)) << 24;
+}
+
+const uint32_t FOURCC_MJPG = makeFourcc('M', 'J', 'P', 'G');
+const uint32_t FOURCC_JPEG = makeFourcc('J', 'P', 'E', 'G');
+const uint32_t FOURCC_YUYV = makeFourcc('Y', 'U', 'Y', 'V');
+const uint32_t FOURCC_YUY2 = makeFourcc('Y', 'U', 'Y', '2');
+const uint32_t FOURCC_UYVY = makeFourcc('U', 'Y', 'V', 'Y');
+const uint32_t FOURCC_GREY = makeFourcc('G', 'R', 'E', 'Y');
+const uint32_t FOURCC_BGR3 = makeFourcc('B', 'G', 'R', '3');
+
+// Raw pixels as a width x height matrix of type, whether the backend
+// delivered them shaped like that or as one row of bytes
+cv::Mat packedView(const RawFrame& raw, int type)
+{
+    if (raw.data.rows == raw.height && raw.data.cols == raw.width && raw.data.type() == type) {
+        return raw.data;
+    }
+    size_t bytes = static_cast<size_t>(raw.width) * raw.height * CV_ELEM_SIZE(type);
+    if (bytes == 0 || !raw.data.isContinuous() || raw.data.total() * raw.data.elemSize() != bytes) {
+        return cv::Mat();
+    }
+    return cv::Mat(raw.height, raw.width, type, raw.data.data);
+}
+
+// Offset and length of each JPEG in an MJPEG stream. Header segments are
+// skipped by their length up to the start of scan, so an end-of-image
+// marker inside an embedded thumbnail is not taken for the frame's end;
+// in the entropy-coded data that follows, 0xFF is only ever followed by a
+// stuffed zero or a restart marker until the next real marker.
+std::vector<std::pair<size_t, size_t>> splitJpegFrames(const uchar* data, size_t size)
+{
+    std::vector<std::pair<size_t, size_t>> frames;
+    size_t pos = 0;
+    while (pos + 3 < size) {
+        if (data[pos] != 0xFF || data[pos + 1] != 0xD8 || data[pos + 2] != 0xFF) {
+            ++pos;
+            continue;
+        }
+
+        size_t start = pos;
+        size_t p = pos + 2;
+        bool complete = false;
+        while (p + 1 < size && data[p] == 0xFF) {
+            uchar marker = data[p + 1];
+            if (marker == 0xFF) {
+                ++p;    // fill byte
+                continue;
+            }
+            if (marker == 0xD9) {
+                p += 2;
+                complete = true;
+                break;
+            }
+            if (marker == 0xD8 || p + 3 >= size) {
+                // Truncated by the next frame or the end of the file
+                break;
+            }
+            p += 2 + ((static_cast<size_t>(data[p + 2]) << 8) | data[p + 3]);
+            if (marker == 0xDA) {
+                while (p + 1 < size
+                       && !(data[p] == 0xFF && data[p + 1] != 0x00 && (data[p + 1] < 0xD0 || data[p + 1] > 0xD7))) {
+                    ++p;
+                }
+            }
+        }
+
+        if (complete) {
+            frames.emplace_back(start, p - start);
+            pos = p;
+        } else {
+            // Truncated or corrupt; resynchronise on the next start of image
+            // from where parsing stopped
+            pos = std::max(p, start + 2);
+        }
+    }
+    return frames;
+}
+
+bool isImageFile(const std::filesystem::path& path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    static const char* const EXTENSIONS[] = {".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff", ".ppm", ".pgm"};
+    return std::find(std::begin(EXTENSIONS), std::end(EXTENSIONS), extension) != std::end(EXTENSIONS);
+}
+
+} // namespace
+
+bool decodeRawFrame(const RawFrame& raw, cv::Mat& frame)
+{
+    if (raw.data.empty()) {
+        return false;
+    }
+
+    try {
+        if (raw.fourcc == FOURCC_MJPG || raw.fourcc == FOURCC_JPEG) {
+            cv::imdecode(raw.data, cv::IMREAD_COLOR, &frame);
+            return !frame.empty();
+        }
+        if (raw.fourcc == FOURCC_YUYV || raw.fourcc == FOURCC_YUY2 || raw.fourcc == FOURCC_UYVY) {
+            cv::Mat packed = packedView(raw, CV_8UC2);
+            if (packed.empty()) {
+                return false;
+            }
+            cv::cvtColor(packed, frame, raw.fourcc == FOURCC_UYVY ? cv::COLOR_YUV2BGR_UYVY : cv::COLOR_YUV2BGR_YUYV);
+            return true;
+        }
+        if (raw.fourcc == FOURCC_GREY) {
+            cv::Mat grey = packedView(raw, CV_8UC1);
+            if (grey.empty()) {
+                return false;
+            }
+            cv::cvtColor(grey, frame, cv::COLOR_GRAY2BGR);
+            return true;
+        }
+        if (raw.fourcc == FOURCC_BGR3) {
+            cv::Mat bgr = packedView(raw, CV_8UC3);
+            if (bgr.empty()) {
+                return false;
+            }
+            bgr.copyTo(frame);
+            return true;
+        }
+    }
+    catch (const cv::Exception& e) {
+        qDebug() << "Cannot decode frame:" << e.what();
+    }
+    return false;
+}
+
+std::string fourccName(uint32_t fourcc)
+{
+    std::string name;
+    for (int shift = 0; shift < 32; shift += 8) {
+        char c = static_cast<char>((fourcc >> shift) & 0xFF);
+        name += std::isprint(static_cast<unsigned char>(c)) ? c : '?';
+    }
+    return name;
+}
+
+bool FrameSource::grab()
+{
+    cv::Mat discarded;
+    return read(discarded);
+}
+
+bool FrameSource::readRaw(RawFrame&)
+{
+    // Sources without a native format have nothing to hand out undecoded
+    return false;
+}
+
+std::vector<CaptureMode> FrameSource::probeModes()
+{
+    static const std::pair<int, int> CANDIDATES[] = {
+        {320, 240}, {640, 480}, {800, 600}, {1024, 768}, {1280, 720},
+        {1280, 960}, {1600, 1200}, {1920, 1080}, {2560, 1440}, {3840, 2160}
+    };
+
+    std::pair<int, int> original = resolution();
+    std::vector<CaptureMode> modes;
+    for (const auto& candidate : CANDIDATES) {
+        // Drivers snap unsupported sizes to the nearest one they have
+        if (setResolution(candidate.first, candidate.second) == candidate) {
+            modes.push_back(CaptureMode{candidate.first, candidate.second, fps()});
+        }
+    }
+
+    std::pair<int, int> restored = setResolution(original.first, original.second);
+    if (modes.empty()) {
+        modes.push_back(CaptureMode{restored.first, restored.second, fps()});
+    }
+    return modes;
+}
+
+std::unique_ptr<FrameSource> createFrameSource(const std::string& spec)
+{
+    if (!spec.empty() && std::all_of(spec.begin(), spec.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return std::make_unique<CameraSource>(std::stoi(spec));
+    }
+
+    const std::string syntheticPrefix = "synthetic:";
+    if (spec.rfind(syntheticPrefix, 0) == 0) {
+        double fps = 30.0;
+        std::string size = splitFps(spec.substr(syntheticPrefix.size()), fps);
+        int width = 640;
+        int height = 480;
+        size_t x = size.find('x');
+        if (x != std::string::npos) {
+            width = std::stoi(size.substr(0, x));
+            height = std::stoi(size.substr(x + 1));
+        }
+        return std::make_unique<SyntheticSource>(width, height, fps);
+    }
+
+    const std::string filePrefix = "file:";
+    if (spec.rfind(filePrefix, 0) == 0) {
+        double fps = -1.0;
+        std::string path = splitFps(spec.substr(filePrefix.size()), fps);
+        return std::make_unique<VideoFileSource>(path, fps);
+    }
+
+    const std::string mjpegPrefix = "mjpeg:";
+    if (spec.rfind(mjpegPrefix, 0) == 0) {
+        double fps = 30.0;
+        std::string path = splitFps(spec.substr(mjpegPrefix.size()), fps);
+        return std::make_unique<MjpegFileSource>(path, fps);
+    }
+
+    const std::string imagesPrefix = "images:";
+    if (spec.rfind(imagesPrefix, 0) == 0) {
+        double fps = 30.0;
+        std::string path = splitFps(spec.substr(imagesPrefix.size()), fps);
+        return std::make_unique<ImageSequenceSource>(path, fps);
+    }
+
+    std::error_code error;
+    if (std::filesystem::is_directory(spec, error)) {
+        return std::make_unique<ImageSequenceSource>(spec);
+    }
+    std::string extension = std::filesystem::path(spec).extension().string();
+    if (extension == ".mjpg" || extension == ".mjpeg") {
+        return std::make_unique<MjpegFileSource>(spec);
+    }
+    return std::make_unique<VideoFileSource>(spec);
+}
+
+// FramePacer
+
+FramePacer::FramePacer(double fps)
+    : m_fps(fps)
+{
+}
+
+void FramePacer::setFps(double fps)
+{
+    m_fps = fps;
+    reset();
+}
+
+void FramePacer::reset()
+{
+    m_nextFrame = std::chrono::steady_clock::time_point();
+}
+
+void FramePacer::wait()
+{
+    if (m_fps <= 0.0) {
+        return;
+    }
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / m_fps));
+    auto now = std::chrono::steady_clock::now();
+
+    if (m_nextFrame == std::chrono::steady_clock::time_point()) {
+        m_nextFrame = now;
+    }
+    else if (m_nextFrame > now) {
+        std::this_thread::sleep_until(m_nextFrame);
+    }
+    else if (now - m_nextFrame > period) {
+        // Fell behind by more than a frame; resync instead of bursting
+        m_nextFrame = now;
+    }
+
+    m_nextFrame += period;
+}
+
+// CameraSource
+
+CameraSource::CameraSource(int cameraIndex)
+    : m_cameraIndex(cameraIndex)
+    , m_rawOutput(false)
+    , m_fourcc(0)
+    , m_width(0)
+    , m_height(0)
+{
+}
+
+bool CameraSource::open()
+{
+    if (!m_capture.open(m_cameraIndex)) {
+        return false;
+    }
+    if (m_rawOutput) {
+        setRawOutput(true);
+    }
+    return true;
+}
+
+void CameraSource::close()
+{
+    if (m_capture.isOpened()) {
+        m_capture.release();
+    }
+}
+
+bool CameraSource::isOpened() const
+{
+    return m_capture.isOpened();
+}
+
+bool CameraSource::read(cv::Mat& frame)
+{
+    if (m_rawOutput) {
+        return readRaw(m_raw) && decodeRawFrame(m_raw, frame);
+    }
+    return m_capture.read(frame);
+}
+
+bool CameraSource::setRawOutput(bool raw)
+{
+    m_rawOutput = raw;
+    if (m_capture.isOpened()) {
+        // MJPEG is what most USB cameras need for high resolutions at full
+        // rate; cameras without it keep their current format
+        if (raw) {
+            m_capture.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'));
+        }
+        m_capture.set(cv::CAP_PROP_CONVERT_RGB, raw ? 0 : 1);
+        updateNativeFormat();
+    }
+    return true;
+}
+
+bool CameraSource::readRaw(RawFrame& frame)
+{
+    if (!m_capture.read(frame.data) || frame.data.empty()) {
+        return false;
+    }
+    // Backends that ignore CONVERT_RGB still deliver BGR
+    frame.fourcc = frame.data.type() == CV_8UC3 ? FOURCC_BGR3 : m_fourcc;
+    frame.width = m_width;
+    frame.height = m_height;
+    return true;
+}
+
+void CameraSource::updateNativeFormat()
+{
+    m_fourcc = static_cast<uint32_t>(m_capture.get(cv::CAP_PROP_FOURCC));
+    std::tie(m_width, m_height) = resolution();
+}
+
+bool CameraSource::grab()
+{
+    return m_capture.grab();
+}
+
+std::pair<int, int> CameraSource::setResolution(int width, int height)
+{
+    m_capture.set(cv::CAP_PROP_FRAME_WIDTH, width);
+    m_capture.set(cv::CAP_PROP_FRAME_HEIGHT, height);
+    // Drivers may change the native format along with the size
+    if (m_rawOutput) {
+        updateNativeFormat();
+    }
+    return resolution();
+}
+
+std::pair<int, int> CameraSource::resolution() const
+{
+    return std::make_pair(static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_WIDTH)),
+                          static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+}
+
+std::string CameraSource::description() const
+{
+    return "camera with index " + std::to_string(m_cameraIndex);
+}
+
+double CameraSource::fps() const
+{
+    return m_capture.get(cv::CAP_PROP_FPS);
+}
+
+std::string CameraSource::identity() const
+{
+    // Indices are reassigned as devices come and go, so include the card
+    // name where V4L2 exposes it
+    std::ifstream name("/sys/class/video4linux/video" + std::to_string(m_cameraIndex) + "/name");
+    std::string card;
+    if (name && std::getline(name, card) && !card.empty()) {
+        return "camera:" + std::to_string(m_cameraIndex) + ":" + card;
+    }
+    return "camera:" + std::to_string(m_cameraIndex);
+}
+
+// VideoFileSource
+
+VideoFileSource::VideoFileSource(const std::string& path, double fps)
+    : m_path(path)
+    , m_requestedFps(fps)
+{
+}
+
+bool VideoFileSource::open()
+{
+    if (!m_capture.open(m_path)) {
+        return false;
+    }
+    m_pacer.setFps(m_requestedFps >= 0.0 ? m_requestedFps : m_capture.get(cv::CAP_PROP_FPS));
+    return true;
+}
+
+void VideoFileSource::close()
+{
+    if (m_capture.isOpened()) {
+        m_capture.release();
+    }
+}
+
+bool VideoFileSource::isOpened() const
+{
+    return m_capture.isOpened();
+}
+
+bool VideoFileSource::read(cv::Mat& frame)
+{
+    m_pacer.wait();
+
+    cv::Mat& target = m_outputSize.empty() ? frame : m_decoded;
+    if (!m_capture.read(target)) {
+        // Loop back to the start of the file
+        m_capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+        if (!m_capture.read(target)) {
+            return false;
+        }
+    }
+
+    if (!m_outputSize.empty()) {
+        cv::resize(m_decoded, frame, m_outputSize, 0, 0, cv::INTER_AREA);
+    }
+    return !frame.empty();
+}
+
+bool VideoFileSource::grab()
+{
+    if (m_capture.grab()) {
+        return true;
+    }
+    m_capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+    return m_capture.grab();
+}
+
+std::pair<int, int> VideoFileSource::setResolution(int width, int height)
+{
+    // Files have a fixed size; scale on read so the pipeline sees the
+    // requested resolution
+    int nativeWidth = static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_WIDTH));
+    int nativeHeight = static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+    if (width == nativeWidth && height == nativeHeight) {
+        m_outputSize = cv::Size();
+    }
+    else {
+        m_outputSize = cv::Size(width, height);
+    }
+    return resolution();
+}
+
+std::pair<int, int> VideoFileSource::resolution() const
+{
+    if (!m_outputSize.empty()) {
+        return std::make_pair(m_outputSize.width, m_outputSize.height);
+    }
+    return std::make_pair(static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_WIDTH)),
+                          static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+}
+
+std::string VideoFileSource::description() const
+{
+    return "video file " + m_path;
+}
+
+// MjpegFileSource
+
+MjpegFileSource::MjpegFileSource(const std::string& path, double fps)
+    : m_path(path)
+    , m_next(0)
+    , m_width(0)
+    , m_height(0)
+    , m_pacer(fps)
+{
+}
+
+bool MjpegFileSource::open()
+{
+    std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+    std::streamoff size = file ? static_cast<std::streamoff>(file.tellg()) : -1;
+    if (size <= 0 || size > std::numeric_limits<int>::max()) {
+        qDebug() << "Cannot read MJPEG file" << QString::fromStdString(m_path);
+        return false;
+    }
+    m_data.create(1, static_cast<int>(size), CV_8UC1);
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(m_data.data), size)) {
+        close();
+        return false;
+    }
+
+    m_frames = splitJpegFrames(m_data.data, static_cast<size_t>(size));
+    if (m_frames.empty()) {
+        qDebug() << "No JPEG frames in" << QString::fromStdString(m_path);
+        close();
+        return false;
+    }
+
+    // A camera keeps one size per mode, so the first frame sets it
+    cv::Mat first = cv::imdecode(m_data.colRange(static_cast<int>(m_frames[0].first),
+                                                 static_cast<int>(m_frames[0].first + m_frames[0].second)),
+                                 cv::IMREAD_COLOR);
+    if (first.empty()) {
+        close();
+        return false;
+    }
+    m_width = first.cols;
+    m_height = first.rows;
+    m_next = 0;
+    m_pacer.reset();
+    return true;
+}
+
+void MjpegFileSource::close()
+{
+    m_frames.clear();
+    m_data.release();
+    m_raw = RawFrame();
+}
+
+bool MjpegFileSource::isOpened() const
+{
+    return !m_frames.empty();
+}
+
+bool MjpegFileSource::read(cv::Mat& frame)
+{
+    return readRaw(m_raw) && decodeRawFrame(m_raw, frame);
+}
+
+bool MjpegFileSource::readRaw(RawFrame& frame)
+{
+    if (m_frames.empty()) {
+        return false;
+    }
+    m_pacer.wait();
+
+    // A view into the file buffer, which it keeps alive; nothing is copied
+    const auto& range = m_frames[m_next];
+    frame.fourcc = FOURCC_MJPG;
+    frame.width = m_width;
+    frame.height = m_height;
+    frame.data = m_data.colRange(static_cast<int>(range.first), static_cast<int>(range.first + range.second));
+    m_next = (m_next + 1) % m_frames.size();
+    return true;
+}
+
+bool MjpegFileSource::grab()
+{
+    if (m_frames.empty()) {
+        return false;
+    }
+    m_pacer.wait();
+    m_next = (m_next + 1) % m_frames.size();
+    return true;
+}
+
+std::pair<int, int> MjpegFileSource::setResolution(int, int)
+{
+    // Compressed frames cannot be scaled without decoding them; like a
+    // camera without the mode, the recorded size stays
+    return resolution();
+}
+
+std::pair<int, int> MjpegFileSource::resolution() const
+{
+    return std::make_pair(m_width, m_height);
+}
+
+std::string MjpegFileSource::description() const
+{
+    return "MJPEG file " + m_path;
+}
+
+// ImageSequenceSource
+
+ImageSequenceSource::ImageSequenceSource(const std::string& directory, double fps)
+    : m_directory(directory)
+    , m_next(0)
+    , m_pacer(fps)
+{
+}
+
+bool ImageSequenceSource::open()
+{
+    std::error_code error;
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, error)) {
+        if (entry.is_regular_file() && isImageFile(entry.path())) {
+            paths.push_back(entry.path());
+        }
+    }
+    if (error) {
+        qDebug() << "Cannot read image directory" << QString::fromStdString(m_directory);
+        return false;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    m_frames.clear();
+    for (const auto& path : paths) {
+        cv::Mat image = cv::imread(path.string(), cv::IMREAD_COLOR);
+        if (image.empty()) {
+            continue;
+        }
+        // Playback needs one frame size, like a device would deliver
+        if (!m_frames.empty() && image.size() != m_frames.front().size()) {
+            cv::resize(image, image, m_frames.front().size(), 0, 0, cv::INTER_AREA);
+        }
+        m_frames.push_back(image);
+    }
+
+    m_next = 0;
+    m_pacer.reset();
+    return !m_frames.empty();
+}
+
+void ImageSequenceSource::close()
+{
+    m_frames.clear();
+}
+
+bool ImageSequenceSource::isOpened() const
+{
+    return !m_frames.empty();
+}
+
+bool ImageSequenceSource::read(cv::Mat& frame)
+{
+    if (m_frames.empty()) {
+        return false;
+    }
+    m_pacer.wait();
+    m_frames[m_next].copyTo(frame);
+    m_next = (m_next + 1) % m_frames.size();
+    return true;
+}
+
+bool ImageSequenceSource::grab()
+{
+    if (m_frames.empty()) {
+        return false;
+    }
+    m_pacer.wait();
+    m_next = (m_next + 1) % m_frames.size();
+    return true;
+}
+
+std::pair<int, int> ImageSequenceSource::setResolution(int width, int height)
+{
+    for (auto& image : m_frames) {
+        if (image.cols != width || image.rows != height) {
+            cv::resize(image, image, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+        }
+    }
+    return resolution();
+}
+
+std::pair<int, int> ImageSequenceSource::resolution() const
+{
+    if (m_frames.empty()) {
+        return std::make_pair(0, 0);
+    }
+    return std::make_pair(m_frames.front().cols, m_frames.front().rows);
+}
+
+std::string ImageSequenceSource::description() const
+{
+    return "image directory " + m_directory;
+}
+
+// SyntheticSource
+
+SyntheticSource::SyntheticSource(int width, int height, double fps)
+    : m_width(width)
+    , m_height(height)
+    , m_opened(false)
+    , m_frameNumber(0)
+    , m_pacer(fps)
+{
+}
+
+bool SyntheticSource::open()
+{
+    buildPattern();
+    m_frameNumber = 0;
+    m_pacer.reset();
+    m_opened = true;
+    return true;
+}
+
+void SyntheticSource::close()
+{
+    m_opened = false;
+    m_pattern.release();
+}
+
+bool SyntheticSource::isOpened() const
+{
+    return m_opened;
+}
+
+bool SyntheticSource::read(cv::Mat& frame)
+{
+    if (!m_opened) {
+        return false;
+    }
+    m_pacer.wait();
+
+    int shift = static_cast<int>(m_frameNumber % PATTERN_PERIOD);
+    m_pattern(cv::Rect(shift, 0, m_width, m_height)).copyTo(frame);
+
+    // Stamp the frame number so consumers can tell which frames they got
+    std::memcpy(frame.data, &m_frameNumber, sizeof(m_frameNumber));
+    ++m_frameNumber;
+    return true;
+}
+
+bool SyntheticSource::grab()
+{
+    if (!m_opened) {
+        return false;
+    }
+    m_pacer.wait();
+    ++m_frameNumber;
+    return true;
+}
+
+std::pair<int, int> SyntheticSource::setResolution(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    if (m_opened) {
+        buildPattern();
+    }
+    return resolution();
+}
+
+std::pair<int, int> SyntheticSource::resolution() const
+{
+    return std::make_pair(m_width, m_height);
+}
+
+std::string SyntheticSource::description() const
+{
+    return "synthetic " + std::to_string(m_width) + "x" + std::to_string(m_height)
+           + " @ " + std::to_string(static_cast<int>(m_pacer.fps())) + " fps";
+}
+
+uint64_t SyntheticSource::frameNumber(const cv::Mat& frame)
+{
+    uint64_t number = 0;
+    if (frame.total() * frame.elemSize() >= sizeof(number)) {
+        std::memcpy(&number, frame.data, sizeof(number));
+    }
+    return number;
+}
+
+void SyntheticSource::buildPattern()
+{
+    // Diagonal colour ramps, periodic in x so a sliding window animates them
+    m_pattern.create(m_height, m_width + PATTERN_PERIOD, CV_8UC3);
+    for (int y = 0; y < m_pattern.rows; ++y) {
+        uchar* row = m_pattern.ptr<uchar>(y);
+        for (int x = 0; x < m_pattern.cols; ++x) {
+            row[x * 3 + 0] = static_cast<uchar>(x);
+            row[x * 3 + 1] = static_cast<uchar>(y);
+            row[x * 3 + 2] = static_cast<uchar>(x + y);
+        }
+    }
+}
@@ -0,0 +1,268 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A resolution a source can deliver, at the frame rate it reports for it
+// (0 if unknown)
+struct CaptureMode
+{
+    int width = 0;
+    int height = 0;
+    double fps = 0.0;
+};
+
+// A frame in the format the device delivered it, before conversion to BGR
+struct RawFrame
+{
+    uint32_t fourcc = 0;    // cv::VideoWriter::fourcc code, e.g. MJPG or YUYV
+    int width = 0;
+    int height = 0;
+    cv::Mat data;           // compressed bytes (1 x N) or packed pixels
+};
+
+// Convert a raw frame to BGR, reusing frame's buffer when the size matches.
+// Handles MJPG/JPEG, YUYV/YUY2, UYVY, GREY and BGR3; false for anything else
+// or a corrupt frame. Thread-safe.
+bool decodeRawFrame(const RawFrame& raw, cv::Mat& frame);
+
+// "MJPG", "YUYV" and so on, for logs
+std::string fourccName(uint32_t fourcc);
+
+// Where CameraController gets its frames from. Implementations are driven
+// from the capture thread only; read() blocks until the next frame is due.
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpened() const = 0;
+
+    // Read the next frame into frame, reusing its buffer when the size
+    // matches. A source may instead hand over a buffer of its own and keep
+    // frame's old one for later frames (ParallelDecodeSource does), so
+    // callers must not count on frame's data pointer or allocator staying
+    // the same. Other Mats sharing the old buffer keep it untouched.
+    virtual bool read(cv::Mat& frame) = 0;
+
+    // Advance past the next frame without decoding it where possible
+    virtual bool grab();
+
+    // Native capture: with raw output on, readRaw() returns frames as the
+    // device produced them and leaves decoding to the caller, e.g. on a
+    // worker pool (see ParallelDecodeSource). read() still works and decodes
+    // in place. Set before open(); false if the source has no native format.
+    virtual bool setRawOutput(bool raw) { return !raw; }
+    virtual bool readRaw(RawFrame& frame);
+
+    // Returns the resolution actually in effect afterwards
+    virtual std::pair<int, int> setResolution(int width, int height) = 0;
+    virtual std::pair<int, int> resolution() const = 0;
+
+    virtual std::string description() const = 0;
+
+    // Nominal frame rate of the current mode; 0 if unknown or unthrottled
+    virtual double fps() const { return 0.0; }
+
+    // Stable key for data cached per device across runs; empty for sources
+    // that are cheap to probe and not worth caching
+    virtual std::string identity() const { return std::string(); }
+
+    // Try the common resolutions and keep those the source accepts exactly.
+    // Every attempt is a mode switch, which can be slow on real devices, so
+    // cache the result. The original resolution is restored afterwards.
+    std::vector<CaptureMode> probeModes();
+};
+
+// Create a source from a command-line style spec:
+//   "0", "1", ...                     camera by index
+//   "synthetic:1920x1080@60"          test pattern; "@0" runs unthrottled
+//   "file:/path/clip.mp4[@fps]"       video file, looped
+//   "images:/path/dir[@fps]"          directory of images, looped
+//   "mjpeg:/path/stream.mjpg[@fps]"   recorded MJPEG stream, looped
+// A bare path is treated as a directory of images, an MJPEG stream (.mjpg,
+// .mjpeg) or a video file.
+std::unique_ptr<FrameSource> createFrameSource(const std::string& spec);
+
+// Sleeps until the next frame is due at a fixed rate; 0 fps never sleeps
+class FramePacer
+{
+public:
+    explicit FramePacer(double fps = 0.0);
+
+    void setFps(double fps);
+    double fps() const { return m_fps; }
+    void reset();
+    void wait();
+
+private:
+    double m_fps;
+    std::chrono::steady_clock::time_point m_nextFrame;
+};
+
+// Physical camera through cv::VideoCapture (V4L2, DirectShow, AVFoundation)
+class CameraSource : public FrameSource
+{
+public:
+    explicit CameraSource(int cameraIndex);
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override;
+    bool read(cv::Mat& frame) override;
+    bool grab() override;
+    std::pair<int, int> setResolution(int width, int height) override;
+    std::pair<int, int> resolution() const override;
+    std::string description() const override;
+    double fps() const override;
+    std::string identity() const override;
+
+    // Asks for MJPEG with OpenCV's conversion to BGR turned off; the driver
+    // may pick another native format such as YUYV, which readRaw() reports
+    bool setRawOutput(bool raw) override;
+    bool readRaw(RawFrame& frame) override;
+
+    int cameraIndex() const { return m_cameraIndex; }
+
+private:
+    void updateNativeFormat();
+
+    int m_cameraIndex;
+    cv::VideoCapture m_capture;
+    bool m_rawOutput;
+    uint32_t m_fourcc;
+    int m_width;
+    int m_height;
+    RawFrame m_raw;
+};
+
+// Video file, rewound at the end. Paced at fps, or unthrottled at 0.
+class VideoFileSource : public FrameSource
+{
+public:
+    VideoFileSource(const std::string& path, double fps = -1.0);
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override;
+    bool read(cv::Mat& frame) override;
+    bool grab() override;
+    std::pair<int, int> setResolution(int width, int height) override;
+    std::pair<int, int> resolution() const override;
+    std::string description() const override;
+    double fps() const override { return m_pacer.fps(); }
+
+private:
+    std::string m_path;
+    double m_requestedFps;  // negative: use the file's own frame rate
+    cv::VideoCapture m_capture;
+    FramePacer m_pacer;
+    cv::Size m_outputSize;  // empty: native size
+    cv::Mat m_decoded;
+};
+
+// Recorded MJPEG stream standing in for an MJPEG camera: concatenated
+// JPEG frames, as written by ffmpeg -f mjpeg or saved from an HTTP
+// multipart stream (anything between the frames is skipped). The file is
+// read into memory on open and split at frame boundaries without decoding,
+// so raw output hands out the compressed frames exactly as a camera in
+// MJPEG mode would. Paced at fps, or unthrottled at 0.
+class MjpegFileSource : public FrameSource
+{
+public:
+    MjpegFileSource(const std::string& path, double fps = 30.0);
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override;
+    bool read(cv::Mat& frame) override;
+    bool grab() override;
+    std::pair<int, int> setResolution(int width, int height) override;
+    std::pair<int, int> resolution() const override;
+    std::string description() const override;
+    double fps() const override { return m_pacer.fps(); }
+
+    // Always available; read() decodes on the calling thread
+    bool setRawOutput(bool) override { return true; }
+    bool readRaw(RawFrame& frame) override;
+
+    size_t frameCount() const { return m_frames.size(); }
+
+private:
+    std::string m_path;
+    cv::Mat m_data;                                 // whole file, 1 x N
+    std::vector<std::pair<size_t, size_t>> m_frames; // offset, length
+    size_t m_next;
+    int m_width;
+    int m_height;
+    FramePacer m_pacer;
+    RawFrame m_raw;
+};
+
+// Directory of still images played back in name order, looped. Images are
+// decoded once on open so playback measures the pipeline, not the disk.
+class ImageSequenceSource : public FrameSource
+{
+public:
+    ImageSequenceSource(const std::string& directory, double fps = 30.0);
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override;
+    bool read(cv::Mat& frame) override;
+    bool grab() override;
+    std::pair<int, int> setResolution(int width, int height) override;
+    std::pair<int, int> resolution() const override;
+    std::string description() const override;
+    double fps() const override { return m_pacer.fps(); }
+
+private:
+    std::string m_directory;
+    std::vector<cv::Mat> m_frames;
+    size_t m_next;
+    FramePacer m_pacer;
+};
+
+// Deterministic moving test pattern. Each frame is a shifted window onto a
+// precomputed pattern, so generation costs one memcpy per frame; the frame
+// number is stamped into the first 8 bytes for drop detection.
+class SyntheticSource : public FrameSource
+{
+public:
+    SyntheticSource(int width = 640, int height = 480, double fps = 30.0);
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override;
+    bool read(cv::Mat& frame) override;
+    bool grab() override;
+    std::pair<int, int> setResolution(int width, int height) override;
+    std::pair<int, int> resolution() const override;
+    std::string description() const override;
+    double fps() const override { return m_pacer.fps(); }
+
+    static uint64_t frameNumber(const cv::Mat& frame);
+
+private:
+    void buildPattern();
+
+    static const int PATTERN_PERIOD = 256;
+
+    int m_width;
+    int m_height;
+    bool m_opened;
+    uint64_t m_frameNumber;
+    cv::Mat m_pattern;
+    FramePacer m_pacer;
+};
+
+#endif // FRAMESOURCE_H
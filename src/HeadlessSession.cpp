@@ -0,0 +1,422 @@
+#include "HeadlessSession.h"
+#include "FrameAllocator.h"
+#include <QCoreApplication>
+#include <algorithm>
+#include <thread>
+#include <QDebug>
+
+HeadlessSession::HeadlessSession(const QStringList& sourceSpecs, QObject* parent)
+    : QObject(parent)
+    , m_sourceSpecs(sourceSpecs)
+    , m_reprobeDevices(false)
+    , m_running(false)
+    , m_consumeQueued(false)
+    , m_lastConsumedSequence(-1)
+    , m_record(false)
+    , m_burstFrames(0)
+    , m_snapshotFormat(BurstWriter::Format::Png)
+    , m_streamListener(0)
+    , m_durationSeconds(0)
+    , m_statusTimer(new QTimer(this))
+    , m_metricsDumpTimer(new QTimer(this))
+    , m_metricsDumpCsv(false)
+{
+    for (int i = 0; i < sourceSpecs.size(); ++i) {
+        m_cameraControllers.push_back(std::make_unique<CameraController>());
+    }
+    connect(m_statusTimer, &QTimer::timeout, this, &HeadlessSession::logStatus);
+    connect(m_metricsDumpTimer, &QTimer::timeout, this, &HeadlessSession::dumpMetrics);
+}
+
+HeadlessSession::~HeadlessSession()
+{
+    stop();
+}
+
+void HeadlessSession::setCaptureMode(int width, int height)
+{
+    m_captureMode = CaptureMode{width, height, 0.0};
+}
+
+void HeadlessSession::setReprobeDevices(bool reprobe)
+{
+    m_reprobeDevices = reprobe;
+}
+
+void HeadlessSession::setHistoryBudget(int megabytes)
+{
+    for (auto& camera : m_cameraControllers) {
+        camera->setHistoryBudget(static_cast<size_t>(std::max(0, megabytes)));
+    }
+}
+
+void HeadlessSession::setChangeThreshold(double threshold)
+{
+    for (auto& camera : m_cameraControllers) {
+        camera->setChangeThreshold(threshold);
+    }
+}
+
+void HeadlessSession::setDecodeThreads(int threads)
+{
+    for (auto& camera : m_cameraControllers) {
+        camera->setDecodeThreads(threads);
+    }
+}
+
+bool HeadlessSession::enableDiskHistory(const QString& directory, int megabytes)
+{
+    QString error = setUpDiskHistory(m_cameraControllers, directory, megabytes);
+    if (!error.isEmpty()) {
+        qWarning("%s", qPrintable(error));
+        return false;
+    }
+    return true;
+}
+
+bool HeadlessSession::enableSharedFrames(const QString& name)
+{
+    QString error = setUpSharedFrames(m_cameraControllers, name);
+    if (!error.isEmpty()) {
+        qWarning("%s", qPrintable(error));
+        return false;
+    }
+    return true;
+}
+
+bool HeadlessSession::setProcessingChain(const QString& chain)
+{
+    QString error = setUpProcessing(m_cameraControllers, chain);
+    if (!error.isEmpty()) {
+        qWarning("%s", qPrintable(error));
+        return false;
+    }
+    return true;
+}
+
+void HeadlessSession::setRecordingOptions(const QString& directory, int queueFrames, Recorder::DropPolicy policy)
+{
+    m_recordOptions.directory = directory;
+    m_recordOptions.queueFrames = queueFrames > 0 ? queueFrames : 30;
+    m_recordOptions.policy = policy;
+}
+
+void HeadlessSession::setRecording(bool record)
+{
+    m_record = record;
+}
+
+void HeadlessSession::setBurst(int frames, const QString& directory, BurstWriter::Format format)
+{
+    m_burstFrames = std::max(0, frames);
+    m_snapshotDirectory = directory;
+    m_snapshotFormat = format;
+}
+
+void HeadlessSession::setDuration(int seconds)
+{
+    m_durationSeconds = std::max(0, seconds);
+}
+
+void HeadlessSession::openCamera(CameraController& camera, const QString& spec)
+{
+    // Runs on an initialization thread; the cache is safe to share
+    std::unique_ptr<FrameSource> source = createFrameSource(spec.toStdString());
+    std::string device = source->identity();
+
+    // Open straight into the requested mode, or the one the device was last
+    // used in. Modes are never probed here: that takes seconds on real
+    // cameras and only the GUI's resolution list needs them.
+    CaptureMode mode = m_captureMode;
+    DeviceCapabilityCache::Entry entry;
+    if (mode.width <= 0 && !device.empty() && !m_reprobeDevices && m_capabilityCache.lookup(device, entry)) {
+        mode = entry.lastMode;
+    }
+    camera.initialize(std::move(source), mode);
+}
+
+bool HeadlessSession::start()
+{
+    if (m_running) {
+        return true;
+    }
+    int64_t startTime = PipelineMetrics::now();
+
+    // Opening a camera can take hundreds of milliseconds, so all of them
+    // are opened at once
+    std::vector<std::thread> threads;
+    std::vector<QString> errors(m_sourceSpecs.size());
+    for (int i = 0; i < m_sourceSpecs.size(); ++i) {
+        threads.emplace_back([this, i, &errors] {
+            try {
+                openCamera(*m_cameraControllers[i], m_sourceSpecs[i]);
+            }
+            catch (const std::exception& e) {
+                errors[i] = QString("%1: %2").arg(m_sourceSpecs[i]).arg(e.what());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    QStringList failed;
+    for (const QString& error : errors) {
+        if (!error.isEmpty()) {
+            failed << error;
+        }
+    }
+    if (!failed.isEmpty() || m_cameraControllers.empty()) {
+        qWarning("Failed to open camera: %s", qPrintable(failed.join("; ")));
+        return false;
+    }
+
+    try {
+        for (auto& camera : m_cameraControllers) {
+            // Same pacing as the GUI: at most one pick-up queued at a time
+            camera->setFrameReadyCallback([this] {
+                if (!m_consumeQueued.exchange(true)) {
+                    QMetaObject::invokeMethod(this, &HeadlessSession::consumeFrames, Qt::QueuedConnection);
+                }
+            });
+            camera->start();
+        }
+    }
+    catch (const std::exception& e) {
+        qWarning("Failed to start camera: %s", e.what());
+        stop();
+        return false;
+    }
+    m_running = true;
+
+    if (m_record && !startRecording()) {
+        stop();
+        return false;
+    }
+    if (m_burstFrames > 0) {
+        QString directory;
+        QString error = startBursts(m_cameraControllers, m_snapshotDirectory, m_snapshotFormat, m_burstFrames,
+                                    m_burstWriters, directory);
+        if (!error.isEmpty()) {
+            qWarning("%s", qPrintable(error));
+            stop();
+            return false;
+        }
+        qInfo("Saving a burst of %d frames to %s", m_burstFrames, qPrintable(directory));
+    }
+    if (m_streamServer) {
+        MjpegServer* server = m_streamServer.get();
+        m_streamListener = m_cameraControllers.front()->addFrameListener(
+            [server](const cv::Mat& frame, int64_t, int64_t) { server->pushFrame(frame); });
+    }
+
+    auto resolution = m_cameraControllers.front()->getCurrentResolution();
+    qInfo("Capturing from %d camera(s) at %dx%d, ready in %.0f ms",
+          static_cast<int>(m_cameraControllers.size()), resolution.first, resolution.second,
+          (PipelineMetrics::now() - startTime) / 1e6);
+
+    m_statusTimer->start(10000);
+    if (m_durationSeconds > 0) {
+        QTimer::singleShot(m_durationSeconds * 1000, QCoreApplication::instance(), &QCoreApplication::quit);
+    }
+    return true;
+}
+
+void HeadlessSession::stop()
+{
+    m_statusTimer->stop();
+    m_metricsDumpTimer->stop();
+
+    // Detach from the capture threads before anything they push to goes away
+    for (auto& camera : m_cameraControllers) {
+        camera->setFrameReadyCallback(nullptr);
+    }
+    for (size_t i = 0; i < m_recordListeners.size(); ++i) {
+        m_cameraControllers[i]->removeFrameListener(m_recordListeners[i]);
+    }
+    m_recordListeners.clear();
+    if (m_streamListener != 0) {
+        m_cameraControllers.front()->removeFrameListener(m_streamListener);
+        m_streamListener = 0;
+    }
+
+    if (m_running) {
+        // Frames already handed to the burst writers are saved; a burst
+        // still capturing is cut short
+        for (auto& writer : m_burstWriters) {
+            writer->waitIdle();
+        }
+        logSummary();
+        m_running = false;
+    }
+
+    for (auto& recorder : m_recorders) {
+        recorder->stop();
+    }
+    m_recorders.clear();
+    m_streamServer.reset();
+    for (auto& camera : m_cameraControllers) {
+        camera->stop();
+    }
+}
+
+bool HeadlessSession::startRecording()
+{
+    QStringList files;
+    QString error = startRecorders(m_cameraControllers, m_recordOptions, m_recorders, m_recordListeners, files);
+    if (!error.isEmpty()) {
+        qWarning("%s", qPrintable(error));
+        return false;
+    }
+    for (const QString& path : files) {
+        qInfo("Recording to %s", qPrintable(path));
+    }
+    return true;
+}
+
+bool HeadlessSession::startStreaming(quint16 port)
+{
+    m_streamServer = std::make_unique<MjpegServer>();
+    if (!m_streamServer->start(port)) {
+        m_streamServer.reset();
+        qWarning("Cannot serve the MJPEG stream on port %u", port);
+        return false;
+    }
+
+    // Attached to the first camera by start(), or now if it is running
+    if (m_running && m_streamListener == 0) {
+        MjpegServer* server = m_streamServer.get();
+        m_streamListener = m_cameraControllers.front()->addFrameListener(
+            [server](const cv::Mat& frame, int64_t, int64_t) { server->pushFrame(frame); });
+    }
+    qInfo("Streaming MJPEG on port %u at /stream", m_streamServer->port());
+    return true;
+}
+
+bool HeadlessSession::setMetricsDump(const QString& path, int intervalMs)
+{
+    m_metricsDumpTimer->stop();
+    if (m_metricsDumpFile.isOpen()) {
+        m_metricsDumpFile.close();
+    }
+
+    m_metricsDumpFile.setFileName(path);
+    if (!m_metricsDumpFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning("Cannot open metrics dump file %s", qPrintable(path));
+        return false;
+    }
+
+    m_metricsDumpCsv = path.endsWith(".csv", Qt::CaseInsensitive);
+    if (m_metricsDumpCsv) {
+        m_metricsDumpFile.write(PipelineMetrics::csvHeader().c_str());
+        m_metricsDumpFile.write("\n");
+    }
+
+    m_metricsDumpTimer->start(intervalMs > 0 ? intervalMs : 1000);
+    return true;
+}
+
+void HeadlessSession::consumeFrames()
+{
+    m_consumeQueued = false;
+    if (!m_running) {
+        return;
+    }
+
+    try {
+        for (auto& camera : m_cameraControllers) {
+            camera->getCurrentMat();
+        }
+    }
+    catch (const std::exception& e) {
+        qWarning("Capture failed: %s", e.what());
+        QCoreApplication::exit(1);
+        return;
+    }
+
+    // Pick-up of each new frame of the first camera counts as displayed,
+    // and capture to pick-up as end-to-end latency
+    CameraController& camera = *m_cameraControllers.front();
+    int64_t sequence = camera.currentSequence();
+    if (sequence > m_lastConsumedSequence) {
+        m_lastConsumedSequence = sequence;
+        int64_t now = PipelineMetrics::now();
+        camera.metrics().record(PipelineMetrics::EndToEnd, now - camera.currentFrameTimestamp());
+        camera.metrics().frameDisplayed(now);
+    }
+}
+
+void HeadlessSession::dumpMetrics()
+{
+    PipelineMetrics::Snapshot snapshot = m_cameraControllers.front()->metrics().snapshot();
+    std::string line = m_metricsDumpCsv ? PipelineMetrics::toCsv(snapshot) : PipelineMetrics::toJson(snapshot);
+    m_metricsDumpFile.write(line.c_str());
+    m_metricsDumpFile.write("\n");
+    m_metricsDumpFile.flush();
+}
+
+void HeadlessSession::logStatus()
+{
+    PipelineMetrics::Snapshot snapshot = m_cameraControllers.front()->metrics().snapshot();
+    qInfo("%.0f s: device %.1f fps, %llu frames, %llu dropped",
+          snapshot.uptimeSeconds, snapshot.captureFps,
+          static_cast<unsigned long long>(snapshot.framesCaptured),
+          static_cast<unsigned long long>(snapshot.framesDropped));
+}
+
+void HeadlessSession::logSummary()
+{
+    for (size_t i = 0; i < m_cameraControllers.size(); ++i) {
+        PipelineMetrics::Snapshot snapshot = m_cameraControllers[i]->metrics().snapshot();
+        const auto& capture = snapshot.stages[PipelineMetrics::Capture];
+        qInfo("camera %d: %llu frames in %.1f s, device %.1f fps (jitter %.2f ms), capture p50/p99 %.2f/%.2f ms",
+              static_cast<int>(i), static_cast<unsigned long long>(snapshot.framesCaptured),
+              snapshot.uptimeSeconds, snapshot.captureFps, snapshot.captureJitterMs,
+              capture.p50Ms, capture.p99Ms);
+        if (i == 0) {
+            const auto& endToEnd = snapshot.stages[PipelineMetrics::EndToEnd];
+            qInfo("  picked up %.1f fps, %llu dropped, capture to pick-up p50/p95/p99 %.2f/%.2f/%.2f ms",
+                  snapshot.displayFps, static_cast<unsigned long long>(snapshot.framesDropped),
+                  endToEnd.p50Ms, endToEnd.p95Ms, endToEnd.p99Ms);
+        }
+        ParallelDecodeSource::Stats decoding = m_cameraControllers[i]->decodeStats();
+        if (decoding.threads > 0) {
+            qInfo("  decode: %s on %d threads, %.2f ms per frame, %llu corrupt frames skipped",
+                  fourccName(decoding.fourcc).c_str(), decoding.threads, decoding.decodeMs,
+                  static_cast<unsigned long long>(decoding.failed));
+        }
+        if (std::shared_ptr<FrameGraph> graph = m_cameraControllers[i]->processingGraph()) {
+            FrameGraph::Stats processing = graph->stats();
+            qInfo("  processing: %.2f ms mean latency, %llu frames dropped",
+                  processing.latencyMs, static_cast<unsigned long long>(processing.rejected));
+        }
+    }
+    FrameAllocator::Stats pool = FrameAllocator::instance()->stats();
+    if (pool.allocations > 0) {
+        qInfo("frame pool: %llu buffers handed out, %.1f%% reused, %llu from the system (%llu on huge pages), "
+              "%llu given back, %.0f MB free",
+              static_cast<unsigned long long>(pool.allocations), 100.0 * pool.reused / pool.allocations,
+              static_cast<unsigned long long>(pool.systemAllocations),
+              static_cast<unsigned long long>(pool.hugePageBlocks),
+              static_cast<unsigned long long>(pool.systemFrees), pool.bytesPooled / (1024.0 * 1024.0));
+    }
+    for (size_t i = 0; i < m_recorders.size(); ++i) {
+        Recorder::Stats stats = m_recorders[i]->stats();
+        qInfo("recording %d: %llu frames encoded, %llu dropped, %.1f s",
+              static_cast<int>(i), static_cast<unsigned long long>(stats.framesEncoded),
+              static_cast<unsigned long long>(stats.framesDropped), stats.secondsRecorded);
+    }
+    for (size_t i = 0; i < m_burstWriters.size(); ++i) {
+        BurstWriter::Stats stats = m_burstWriters[i]->stats();
+        qInfo("burst %d: %llu of %d frames written at %.1f fps, %.0f MB/s, %llu dropped, %llu failed",
+              static_cast<int>(i), static_cast<unsigned long long>(stats.written), m_burstFrames,
+              stats.fps, stats.mbPerSecond, static_cast<unsigned long long>(stats.dropped),
+              static_cast<unsigned long long>(stats.failed));
+    }
+    if (m_streamServer) {
+        MjpegServer::Stats stats = m_streamServer->stats();
+        qInfo("stream: %llu frames encoded, %llu sent, %llu skipped for slow clients",
+              static_cast<unsigned long long>(stats.framesEncoded),
+              static_cast<unsigned long long>(stats.framesSent),
+              static_cast<unsigned long long>(stats.framesSkipped));
+    }
+}
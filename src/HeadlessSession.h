@@ -0,0 +1,110 @@
+#ifndef HEADLESSSESSION_H
+#define HEADLESSSESSION_H
+
+#include <QObject>
+#include <QFile>
+#include <QStringList>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "CameraController.h"
+#include "CameraSetup.h"
+#include "DeviceCapabilityCache.h"
+#include "MjpegServer.h"
+#include "Recorder.h"
+
+// The capture pipeline without the widget stack, for display-less capture
+// nodes. Runs under QCoreApplication: cameras are opened and started
+// straight away, and frames go to recording, streaming, shared memory and
+// the metrics dump only. Takes the same settings as MainWindow.
+class HeadlessSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeadlessSession(const QStringList& sourceSpecs = QStringList() << "0", QObject* parent = nullptr);
+    ~HeadlessSession();
+
+    // Settings, before start()
+    void setCaptureMode(int width, int height);
+    void setReprobeDevices(bool reprobe);
+    void setHistoryBudget(int megabytes);
+    void setChangeThreshold(double threshold);
+    void setDecodeThreads(int threads);
+    bool enableDiskHistory(const QString& directory, int megabytes);
+    bool enableSharedFrames(const QString& name);
+    bool setProcessingChain(const QString& chain);
+    void setRecordingOptions(const QString& directory, int queueFrames, Recorder::DropPolicy policy);
+
+    // Record every camera from start() until the session stops
+    void setRecording(bool record);
+
+    // Save a burst of the next frames from every camera once started, to
+    // directory (empty for the Pictures folder); 0 frames takes none
+    void setBurst(int frames, const QString& directory, BurstWriter::Format format);
+
+    // Quit the application after seconds; 0 runs until interrupted
+    void setDuration(int seconds);
+
+    // Open and start every camera, then recording, streaming and the
+    // metrics dump. False if a camera could not be opened.
+    bool start();
+
+    // Stop everything and log a summary; also run on destruction
+    void stop();
+
+    // Serve the first camera as MJPEG over HTTP on port
+    bool startStreaming(quint16 port);
+
+    // Append a metrics snapshot to path every intervalMs (CSV for *.csv, JSON lines otherwise)
+    bool setMetricsDump(const QString& path, int intervalMs);
+
+private slots:
+    void consumeFrames();
+    void dumpMetrics();
+    void logStatus();
+
+private:
+    void openCamera(CameraController& camera, const QString& spec);
+    bool startRecording();
+    void logSummary();
+
+    std::vector<std::unique_ptr<CameraController>> m_cameraControllers;
+    QStringList m_sourceSpecs;
+    CaptureMode m_captureMode;
+    DeviceCapabilityCache m_capabilityCache;
+    bool m_reprobeDevices;
+    bool m_running;
+
+    // Stands in for the display: picks up each new frame without converting
+    // it, so processed output is collected and the display-side metrics
+    // measure how far behind capture the consumers are
+    std::atomic<bool> m_consumeQueued;
+    int64_t m_lastConsumedSequence;
+
+    // Recording, one file per camera
+    bool m_record;
+    std::vector<std::unique_ptr<Recorder>> m_recorders;
+    std::vector<int> m_recordListeners;
+    RecordingOptions m_recordOptions;
+
+    // Burst at start, one writer per camera
+    int m_burstFrames;
+    QString m_snapshotDirectory;
+    BurstWriter::Format m_snapshotFormat;
+    std::vector<std::shared_ptr<BurstWriter>> m_burstWriters;
+
+    // MJPEG streaming of the first camera
+    std::unique_ptr<MjpegServer> m_streamServer;
+    int m_streamListener;
+
+    int m_durationSeconds;
+    QTimer* m_statusTimer;
+    QTimer* m_metricsDumpTimer;
+    QFile m_metricsDumpFile;
+    bool m_metricsDumpCsv;
+};
+
+#endif // HEADLESSSESSION_H
@@ -1,24 +1,50 @@
 #include "MainWindow.h"
+#include "FrameAllocator.h"
 #include <QApplication>
 #include <QScreen>
+#include <QSignalBlocker>
+#include <algorithm>
+#include <cmath>
+#include <QDebug>
 
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(const QStringList& sourceSpecs, QWidget *parent)
     : QMainWindow(parent)
     , m_centralWidget(nullptr)
-    , m_cameraLabel(nullptr)
+    , m_videoWidget(nullptr)
     , m_playButton(nullptr)
     , m_pauseButton(nullptr)
     , m_resumeButton(nullptr)
     , m_forwardButton(nullptr)
     , m_rewindButton(nullptr)
+    , m_liveButton(nullptr)
+    , m_recordButton(nullptr)
+    , m_burstButton(nullptr)
+    , m_burstFramesSpin(nullptr)
     , m_resolutionCombo(nullptr)
     , m_currentResolutionLabel(nullptr)
+    , m_historyBudgetSpin(nullptr)
+    , m_changeThresholdSpin(nullptr)
     , m_controlsGroup(nullptr)
     , m_settingsGroup(nullptr)
-    , m_cameraController(std::make_unique<CameraController>())
-    , m_frameTimer(new QTimer(this))
+    , m_cameraController(nullptr)
+    , m_reprobeDevices(false)
+    , m_pendingInits(0)
+    , m_frameUpdateQueued(false)
+    , m_recordLabel(nullptr)
+    , m_recordTimer(new QTimer(this))
+    , m_snapshotFormat(BurstWriter::Format::Png)
+    , m_burstLabel(nullptr)
+    , m_burstTimer(new QTimer(this))
+    , m_streamCamera(nullptr)
+    , m_streamListener(0)
+    , m_metricsLabel(nullptr)
+    , m_metricsTimer(new QTimer(this))
+    , m_metricsDumpTimer(new QTimer(this))
+    , m_metricsDumpCsv(false)
+    , m_lastPaintedSequence(-1)
+    , m_reportedModeSwitches(0)
 {
-    // Initialize resolution options
+    // Fallback resolution options, replaced by the modes the camera reports
     m_resolutions = {
         {640, 480, "640x480 (VGA)"},
         {1280, 720, "1280x720 (HD)"},
@@ -44,25 +70,226 @@ MainWindow::MainWindow(QWidget *parent)
         move(x, y);
     }
     
-    // Initialize camera with default resolution
-    try {
-        m_cameraController->initialize(0); // Default camera index
-        m_cameraController->setResolution(640, 480);
-        updateControlsState();
-        statusBar()->showMessage("Camera initialized successfully", 3000);
+    // One controller per source, opened in the background once the event
+    // loop runs so the window shows up straight away
+    m_sourceSpecs = sourceSpecs;
+    for (int i = 0; i < sourceSpecs.size(); ++i) {
+        m_cameraControllers.push_back(std::make_unique<CameraController>());
     }
-    catch (const std::exception& e) {
-        showErrorMessage(QString("Failed to initialize camera: %1").arg(e.what()));
+    if (m_cameraControllers.empty()) {
+        // Keep an uninitialized controller so the controls have something to query
+        m_cameraControllers.push_back(std::make_unique<CameraController>());
     }
+    m_cameraController = m_cameraControllers.front().get();
+    updateControlsState();
+    
+    QMetaObject::invokeMethod(this, &MainWindow::initializeCameras, Qt::QueuedConnection);
 }
 
 MainWindow::~MainWindow()
 {
-    if (m_frameTimer->isActive()) {
-        m_frameTimer->stop();
+    for (auto& thread : m_initThreads) {
+        thread.join();
+    }
+    // Detach from the capture threads before anything they post to goes away
+    stopFrameUpdates();
+    if (m_recordButton->isChecked()) {
+        onRecordToggled(false);
+    }
+    if (m_streamCamera) {
+        m_streamCamera->removeFrameListener(m_streamListener);
+    }
+    m_streamServer.reset();
+    forEachCamera([](CameraController& camera) { camera.stop(); });
+}
+
+void MainWindow::initializeCameras()
+{
+    if (m_sourceSpecs.isEmpty()) {
+        return;
+    }
+    
+    // Opening a camera and switching its mode can each take hundreds of
+    // milliseconds, so every camera is opened on a thread of its own
+    statusBar()->showMessage("Opening camera...");
+    m_pendingInits = m_sourceSpecs.size();
+    m_initErrors.clear();
+    m_cameraModes.assign(m_sourceSpecs.size(), std::vector<CaptureMode>());
+    for (int i = 0; i < m_sourceSpecs.size(); ++i) {
+        m_initThreads.emplace_back([this, i] {
+            std::vector<CaptureMode> modes;
+            QString error;
+            try {
+                modes = initializeCamera(*m_cameraControllers[i], m_sourceSpecs[i]);
+            }
+            catch (const std::exception& e) {
+                error = QString("%1: %2").arg(m_sourceSpecs[i]).arg(e.what());
+            }
+            QMetaObject::invokeMethod(this, [this, i, modes, error] {
+                onCameraInitialized(i, modes, error);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+std::vector<CaptureMode> MainWindow::initializeCamera(CameraController& camera, const QString& spec)
+{
+    // Runs on an initialization thread; the cache is safe to share
+    std::unique_ptr<FrameSource> source = createFrameSource(spec.toStdString());
+    std::string device = source->identity();
+    
+    DeviceCapabilityCache::Entry entry;
+    if (!device.empty() && !m_reprobeDevices && m_capabilityCache.lookup(device, entry)) {
+        // Known device: open straight into the mode it was last used in
+        camera.initialize(std::move(source), entry.lastMode);
+        return entry.modes;
+    }
+    
+    camera.initialize(std::move(source));
+    entry.modes = camera.probeCaptureModes();
+    auto current = camera.getCurrentResolution();
+    entry.lastMode = CaptureMode{current.first, current.second, 0.0};
+    if (!device.empty()) {
+        m_capabilityCache.store(device, entry);
+        m_capabilityCache.save();
+    }
+    return entry.modes;
+}
+
+void MainWindow::onCameraInitialized(int index, const std::vector<CaptureMode>& modes, const QString& error)
+{
+    if (!error.isEmpty()) {
+        m_initErrors << error;
+    }
+    m_cameraModes[index] = modes;
+    if (--m_pendingInits > 0) {
+        return;
+    }
+    
+    for (auto& thread : m_initThreads) {
+        thread.join();
+    }
+    m_initThreads.clear();
+    
+    // The first camera that opened drives the combo box; drop the others
+    // that failed
+    std::vector<CaptureMode> primaryModes;
+    for (size_t i = 0; i < m_cameraControllers.size(); ++i) {
+        if (m_cameraControllers[i]->isInitialized()) {
+            primaryModes = m_cameraModes[i];
+            break;
+        }
+    }
+    m_cameraModes.clear();
+    m_cameraControllers.erase(std::remove_if(m_cameraControllers.begin(), m_cameraControllers.end(),
+                                             [](const auto& camera) { return !camera->isInitialized(); }),
+                              m_cameraControllers.end());
+    if (m_cameraControllers.empty()) {
+        m_cameraControllers.push_back(std::make_unique<CameraController>());
+    }
+    m_cameraController = m_cameraControllers.front().get();
+    
+    if (m_cameraControllers.size() > 1) {
+        setWindowTitle(QString("Qt Camera Application (%1 cameras)").arg(m_cameraControllers.size()));
+    }
+    
+    attachStream();
+    
+    if (m_cameraController->isInitialized()) {
+        try {
+            setResolutionModes(primaryModes);
+            syncResolutionSelection();
+            statusBar()->showMessage("Camera initialized successfully", 3000);
+        }
+        catch (const std::exception& e) {
+            m_initErrors << e.what();
+        }
+    }
+    else {
+        statusBar()->clearMessage();
+    }
+    updateControlsState();
+    
+    if (!m_initErrors.isEmpty()) {
+        showErrorMessage(QString("Failed to initialize camera: %1").arg(m_initErrors.join("\n")));
+    }
+}
+
+void MainWindow::setResolutionModes(const std::vector<CaptureMode>& modes)
+{
+    // Keep the default list for sources that reported nothing
+    if (modes.empty()) {
+        return;
+    }
+    
+    m_resolutions.clear();
+    for (const CaptureMode& mode : modes) {
+        QString name = QString("%1x%2").arg(mode.width).arg(mode.height);
+        if (mode.fps > 0.0) {
+            name += QString(" @ %1 fps").arg(mode.fps, 0, 'g', 3);
+        }
+        m_resolutions.push_back({mode.width, mode.height, name});
+    }
+    
+    QSignalBlocker blocker(m_resolutionCombo);
+    m_resolutionCombo->clear();
+    for (const auto& res : m_resolutions) {
+        m_resolutionCombo->addItem(res.name);
+    }
+}
+
+void MainWindow::rememberCaptureMode()
+{
+    // Next launch opens each camera straight into its current mode
+    bool changed = false;
+    forEachCamera([this, &changed](CameraController& camera) {
+        auto current = camera.getCurrentResolution();
+        changed |= m_capabilityCache.setLastMode(camera.deviceIdentity(),
+                                                 CaptureMode{current.first, current.second, 0.0});
+    });
+    if (changed) {
+        m_capabilityCache.save();
+    }
+}
+
+bool MainWindow::startStreaming(quint16 port)
+{
+    m_streamServer = std::make_unique<MjpegServer>();
+    if (!m_streamServer->start(port)) {
+        m_streamServer.reset();
+        showErrorMessage(QString("Cannot serve the MJPEG stream on port %1").arg(port));
+        return false;
+    }
+    attachStream();
+    return true;
+}
+
+void MainWindow::attachStream()
+{
+    // Wait for the cameras to open; the first one that did is streamed
+    if (!m_streamServer || m_pendingInits > 0 || !m_cameraController->isInitialized()) {
+        return;
     }
-    if (m_cameraController) {
-        m_cameraController->stop();
+    if (m_streamCamera) {
+        m_streamCamera->removeFrameListener(m_streamListener);
+    }
+    
+    MjpegServer* server = m_streamServer.get();
+    m_streamCamera = m_cameraController;
+    m_streamListener = m_streamCamera->addFrameListener(
+        [server](const cv::Mat& frame, int64_t, int64_t) { server->pushFrame(frame); });
+    statusBar()->showMessage(QString("Streaming MJPEG on port %1 at /stream").arg(m_streamServer->port()), 3000);
+}
+
+void MainWindow::setReprobeDevices(bool reprobe)
+{
+    m_reprobeDevices = reprobe;
+}
+
+void MainWindow::forEachCamera(const std::function<void(CameraController&)>& action)
+{
+    for (auto& controller : m_cameraControllers) {
+        action(*controller);
     }
 }
 
@@ -75,12 +302,11 @@ void MainWindow::setupUI()
     QVBoxLayout* mainLayout = new QVBoxLayout(m_centralWidget);
     
     // Camera display area
-    m_cameraLabel = new QLabel(this);
-    m_cameraLabel->setMinimumSize(640, 480);
-    m_cameraLabel->setStyleSheet("QLabel { background-color: black; border: 2px solid gray; }");
-    m_cameraLabel->setAlignment(Qt::AlignCenter);
-    m_cameraLabel->setText("Camera feed will appear here");
-    m_cameraLabel->setScaledContents(true);
+    m_videoWidget = new VideoWidget(this);
+    m_videoWidget->setMinimumSize(640, 480);
+    m_videoWidget->setPlaceholderText("Camera feed will appear here");
+    m_videoWidget->setPaintCallback([this](int64_t start, int64_t end) { recordPaint(start, end); });
+    m_videoWidget->setZoomCallback([this](double steps, double x, double y) { zoomView(steps, x, y); });
     
     // Controls group
     m_controlsGroup = new QGroupBox("Playback Controls", this);
@@ -91,6 +317,19 @@ void MainWindow::setupUI()
     m_resumeButton = new QPushButton("Resume", this);
     m_forwardButton = new QPushButton("Forward", this);
     m_rewindButton = new QPushButton("Rewind", this);
+    m_liveButton = new QPushButton("Live", this);
+    m_recordButton = new QPushButton("Record", this);
+    m_recordButton->setCheckable(true);
+    m_burstButton = new QPushButton("Burst", this);
+    m_burstButton->setToolTip("Save full-resolution snapshots of the next frames, "
+                              "or of the whole raw frame buffer");
+    
+    m_burstFramesSpin = new QSpinBox(this);
+    m_burstFramesSpin->setRange(0, 1000);
+    m_burstFramesSpin->setSpecialValueText("Buffer");
+    m_burstFramesSpin->setSuffix(" frames");
+    m_burstFramesSpin->setValue(10);
+    m_burstFramesSpin->setToolTip("Frames per burst; Buffer saves the frames already in the raw frame buffer");
     
     // Style buttons
     QString buttonStyle = "QPushButton { "
@@ -108,12 +347,19 @@ void MainWindow::setupUI()
     m_resumeButton->setStyleSheet(buttonStyle);
     m_forwardButton->setStyleSheet(buttonStyle);
     m_rewindButton->setStyleSheet(buttonStyle);
+    m_liveButton->setStyleSheet(buttonStyle);
+    m_recordButton->setStyleSheet(buttonStyle + " QPushButton:checked { color: red; }");
+    m_burstButton->setStyleSheet(buttonStyle);
     
     controlsLayout->addWidget(m_playButton);
     controlsLayout->addWidget(m_pauseButton);
     controlsLayout->addWidget(m_resumeButton);
     controlsLayout->addWidget(m_forwardButton);
     controlsLayout->addWidget(m_rewindButton);
+    controlsLayout->addWidget(m_liveButton);
+    controlsLayout->addWidget(m_recordButton);
+    controlsLayout->addWidget(m_burstButton);
+    controlsLayout->addWidget(m_burstFramesSpin);
     controlsLayout->addStretch();
     
     // Settings group
@@ -131,12 +377,34 @@ void MainWindow::setupUI()
     m_currentResolutionLabel = new QLabel("Current: 640x480", this);
     m_currentResolutionLabel->setStyleSheet("QLabel { font-weight: bold; color: blue; }");
     
+    m_historyBudgetSpin = new QSpinBox(this);
+    m_historyBudgetSpin->setRange(16, 16384);
+    m_historyBudgetSpin->setSingleStep(64);
+    m_historyBudgetSpin->setSuffix(" MB");
+    m_historyBudgetSpin->setValue(static_cast<int>(CompressedHistory::DEFAULT_BUDGET_MB));
+    m_historyBudgetSpin->setToolTip("Memory used for compressed rewind history");
+    
+    m_changeThresholdSpin = new QDoubleSpinBox(this);
+    m_changeThresholdSpin->setRange(0.0, 64.0);
+    m_changeThresholdSpin->setSingleStep(0.5);
+    m_changeThresholdSpin->setDecimals(1);
+    m_changeThresholdSpin->setSpecialValueText("Off");
+    m_changeThresholdSpin->setValue(0.0);
+    m_changeThresholdSpin->setToolTip("Frames that differ from the last one kept by less than this many grey levels "
+                                      "are skipped: static scenes are not converted or repainted");
+    
     settingsLayout->addWidget(m_resolutionCombo);
     settingsLayout->addWidget(m_currentResolutionLabel);
+    settingsLayout->addSpacing(20);
+    settingsLayout->addWidget(new QLabel("Rewind buffer:", this));
+    settingsLayout->addWidget(m_historyBudgetSpin);
+    settingsLayout->addSpacing(20);
+    settingsLayout->addWidget(new QLabel("Change threshold:", this));
+    settingsLayout->addWidget(m_changeThresholdSpin);
     settingsLayout->addStretch();
     
     // Add to main layout
-    mainLayout->addWidget(m_cameraLabel, 1);
+    mainLayout->addWidget(m_videoWidget, 1);
     mainLayout->addWidget(m_controlsGroup);
     mainLayout->addWidget(m_settingsGroup);
 }
@@ -151,6 +419,20 @@ void MainWindow::setupMenuBar()
     exitAction->setShortcut(QKeySequence::Quit);
     connect(exitAction, &QAction::triggered, this, &QWidget::close);
     
+    // View menu
+    QMenu* viewMenu = menuBar->addMenu("&View");
+    QAction* metricsAction = viewMenu->addAction("Show &Pipeline Metrics");
+    metricsAction->setCheckable(true);
+    connect(metricsAction, &QAction::toggled, [this](bool checked) {
+        m_metricsLabel->setVisible(checked);
+        if (checked) {
+            updateMetricsPanel();
+            m_metricsTimer->start(500);
+        } else {
+            m_metricsTimer->stop();
+        }
+    });
+    
     // Help menu
     QMenu* helpMenu = menuBar->addMenu("&Help");
     QAction* aboutAction = helpMenu->addAction("&About");
@@ -165,6 +447,21 @@ void MainWindow::setupMenuBar()
 void MainWindow::setupStatusBar()
 {
     statusBar()->showMessage("Ready");
+    
+    m_recordLabel = new QLabel(this);
+    m_recordLabel->setStyleSheet("QLabel { color: red; font-family: monospace; }");
+    m_recordLabel->setVisible(false);
+    statusBar()->addPermanentWidget(m_recordLabel);
+    
+    m_burstLabel = new QLabel(this);
+    m_burstLabel->setStyleSheet("QLabel { font-family: monospace; }");
+    m_burstLabel->setVisible(false);
+    statusBar()->addPermanentWidget(m_burstLabel);
+    
+    m_metricsLabel = new QLabel(this);
+    m_metricsLabel->setStyleSheet("QLabel { font-family: monospace; }");
+    m_metricsLabel->setVisible(false);
+    statusBar()->addPermanentWidget(m_metricsLabel);
 }
 
 void MainWindow::connectSignals()
@@ -175,20 +472,31 @@ void MainWindow::connectSignals()
     connect(m_resumeButton, &QPushButton::clicked, this, &MainWindow::onResumeClicked);
     connect(m_forwardButton, &QPushButton::clicked, this, &MainWindow::onForwardClicked);
     connect(m_rewindButton, &QPushButton::clicked, this, &MainWindow::onRewindClicked);
+    connect(m_liveButton, &QPushButton::clicked, this, &MainWindow::onLiveClicked);
+    connect(m_recordButton, &QPushButton::toggled, this, &MainWindow::onRecordToggled);
+    connect(m_recordTimer, &QTimer::timeout, this, &MainWindow::updateRecordingStatus);
+    connect(m_burstButton, &QPushButton::clicked, this, &MainWindow::onBurstClicked);
+    connect(m_burstTimer, &QTimer::timeout, this, &MainWindow::updateBurstStatus);
     
     // Resolution combo connection
     connect(m_resolutionCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onResolutionChanged);
+    connect(m_historyBudgetSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::onHistoryBudgetChanged);
+    connect(m_changeThresholdSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::onChangeThresholdChanged);
     
-    // Frame timer connection
-    connect(m_frameTimer, &QTimer::timeout, this, &MainWindow::updateFrame);
+    // Metrics connections
+    connect(m_metricsTimer, &QTimer::timeout, this, &MainWindow::updateMetricsPanel);
+    connect(m_metricsDumpTimer, &QTimer::timeout, this, &MainWindow::dumpMetrics);
 }
 
 void MainWindow::onPlayClicked()
 {
     try {
-        m_cameraController->start();
-        m_frameTimer->start(33); // ~30 FPS
+        forEachCamera([](CameraController& camera) { camera.start(); });
+        m_lastPaintedSequence = -1;
+        startFrameUpdates();
         updateControlsState();
         statusBar()->showMessage("Camera started", 2000);
     }
@@ -200,8 +508,8 @@ void MainWindow::onPlayClicked()
 void MainWindow::onPauseClicked()
 {
     try {
-        m_cameraController->pause();
-        m_frameTimer->stop();
+        forEachCamera([](CameraController& camera) { camera.pause(); });
+        stopFrameUpdates();
         updateControlsState();
         statusBar()->showMessage("Camera paused", 2000);
     }
@@ -213,8 +521,8 @@ void MainWindow::onPauseClicked()
 void MainWindow::onResumeClicked()
 {
     try {
-        m_cameraController->resume();
-        m_frameTimer->start(33);
+        forEachCamera([](CameraController& camera) { camera.resume(); });
+        startFrameUpdates();
         updateControlsState();
         statusBar()->showMessage("Camera resumed", 2000);
     }
@@ -226,7 +534,9 @@ void MainWindow::onResumeClicked()
 void MainWindow::onForwardClicked()
 {
     try {
-        m_cameraController->skipFrames(10); // Skip 10 frames forward
+        forEachCamera([](CameraController& camera) { camera.skipFrames(10); }); // Skip 10 frames forward
+        updateFrame(); // no frame notifications arrive while paused
+        updateControlsState();
         statusBar()->showMessage("Skipped forward", 1000);
     }
     catch (const std::exception& e) {
@@ -237,7 +547,9 @@ void MainWindow::onForwardClicked()
 void MainWindow::onRewindClicked()
 {
     try {
-        m_cameraController->skipFrames(-10); // Skip 10 frames backward
+        forEachCamera([](CameraController& camera) { camera.skipFrames(-10); }); // Skip 10 frames backward
+        updateFrame(); // no frame notifications arrive while paused
+        updateControlsState();
         statusBar()->showMessage("Skipped backward", 1000);
     }
     catch (const std::exception& e) {
@@ -245,6 +557,142 @@ void MainWindow::onRewindClicked()
     }
 }
 
+void MainWindow::onLiveClicked()
+{
+    try {
+        forEachCamera([](CameraController& camera) { camera.jumpToLive(); });
+        updateFrame(); // no frame notifications arrive while paused
+        updateControlsState();
+        statusBar()->showMessage("Back to live", 1000);
+    }
+    catch (const std::exception& e) {
+        showErrorMessage(QString("Failed to return to live: %1").arg(e.what()));
+    }
+}
+
+void MainWindow::onRecordToggled(bool checked)
+{
+    if (!checked) {
+        stopRecorders(m_cameraControllers, m_recorders, m_recordListeners);
+        m_recordTimer->stop();
+        m_recordLabel->setVisible(false);
+        statusBar()->showMessage("Recording stopped", 2000);
+        return;
+    }
+    
+    QStringList files;
+    QString error = startRecorders(m_cameraControllers, m_recordOptions, m_recorders, m_recordListeners, files);
+    if (!error.isEmpty()) {
+        QSignalBlocker blocker(m_recordButton);
+        m_recordButton->setChecked(false);
+        showErrorMessage(error);
+        return;
+    }
+    
+    m_recordLabel->setVisible(true);
+    updateRecordingStatus();
+    m_recordTimer->start(500);
+    statusBar()->showMessage(QString("Recording to %1").arg(files.join(", ")), 3000);
+}
+
+void MainWindow::updateRecordingStatus()
+{
+    // Totals across cameras; queue depth is the fullest queue
+    double seconds = 0.0;
+    double fps = 0.0;
+    uint64_t dropped = 0;
+    size_t depth = 0;
+    size_t capacity = 0;
+    for (const auto& recorder : m_recorders) {
+        Recorder::Stats stats = recorder->stats();
+        seconds = std::max(seconds, stats.secondsRecorded);
+        fps += stats.encodedFps;
+        dropped += stats.framesDropped;
+        depth = std::max(depth, stats.queueDepth);
+        capacity = stats.queueCapacity;
+    }
+    
+    int elapsed = static_cast<int>(seconds);
+    m_recordLabel->setText(QString("REC %1:%2 | queue %3/%4 | %5 fps | dropped %6")
+                               .arg(elapsed / 60, 2, 10, QChar('0'))
+                               .arg(elapsed % 60, 2, 10, QChar('0'))
+                               .arg(depth)
+                               .arg(capacity)
+                               .arg(fps, 0, 'f', 1)
+                               .arg(dropped));
+}
+
+void MainWindow::setRecordingOptions(const QString& directory, int queueFrames, Recorder::DropPolicy policy)
+{
+    m_recordOptions.directory = directory;
+    m_recordOptions.queueFrames = queueFrames > 0 ? queueFrames : 30;
+    m_recordOptions.policy = policy;
+}
+
+void MainWindow::onBurstClicked()
+{
+    QString directory;
+    QString error = startBursts(m_cameraControllers, m_snapshotDirectory, m_snapshotFormat,
+                                m_burstFramesSpin->value(), m_burstWriters, directory);
+    if (!error.isEmpty()) {
+        showErrorMessage(error);
+        return;
+    }
+    
+    m_burstLabel->setVisible(true);
+    updateBurstStatus();
+    m_burstTimer->start(250);
+    updateControlsState();
+    statusBar()->showMessage(QString("Saving burst to %1").arg(directory), 3000);
+}
+
+void MainWindow::updateBurstStatus()
+{
+    // Totals across cameras, which burst in parallel
+    uint64_t written = 0;
+    uint64_t frames = 0;
+    uint64_t lost = 0;
+    double fps = 0.0;
+    double megabytes = 0.0;
+    bool done = true;
+    for (size_t i = 0; i < m_burstWriters.size(); ++i) {
+        BurstWriter::Stats stats = m_burstWriters[i]->stats();
+        written += stats.written;
+        frames += stats.frames;
+        lost += stats.dropped + stats.failed;
+        fps += stats.fps;
+        megabytes += stats.mbPerSecond;
+        if (m_cameraControllers[i]->isBurstActive() || stats.pending > 0) {
+            done = false;
+        }
+    }
+    
+    QString text = QString("BURST %1/%2 | %3 fps | %4 MB/s")
+                       .arg(written)
+                       .arg(frames)
+                       .arg(fps, 0, 'f', 1)
+                       .arg(megabytes, 0, 'f', 0);
+    if (lost > 0) {
+        text += QString(" | lost %1").arg(lost);
+    }
+    m_burstLabel->setText(text);
+    
+    if (done) {
+        m_burstTimer->stop();
+        updateControlsState();
+        statusBar()->showMessage(QString("Burst saved: %1 frames at %2 fps, %3 MB/s")
+                                     .arg(written)
+                                     .arg(fps, 0, 'f', 1)
+                                     .arg(megabytes, 0, 'f', 0), 5000);
+    }
+}
+
+void MainWindow::setSnapshotOptions(const QString& directory, BurstWriter::Format format)
+{
+    m_snapshotDirectory = directory;
+    m_snapshotFormat = format;
+}
+
 void MainWindow::onResolutionChanged(int index)
 {
     if (index < 0 || index >= static_cast<int>(m_resolutions.size())) {
@@ -254,24 +702,17 @@ void MainWindow::onResolutionChanged(int index)
     const auto& resolution = m_resolutions[index];
     
     try {
-        bool wasRunning = m_cameraController->isRunning();
-        
-        if (wasRunning) {
-            m_frameTimer->stop();
-            m_cameraController->stop();
-        }
-        
-        m_cameraController->setResolution(resolution.width, resolution.height);
-        m_currentResolutionLabel->setText(QString("Current: %1x%2")
-                                         .arg(resolution.width)
-                                         .arg(resolution.height));
+        // The device stays open and capture keeps running; a running camera
+        // switches between two frames and updateFrame() reports when it has
+        forEachCamera([&resolution](CameraController& camera) {
+            camera.setResolution(resolution.width, resolution.height);
+        });
         
-        if (wasRunning) {
-            m_cameraController->start();
-            m_frameTimer->start(33);
+        if (!reportModeSwitch()) {
+            m_currentResolutionLabel->setText(QString("Switching to %1x%2...")
+                                             .arg(resolution.width)
+                                             .arg(resolution.height));
         }
-        
-        statusBar()->showMessage(QString("Resolution changed to %1").arg(resolution.name), 2000);
     }
     catch (const std::exception& e) {
         showErrorMessage(QString("Failed to change resolution: %1").arg(e.what()));
@@ -280,21 +721,338 @@ void MainWindow::onResolutionChanged(int index)
     }
 }
 
+bool MainWindow::reportModeSwitch()
+{
+    CameraController::ModeSwitch modeSwitch = m_cameraController->lastModeSwitch();
+    if (modeSwitch.count == m_reportedModeSwitches) {
+        return false;
+    }
+    m_reportedModeSwitches = modeSwitch.count;
+    
+    m_currentResolutionLabel->setText(QString("Current: %1x%2").arg(modeSwitch.width).arg(modeSwitch.height));
+    QString message = QString("Resolution changed to %1x%2 in %3 ms")
+                          .arg(modeSwitch.width)
+                          .arg(modeSwitch.height)
+                          .arg(modeSwitch.switchMs, 0, 'f', 0);
+    if (modeSwitch.gapMs > 0.0) {
+        message += QString(", no video for %1 ms").arg(modeSwitch.gapMs, 0, 'f', 0);
+    }
+    statusBar()->showMessage(message, 4000);
+    rememberCaptureMode();
+    return true;
+}
+
+void MainWindow::onHistoryBudgetChanged(int megabytes)
+{
+    forEachCamera([megabytes](CameraController& camera) {
+        camera.setHistoryBudget(static_cast<size_t>(megabytes));
+    });
+    statusBar()->showMessage(QString("Rewind buffer set to %1 MB").arg(megabytes), 2000);
+}
+
+void MainWindow::setHistoryBudget(int megabytes)
+{
+    m_historyBudgetSpin->setValue(megabytes);
+}
+
+void MainWindow::onChangeThresholdChanged(double threshold)
+{
+    forEachCamera([threshold](CameraController& camera) { camera.setChangeThreshold(threshold); });
+    if (threshold > 0.0) {
+        statusBar()->showMessage(QString("Skipping frames that change by less than %1 grey levels").arg(threshold), 2000);
+    } else {
+        statusBar()->showMessage("Change detection off", 2000);
+    }
+}
+
+void MainWindow::setChangeThreshold(double threshold)
+{
+    m_changeThresholdSpin->setValue(threshold);
+}
+
+void MainWindow::enableDiskHistory(const QString& directory, int megabytes)
+{
+    QString error = setUpDiskHistory(m_cameraControllers, directory, megabytes);
+    if (!error.isEmpty()) {
+        showErrorMessage(error);
+        return;
+    }
+    statusBar()->showMessage(QString("Disk rewind history: %1 MB in %2").arg(megabytes).arg(directory), 3000);
+}
+
+void MainWindow::setDecodeThreads(int threads)
+{
+    forEachCamera([threads](CameraController& camera) { camera.setDecodeThreads(threads); });
+}
+
+bool MainWindow::setProcessingChain(const QString& chain)
+{
+    QString error = setUpProcessing(m_cameraControllers, chain);
+    if (!error.isEmpty()) {
+        showErrorMessage(error);
+        return false;
+    }
+    
+    QStringList specs = chain.split(',', Qt::SkipEmptyParts);
+    if (!specs.isEmpty()) {
+        statusBar()->showMessage(QString("Processing frames: %1").arg(specs.join(" > ")), 3000);
+    }
+    return true;
+}
+
+void MainWindow::enableSharedFrames(const QString& name)
+{
+    QString error = setUpSharedFrames(m_cameraControllers, name);
+    if (!error.isEmpty()) {
+        showErrorMessage(error);
+        return;
+    }
+    statusBar()->showMessage(QString("Publishing frames to shared memory as %1").arg(name), 3000);
+}
+
+void MainWindow::startFrameUpdates()
+{
+    // Paced by the cameras: each new frame posts one updateFrame() to the
+    // GUI thread, which then shows whatever is newest at that point
+    m_frameUpdateQueued = false;
+    forEachCamera([this](CameraController& camera) {
+        camera.setFrameReadyCallback([this] {
+            if (!m_frameUpdateQueued.exchange(true)) {
+                QMetaObject::invokeMethod(this, &MainWindow::updateFrame, Qt::QueuedConnection);
+            }
+        });
+    });
+}
+
+void MainWindow::stopFrameUpdates()
+{
+    forEachCamera([](CameraController& camera) { camera.setFrameReadyCallback(nullptr); });
+}
+
 void MainWindow::updateFrame()
 {
+    m_frameUpdateQueued = false;
+    
     try {
-        QPixmap frame = m_cameraController->getCurrentFrame();
+        reportModeSwitch();
+        
+        if (m_cameraControllers.size() > 1) {
+            updateMosaic();
+            return;
+        }
+        
+        // Converted straight to display size, so painting is a plain blit
+        QSize target = m_videoWidget->targetSize();
+        m_cameraController->setDisplaySize(target.width(), target.height());
+        QImage frame = m_cameraController->getCurrentImage();
         if (!frame.isNull()) {
-            m_cameraLabel->setPixmap(frame);
+            m_videoWidget->setImage(frame);
         }
     }
     catch (const std::exception& e) {
+        stopFrameUpdates();
         showErrorMessage(QString("Error updating frame: %1").arg(e.what()));
-        m_frameTimer->stop();
         updateControlsState();
     }
 }
 
+void MainWindow::updateMosaic()
+{
+    std::vector<cv::Mat> frames;
+    frames.reserve(m_cameraControllers.size());
+    for (auto& controller : m_cameraControllers) {
+        frames.push_back(controller->getCurrentMat());
+    }
+    
+    // Composite at display size so the widget does not scale again
+    QSize target = m_videoWidget->targetSize();
+    QImage mosaic = m_mosaic.compose(frames, target.width(), target.height());
+    if (!mosaic.isNull()) {
+        m_videoWidget->setImage(mosaic);
+    }
+}
+
+void MainWindow::zoomView(double steps, double x, double y)
+{
+    // Mosaic tiles zoom about their centres
+    if (m_cameraControllers.size() > 1) {
+        x = 0.5;
+        y = 0.5;
+    }
+    forEachCamera([steps, x, y](CameraController& camera) {
+        if (steps == 0.0) {
+            camera.setRegionOfInterest(cv::Rect2d());
+        } else {
+            camera.zoomAt(std::pow(1.25, steps), x, y);
+        }
+    });
+    
+    double zoom = m_cameraController->zoomFactor();
+    statusBar()->showMessage(zoom > 1.0 ? QString("Zoom %1x").arg(zoom, 0, 'f', 1) : QString("Zoom off"), 1000);
+    
+    // Show the new crop straight away, also while paused
+    if (m_cameraController->isRunning()) {
+        updateFrame();
+    }
+}
+
+void MainWindow::recordPaint(int64_t paintStart, int64_t paintEnd)
+{
+    if (!m_cameraController->isRunning()) {
+        return;
+    }
+    
+    PipelineMetrics& metrics = m_cameraController->metrics();
+    metrics.record(PipelineMetrics::Paint, paintEnd - paintStart);
+    
+    // Only the first paint of each new live frame counts towards end-to-end
+    // latency; repaints and rewound frames would skew it
+    int64_t sequence = m_cameraController->currentSequence();
+    if (sequence > m_lastPaintedSequence && !m_cameraController->isPaused() && m_cameraController->isLive()) {
+        m_lastPaintedSequence = sequence;
+        metrics.record(PipelineMetrics::EndToEnd, paintEnd - m_cameraController->currentFrameTimestamp());
+        metrics.frameDisplayed(paintEnd);
+    }
+}
+
+void MainWindow::updateMetricsPanel()
+{
+    PipelineMetrics::Snapshot snapshot = m_cameraController->metrics().snapshot();
+    const auto& endToEnd = snapshot.stages[PipelineMetrics::EndToEnd];
+    
+    QString text = QString("device %1 fps | display %2 fps, jitter %3 ms | dropped %4 | e2e p50/p95/p99 %5/%6/%7 ms")
+                       .arg(snapshot.captureFps, 0, 'f', 1)
+                       .arg(snapshot.displayFps, 0, 'f', 1)
+                       .arg(snapshot.displayJitterMs, 0, 'f', 1)
+                       .arg(snapshot.framesDropped)
+                       .arg(endToEnd.p50Ms, 0, 'f', 1)
+                       .arg(endToEnd.p95Ms, 0, 'f', 1)
+                       .arg(endToEnd.p99Ms, 0, 'f', 1);
+    m_metricsLabel->setText(text);
+    
+    // Per-stage breakdown on hover
+    QString tooltip;
+    for (int stage = 0; stage < PipelineMetrics::StageCount; ++stage) {
+        const auto& summary = snapshot.stages[stage];
+        tooltip += QString("%1: p50 %2 ms, p95 %3 ms, p99 %4 ms (%5 samples)\n")
+                       .arg(PipelineMetrics::stageName(static_cast<PipelineMetrics::Stage>(stage)))
+                       .arg(summary.p50Ms, 0, 'f', 2)
+                       .arg(summary.p95Ms, 0, 'f', 2)
+                       .arg(summary.p99Ms, 0, 'f', 2)
+                       .arg(summary.samples);
+    }
+    tooltip += QString("device jitter %1 ms, display jitter %2 ms")
+                   .arg(snapshot.captureJitterMs, 0, 'f', 2)
+                   .arg(snapshot.displayJitterMs, 0, 'f', 2);
+    
+    ChangeDetector::Stats changes = m_cameraController->changeStats();
+    if (m_cameraController->changeThreshold() > 0.0 && changes.frames > 0) {
+        tooltip += QString("\nunchanged frames skipped: %1%, last difference %2, detection %3 ms")
+                       .arg(100.0 * changes.unchanged / changes.frames, 0, 'f', 1)
+                       .arg(changes.lastDifference, 0, 'f', 1)
+                       .arg(changes.detectMs, 0, 'f', 2);
+    }
+    
+    ParallelDecodeSource::Stats decoding = m_cameraController->decodeStats();
+    if (decoding.threads > 0) {
+        tooltip += QString("\ndecode: %1 on %2 threads, %3 ms per frame, %4 corrupt frames skipped")
+                       .arg(QString::fromStdString(fourccName(decoding.fourcc)))
+                       .arg(decoding.threads)
+                       .arg(decoding.decodeMs, 0, 'f', 2)
+                       .arg(decoding.failed);
+    }
+    
+    FrameAllocator::Stats pool = FrameAllocator::instance()->stats();
+    if (pool.allocations > 0) {
+        tooltip += QString("\nframe pool: %1 MB in use, %2 MB free, %3% reused, %4 from the system (%5 on huge pages)")
+                       .arg(pool.bytesInUse / (1024.0 * 1024.0), 0, 'f', 0)
+                       .arg(pool.bytesPooled / (1024.0 * 1024.0), 0, 'f', 0)
+                       .arg(100.0 * pool.reused / pool.allocations, 0, 'f', 1)
+                       .arg(pool.systemAllocations)
+                       .arg(pool.hugePageBlocks);
+    }
+    
+    if (std::shared_ptr<FrameGraph> graph = m_cameraController->processingGraph()) {
+        FrameGraph::Stats processing = graph->stats();
+        tooltip += QString("\nprocessing: %1 ms mean latency, %2 frames dropped")
+                       .arg(processing.latencyMs, 0, 'f', 2)
+                       .arg(processing.rejected);
+        for (const auto& stage : processing.stages) {
+            tooltip += QString("\n  %1%2: mean %3 ms, max %4 ms")
+                           .arg(QString::fromStdString(stage.name))
+                           .arg(stage.stateless ? "" : " (in order)")
+                           .arg(stage.meanMs, 0, 'f', 2)
+                           .arg(stage.maxMs, 0, 'f', 2);
+        }
+    }
+    m_metricsLabel->setToolTip(tooltip);
+}
+
+bool MainWindow::setMetricsDump(const QString& path, int intervalMs)
+{
+    m_metricsDumpTimer->stop();
+    if (m_metricsDumpFile.isOpen()) {
+        m_metricsDumpFile.close();
+    }
+    
+    m_metricsDumpFile.setFileName(path);
+    if (!m_metricsDumpFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qDebug() << "Cannot open metrics dump file" << path;
+        return false;
+    }
+    
+    m_metricsDumpCsv = path.endsWith(".csv", Qt::CaseInsensitive);
+    if (m_metricsDumpCsv) {
+        m_metricsDumpFile.write(PipelineMetrics::csvHeader().c_str());
+        m_metricsDumpFile.write("\n");
+    }
+    
+    m_metricsDumpTimer->start(intervalMs > 0 ? intervalMs : 1000);
+    return true;
+}
+
+void MainWindow::dumpMetrics()
+{
+    PipelineMetrics::Snapshot snapshot = m_cameraController->metrics().snapshot();
+    std::string line = m_metricsDumpCsv ? PipelineMetrics::toCsv(snapshot) : PipelineMetrics::toJson(snapshot);
+    m_metricsDumpFile.write(line.c_str());
+    m_metricsDumpFile.write("\n");
+    m_metricsDumpFile.flush();
+}
+
+void MainWindow::syncResolutionSelection()
+{
+    auto current = m_cameraController->getCurrentResolution();
+    
+    int index = -1;
+    for (size_t i = 0; i < m_resolutions.size(); ++i) {
+        if (m_resolutions[i].width == current.first && m_resolutions[i].height == current.second) {
+            index = static_cast<int>(i);
+            break;
+        }
+    }
+    
+    // The source opened in a mode we do not list; switch to the default one
+    if (index < 0) {
+        index = 0;
+    }
+    
+    // Every camera follows the selected mode
+    const auto& resolution = m_resolutions[index];
+    forEachCamera([&resolution](CameraController& camera) {
+        if (camera.getCurrentResolution() != std::make_pair(resolution.width, resolution.height)) {
+            camera.setResolution(resolution.width, resolution.height);
+        }
+    });
+    current = m_cameraController->getCurrentResolution();
+    
+    QSignalBlocker blocker(m_resolutionCombo);
+    m_resolutionCombo->setCurrentIndex(index);
+    m_currentResolutionLabel->setText(QString("Current: %1x%2").arg(current.first).arg(current.second));
+    m_reportedModeSwitches = m_cameraController->lastModeSwitch().count;
+    rememberCaptureMode();
+}
+
 void MainWindow::updateControlsState()
 {
     bool isRunning = m_cameraController->isRunning();
@@ -306,7 +1064,10 @@ void MainWindow::updateControlsState()
     m_resumeButton->setEnabled(isInitialized && isPaused);
     m_forwardButton->setEnabled(isInitialized);
     m_rewindButton->setEnabled(isInitialized);
-    m_resolutionCombo->setEnabled(isInitialized && !isRunning);
+    m_liveButton->setEnabled(isRunning && !m_cameraController->isLive());
+    m_recordButton->setEnabled(isInitialized);
+    m_burstButton->setEnabled(isRunning && !m_burstTimer->isActive());
+    m_resolutionCombo->setEnabled(isInitialized);
 }
 
 void MainWindow::showErrorMessage(const QString& message)
@@ -5,23 +5,72 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QComboBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
 #include <QStatusBar>
 #include <QTimer>
 #include <QMessageBox>
+#include <QFile>
+#include <QStringList>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <thread>
+#include <vector>
 
+#include "BurstWriter.h"
 #include "CameraController.h"
+#include "CameraSetup.h"
+#include "DeviceCapabilityCache.h"
+#include "MjpegServer.h"
+#include "MosaicCompositor.h"
+#include "Recorder.h"
+#include "VideoWidget.h"
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    // One camera per source spec; several are shown as a mosaic
+    explicit MainWindow(const QStringList& sourceSpecs = QStringList() << "0", QWidget *parent = nullptr);
     ~MainWindow();
+    
+    // Append a metrics snapshot to path every intervalMs (CSV for *.csv, JSON lines otherwise)
+    bool setMetricsDump(const QString& path, int intervalMs);
+    
+    // Rewind history memory budget in megabytes
+    void setHistoryBudget(int megabytes);
+    
+    // Skip unchanged frames of static scenes; 0 turns it off
+    void setChangeThreshold(double threshold);
+    
+    // Also keep rewind history on disk in directory, up to megabytes
+    void enableDiskHistory(const QString& directory, int megabytes);
+    
+    // Publish frames to shared memory under name for other local processes
+    void enableSharedFrames(const QString& name);
+    
+    // Decode native camera frames on threads workers; 0 decodes in read()
+    void setDecodeThreads(int threads);
+    
+    // Process live frames before display, e.g. "resize:1280x720,denoise,overlay"
+    bool setProcessingChain(const QString& chain);
+    
+    // Where Record writes to, and how its encoder queue behaves when full
+    void setRecordingOptions(const QString& directory, int queueFrames, Recorder::DropPolicy policy);
+    
+    // Where Burst saves its snapshots, and in which format
+    void setSnapshotOptions(const QString& directory, BurstWriter::Format format);
+    
+    // Probe camera modes again instead of trusting the capability cache
+    void setReprobeDevices(bool reprobe);
+    
+    // Serve the first camera as MJPEG over HTTP on port
+    bool startStreaming(quint16 port);
 
 private slots:
     void onPlayClicked();
@@ -29,8 +78,17 @@ private slots:
     void onResumeClicked();
     void onForwardClicked();
     void onRewindClicked();
+    void onLiveClicked();
+    void onRecordToggled(bool checked);
+    void updateRecordingStatus();
+    void onBurstClicked();
+    void updateBurstStatus();
     void onResolutionChanged(int index);
+    void onHistoryBudgetChanged(int megabytes);
+    void onChangeThresholdChanged(double threshold);
     void updateFrame();
+    void updateMetricsPanel();
+    void dumpMetrics();
 
 private:
     void setupUI();
@@ -38,24 +96,90 @@ private:
     void setupStatusBar();
     void connectSignals();
     void updateControlsState();
+    void syncResolutionSelection();
     void showErrorMessage(const QString& message);
+    void forEachCamera(const std::function<void(CameraController&)>& action);
+    void updateMosaic();
+    void zoomView(double steps, double x, double y);
+    void recordPaint(int64_t paintStart, int64_t paintEnd);
+    void startFrameUpdates();
+    void stopFrameUpdates();
+    void initializeCameras();
+    std::vector<CaptureMode> initializeCamera(CameraController& camera, const QString& spec);
+    void onCameraInitialized(int index, const std::vector<CaptureMode>& modes, const QString& error);
+    void setResolutionModes(const std::vector<CaptureMode>& modes);
+    void rememberCaptureMode();
+    bool reportModeSwitch();
+    void attachStream();
 
     // UI Components
     QWidget* m_centralWidget;
-    QLabel* m_cameraLabel;
+    VideoWidget* m_videoWidget;
     QPushButton* m_playButton;
     QPushButton* m_pauseButton;
     QPushButton* m_resumeButton;
     QPushButton* m_forwardButton;
     QPushButton* m_rewindButton;
+    QPushButton* m_liveButton;
+    QPushButton* m_recordButton;
+    QPushButton* m_burstButton;
+    QSpinBox* m_burstFramesSpin;
     QComboBox* m_resolutionCombo;
     QLabel* m_currentResolutionLabel;
+    QSpinBox* m_historyBudgetSpin;
+    QDoubleSpinBox* m_changeThresholdSpin;
     QGroupBox* m_controlsGroup;
     QGroupBox* m_settingsGroup;
     
-    // Camera and timer
-    std::unique_ptr<CameraController> m_cameraController;
-    QTimer* m_frameTimer;
+    // Cameras. Controls apply to every camera; the first one drives the
+    // status display and metrics.
+    std::vector<std::unique_ptr<CameraController>> m_cameraControllers;
+    CameraController* m_cameraController;
+    MosaicCompositor m_mosaic;
+    
+    // Cameras open on background threads; the combo box lists the modes
+    // the first camera reported, from the capability cache when known
+    QStringList m_sourceSpecs;
+    DeviceCapabilityCache m_capabilityCache;
+    bool m_reprobeDevices;
+    std::vector<std::thread> m_initThreads;
+    int m_pendingInits;
+    QStringList m_initErrors;
+    std::vector<std::vector<CaptureMode>> m_cameraModes;
+    
+    // Set by the capture threads when an updateFrame() call is posted, so
+    // several cameras or a slow paint never queue more than one
+    std::atomic<bool> m_frameUpdateQueued;
+    
+    // Recording, one file per camera
+    std::vector<std::unique_ptr<Recorder>> m_recorders;
+    std::vector<int> m_recordListeners;
+    RecordingOptions m_recordOptions;
+    QLabel* m_recordLabel;
+    QTimer* m_recordTimer;
+    
+    // Burst snapshots, one writer per camera sharing the cores between them
+    std::vector<std::shared_ptr<BurstWriter>> m_burstWriters;
+    QString m_snapshotDirectory;
+    BurstWriter::Format m_snapshotFormat;
+    QLabel* m_burstLabel;
+    QTimer* m_burstTimer;
+    
+    // MJPEG streaming of the first camera
+    std::unique_ptr<MjpegServer> m_streamServer;
+    CameraController* m_streamCamera;
+    int m_streamListener;
+    
+    // Pipeline metrics panel and periodic dump
+    QLabel* m_metricsLabel;
+    QTimer* m_metricsTimer;
+    QTimer* m_metricsDumpTimer;
+    QFile m_metricsDumpFile;
+    bool m_metricsDumpCsv;
+    int64_t m_lastPaintedSequence;
+    
+    // Resolution switches already shown in the status bar
+    uint64_t m_reportedModeSwitches;
     
     // Resolution options
     struct Resolution {
@@ -0,0 +1,328 @@
+#include "MjpegServer.h"
+#include "FrameAllocator.h"
+#include "PipelineMetrics.h"
+#include <opencv2/imgcodecs.hpp>
+#include <QDebug>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <algorithm>
+
+const char* const MjpegServer::BOUNDARY = "mjpegframe";
+
+namespace {
+
+// Requests are a single GET line plus headers; anything bigger is not ours
+const int MAX_REQUEST_BYTES = 8192;
+
+QByteArray response(const char* status, const char* contentType, const QByteArray& body)
+{
+    QByteArray text = QByteArray("HTTP/1.1 ") + status + "\r\n"
+                      "Content-Type: " + contentType + "\r\n"
+                      "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                      "Cache-Control: no-cache\r\n"
+                      "Connection: close\r\n\r\n";
+    return text + body;
+}
+
+} // namespace
+
+MjpegServer::MjpegServer(int quality)
+    : m_context(nullptr)
+    , m_server(nullptr)
+    , m_lastHeaderSize(0)
+    , m_port(0)
+    , m_hasStaged(false)
+    , m_encoderBusy(false)
+    , m_stopRequested(false)
+    , m_quality(quality)
+    , m_streamingClients(0)
+    , m_framesEncoded(0)
+    , m_framesSent(0)
+    , m_framesSkipped(0)
+    , m_framesNotEncoded(0)
+    , m_bytesSent(0)
+    , m_encodeNs(0)
+{
+    FrameAllocator::use(m_staged);
+    FrameAllocator::use(m_encoding);
+}
+
+MjpegServer::~MjpegServer()
+{
+    stop();
+}
+
+bool MjpegServer::start(quint16 port, const QHostAddress& address)
+{
+    stop();
+
+    m_context = new QObject;
+    m_context->moveToThread(&m_thread);
+    m_thread.start();
+
+    // The server and its sockets are created on the network thread and
+    // only ever touched there
+    bool listening = false;
+    QMetaObject::invokeMethod(m_context, [this, port, address, &listening] {
+        m_server = new QTcpServer(m_context);
+        QObject::connect(m_server, &QTcpServer::newConnection, m_context, [this] { onNewConnection(); });
+        listening = m_server->listen(address, port);
+        m_port = m_server->serverPort();
+    }, Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        qDebug() << "MJPEG server cannot listen on port" << port;
+        stop();
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = false;
+        m_hasStaged = false;
+        m_encoderBusy = false;
+    }
+    m_encodeThread = std::thread(&MjpegServer::encodeLoop, this);
+
+    qDebug() << "MJPEG stream on port" << m_port << "at /stream";
+    return true;
+}
+
+void MjpegServer::stop()
+{
+    if (m_encodeThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopRequested = true;
+        }
+        m_frameStaged.notify_all();
+        m_encodeThread.join();
+    }
+
+    if (m_thread.isRunning()) {
+        QMetaObject::invokeMethod(m_context, [this] {
+            // Detach first: abort() emits disconnected() synchronously
+            std::vector<Client> clients;
+            clients.swap(m_clients);
+            for (Client& client : clients) {
+                QObject::disconnect(client.socket, nullptr, m_context, nullptr);
+                client.socket->abort();
+                delete client.socket;
+            }
+            delete m_server;
+            m_server = nullptr;
+        }, Qt::BlockingQueuedConnection);
+        m_thread.quit();
+        m_thread.wait();
+    }
+
+    delete m_context;
+    m_context = nullptr;
+    m_streamingClients = 0;
+    m_lastPart.clear();
+    m_lastHeaderSize = 0;
+}
+
+void MjpegServer::setQuality(int quality)
+{
+    m_quality = std::clamp(quality, 1, 100);
+}
+
+void MjpegServer::pushFrame(const cv::Mat& frame)
+{
+    // Nobody watching: no copy, no encode
+    if (m_streamingClients == 0 || frame.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopRequested || m_encoderBusy || m_hasStaged) {
+            ++m_framesNotEncoded;
+            return;
+        }
+        // The encoder is idle, so the staging buffer is free to reuse
+        frame.copyTo(m_staged);
+        m_hasStaged = true;
+    }
+    m_frameStaged.notify_one();
+}
+
+MjpegServer::Stats MjpegServer::stats() const
+{
+    Stats stats;
+    stats.clients = m_streamingClients;
+    stats.framesEncoded = m_framesEncoded;
+    stats.framesSent = m_framesSent;
+    stats.framesSkipped = m_framesSkipped;
+    stats.framesNotEncoded = m_framesNotEncoded;
+    stats.bytesSent = m_bytesSent;
+    stats.encodeMs = m_encodeNs / 1e6;
+    return stats;
+}
+
+void MjpegServer::encodeLoop()
+{
+    std::vector<uchar> jpeg;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_encoderBusy = false;
+            m_frameStaged.wait(lock, [this] { return m_stopRequested || m_hasStaged; });
+            if (m_stopRequested) {
+                break;
+            }
+            std::swap(m_staged, m_encoding);
+            m_hasStaged = false;
+            m_encoderBusy = true;
+        }
+
+        int64_t encodeStart = PipelineMetrics::now();
+        if (!cv::imencode(".jpg", m_encoding, jpeg, {cv::IMWRITE_JPEG_QUALITY, m_quality.load()})) {
+            continue;
+        }
+
+        // One buffer per frame holding the complete multipart part; every
+        // client socket shares it
+        QByteArray header = QByteArray("--") + BOUNDARY + "\r\n"
+                            "Content-Type: image/jpeg\r\n"
+                            "Content-Length: " + QByteArray::number(static_cast<qsizetype>(jpeg.size())) + "\r\n\r\n";
+        QByteArray part;
+        part.reserve(header.size() + static_cast<qsizetype>(jpeg.size()) + 2);
+        part.append(header);
+        part.append(reinterpret_cast<const char*>(jpeg.data()), static_cast<qsizetype>(jpeg.size()));
+        part.append("\r\n");
+        m_encodeNs = PipelineMetrics::now() - encodeStart;
+        ++m_framesEncoded;
+
+        qsizetype headerSize = header.size();
+        QMetaObject::invokeMethod(m_context, [this, part, headerSize] { broadcast(part, headerSize); },
+                                  Qt::QueuedConnection);
+    }
+}
+
+void MjpegServer::onNewConnection()
+{
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        // Small frames matter more than throughput for a live view
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        m_clients.push_back({socket, QByteArray(), false});
+        QObject::connect(socket, &QTcpSocket::readyRead, m_context, [this, socket] { onReadyRead(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, m_context, [this, socket] { onDisconnected(socket); });
+        QObject::connect(socket, &QTcpSocket::bytesWritten, m_context, [this](qint64 bytes) { m_bytesSent += bytes; });
+    }
+}
+
+void MjpegServer::onReadyRead(QTcpSocket* socket)
+{
+    Client* client = findClient(socket);
+    if (!client) {
+        return;
+    }
+
+    // Streaming clients have nothing more to say; ignore whatever they send
+    QByteArray data = socket->readAll();
+    if (client->streaming) {
+        return;
+    }
+
+    client->request += data;
+    if (client->request.contains("\r\n\r\n")) {
+        handleRequest(*client);
+    } else if (client->request.size() > MAX_REQUEST_BYTES) {
+        socket->disconnectFromHost();
+    }
+}
+
+void MjpegServer::onDisconnected(QTcpSocket* socket)
+{
+    auto it = std::find_if(m_clients.begin(), m_clients.end(),
+                           [socket](const Client& client) { return client.socket == socket; });
+    if (it == m_clients.end()) {
+        return;
+    }
+    if (it->streaming) {
+        --m_streamingClients;
+    }
+    m_clients.erase(it);
+    socket->deleteLater();
+}
+
+void MjpegServer::handleRequest(Client& client)
+{
+    QList<QByteArray> requestLine = client.request.left(client.request.indexOf("\r\n")).split(' ');
+    QByteArray path = requestLine.size() >= 2 ? requestLine[1] : QByteArray();
+    int query = path.indexOf('?');
+    if (query >= 0) {
+        path.truncate(query);
+    }
+
+    if (requestLine.value(0) != "GET") {
+        client.socket->write(response("405 Method Not Allowed", "text/plain", "GET only\n"));
+        client.socket->disconnectFromHost();
+        return;
+    }
+
+    if (path == "/" || path == "/stream" || path == "/stream.mjpg") {
+        client.streaming = true;
+        client.request.clear();
+        ++m_streamingClients;
+        client.socket->write(QByteArray("HTTP/1.1 200 OK\r\n"
+                                        "Content-Type: multipart/x-mixed-replace; boundary=") + BOUNDARY + "\r\n"
+                             "Cache-Control: no-cache, no-store\r\n"
+                             "Pragma: no-cache\r\n"
+                             "Connection: close\r\n\r\n");
+        // Show something straight away rather than wait for the next frame
+        if (!m_lastPart.isEmpty()) {
+            client.socket->write(m_lastPart);
+        }
+        return;
+    }
+
+    if (path == "/snapshot.jpg") {
+        if (m_lastPart.isEmpty()) {
+            client.socket->write(response("503 Service Unavailable", "text/plain", "No frame yet\n"));
+        } else {
+            // The JPEG sits between the part header and the trailing CRLF
+            QByteArray jpeg = m_lastPart.mid(m_lastHeaderSize, m_lastPart.size() - m_lastHeaderSize - 2);
+            client.socket->write(response("200 OK", "image/jpeg", jpeg));
+        }
+        client.socket->disconnectFromHost();
+        return;
+    }
+
+    client.socket->write(response("404 Not Found", "text/plain", "Try /stream or /snapshot.jpg\n"));
+    client.socket->disconnectFromHost();
+}
+
+void MjpegServer::broadcast(const QByteArray& part, qsizetype headerSize)
+{
+    m_lastPart = part;
+    m_lastHeaderSize = headerSize;
+
+    for (Client& client : m_clients) {
+        if (!client.streaming) {
+            continue;
+        }
+        // Anything still queued means the client has not taken the previous
+        // frame yet; skip this one instead of building up a backlog
+        if (client.socket->bytesToWrite() > 0) {
+            ++m_framesSkipped;
+            continue;
+        }
+        client.socket->write(part);
+        ++m_framesSent;
+    }
+}
+
+MjpegServer::Client* MjpegServer::findClient(QTcpSocket* socket)
+{
+    for (Client& client : m_clients) {
+        if (client.socket == socket) {
+            return &client;
+        }
+    }
+    return nullptr;
+}
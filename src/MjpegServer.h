@@ -0,0 +1,111 @@
+#ifndef MJPEGSERVER_H
+#define MJPEGSERVER_H
+
+#include <opencv2/core.hpp>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QThread>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QObject;
+class QTcpServer;
+class QTcpSocket;
+
+// Serves the camera feed over HTTP as multipart/x-mixed-replace MJPEG, which
+// browsers and most video tools play directly:
+//   /stream        live MJPEG stream (also "/" and /stream.mjpg)
+//   /snapshot.jpg  latest frame as a single JPEG
+//
+// Frames come in through pushFrame() on the capture thread, which only copies
+// the frame when a client is watching and the encoder is free. Each frame is
+// JPEG-encoded once on the encoder thread into a single buffer holding the
+// whole multipart part, and that buffer is handed by reference to every
+// client socket; Qt queues it in each socket's write buffer without copying.
+//
+// Sockets are served from a dedicated network thread. A client whose socket
+// still has an earlier frame pending skips the new one, so a slow viewer
+// drops frames for itself and never holds back capture or other viewers.
+class MjpegServer
+{
+public:
+    struct Stats {
+        int clients = 0;
+        uint64_t framesEncoded = 0;
+        uint64_t framesSent = 0;        // summed over clients
+        uint64_t framesSkipped = 0;     // slow clients, summed over clients
+        uint64_t framesNotEncoded = 0;  // arrived while the encoder was busy
+        uint64_t bytesSent = 0;
+        double encodeMs = 0.0;          // last frame
+    };
+
+    explicit MjpegServer(int quality = 80);
+    ~MjpegServer();
+
+    // Start listening; port 0 picks a free port (see port())
+    bool start(quint16 port, const QHostAddress& address = QHostAddress::Any);
+    void stop();
+    bool isRunning() const { return m_thread.isRunning(); }
+    quint16 port() const { return m_port; }
+
+    // JPEG quality, 1-100
+    void setQuality(int quality);
+
+    // Producer side, typically a CameraController frame listener. Returns
+    // quickly and never blocks on the network.
+    void pushFrame(const cv::Mat& frame);
+
+    Stats stats() const;
+
+private:
+    struct Client {
+        QTcpSocket* socket;
+        QByteArray request;
+        bool streaming;
+    };
+
+    // Network thread
+    void onNewConnection();
+    void onReadyRead(QTcpSocket* socket);
+    void onDisconnected(QTcpSocket* socket);
+    void handleRequest(Client& client);
+    void broadcast(const QByteArray& part, qsizetype headerSize);
+    Client* findClient(QTcpSocket* socket);
+
+    // Encoder thread
+    void encodeLoop();
+
+    static const char* const BOUNDARY;
+
+    QThread m_thread;
+    QObject* m_context;     // lives on m_thread; network calls are queued to it
+    QTcpServer* m_server;
+    std::vector<Client> m_clients;
+    QByteArray m_lastPart;
+    qsizetype m_lastHeaderSize;
+    quint16 m_port;
+
+    std::thread m_encodeThread;
+    std::mutex m_mutex;
+    std::condition_variable m_frameStaged;
+    cv::Mat m_staged;
+    cv::Mat m_encoding;
+    bool m_hasStaged;
+    bool m_encoderBusy;
+    bool m_stopRequested;
+
+    std::atomic<int> m_quality;
+    std::atomic<int> m_streamingClients;
+    std::atomic<uint64_t> m_framesEncoded;
+    std::atomic<uint64_t> m_framesSent;
+    std::atomic<uint64_t> m_framesSkipped;
+    std::atomic<uint64_t> m_framesNotEncoded;
+    std::atomic<uint64_t> m_bytesSent;
+    std::atomic<int64_t> m_encodeNs;
+};
+
+#endif // MJPEGSERVER_H
@@ -0,0 +1,82 @@
+#include "MosaicCompositor.h"
+#include "PixelKernels.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+MosaicCompositor::MosaicCompositor(int threads)
+    : m_pool(threads)
+{
+}
+
+void MosaicCompositor::gridSize(int count, int& columns, int& rows)
+{
+    columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count)))));
+    rows = std::max(1, (count + columns - 1) / columns);
+}
+
+QImage MosaicCompositor::compose(const std::vector<cv::Mat>& frames, int width, int height)
+{
+    int count = static_cast<int>(frames.size());
+    if (count == 0 || width <= 0 || height <= 0) {
+        return QImage();
+    }
+
+    int columns, rows;
+    gridSize(count, columns, rows);
+
+    // Start from a black canvas whenever the layout changes
+    if (m_canvas.cols != width || m_canvas.rows != height ||
+        static_cast<int>(m_tileSources.size()) != count) {
+        m_canvas.create(height, width, CV_8UC4);
+        m_canvas.setTo(cv::Scalar::all(0));
+        m_scaled.assign(count, cv::Mat());
+        m_tileSources.assign(count, cv::Size());
+    }
+
+    int tileWidth = width / columns;
+    int tileHeight = height / rows;
+    m_pool.parallelFor(count, [&](int i) {
+        cv::Rect tile((i % columns) * tileWidth, (i / columns) * tileHeight, tileWidth, tileHeight);
+        composeTile(i, frames[i], tile);
+    });
+
+    return QImage(m_canvas.data, m_canvas.cols, m_canvas.rows, static_cast<qsizetype>(m_canvas.step),
+                  QImage::Format_RGB32);
+}
+
+void MosaicCompositor::composeTile(int index, const cv::Mat& frame, const cv::Rect& tile)
+{
+    cv::Mat target = m_canvas(tile);
+    bool gray = frame.type() == CV_8UC1;
+    if (frame.empty() || (frame.type() != CV_8UC3 && !gray) || tile.width <= 0 || tile.height <= 0) {
+        if (m_tileSources[index] != cv::Size()) {
+            target.setTo(cv::Scalar::all(0));
+            m_tileSources[index] = cv::Size();
+        }
+        return;
+    }
+
+    // Letterbox borders only need clearing when the frame size changes
+    if (m_tileSources[index] != frame.size()) {
+        target.setTo(cv::Scalar::all(0));
+        m_tileSources[index] = frame.size();
+    }
+
+    double scale = std::min(static_cast<double>(tile.width) / frame.cols,
+                            static_cast<double>(tile.height) / frame.rows);
+    int width = std::max(1, static_cast<int>(frame.cols * scale));
+    int height = std::max(1, static_cast<int>(frame.rows * scale));
+    cv::Mat inner = target(cv::Rect((tile.width - width) / 2, (tile.height - height) / 2, width, height));
+
+    // Downscale in BGR, then widen to RGB32 directly into the canvas
+    cv::Mat& scaled = m_scaled[index];
+    cv::resize(frame, scaled, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+    if (gray) {
+        // Processed streams may be grayscale
+        cv::cvtColor(scaled, inner, cv::COLOR_GRAY2BGRA);
+        return;
+    }
+    PixelKernels::convert<PixelKernels::Bgr2Bgrx>(scaled.data, scaled.step, inner.data, inner.step,
+                                                  width, height);
+}
@@ -0,0 +1,37 @@
+#ifndef MOSAICCOMPOSITOR_H
+#define MOSAICCOMPOSITOR_H
+
+#include <opencv2/core.hpp>
+#include <QImage>
+#include <vector>
+
+#include "ThreadPool.h"
+
+// Lays out frames from several cameras in a grid at display size. Each tile
+// is downscaled and converted straight into the shared canvas, with tiles
+// processed in parallel on a thread pool.
+class MosaicCompositor
+{
+public:
+    // 0 threads means one per hardware thread
+    explicit MosaicCompositor(int threads = 0);
+
+    // Compose BGR frames into a width x height RGB32 image, keeping each
+    // frame's aspect ratio. Empty frames leave their tile black. The image
+    // shares the compositor's canvas and is only valid until the next call.
+    QImage compose(const std::vector<cv::Mat>& frames, int width, int height);
+
+    static void gridSize(int count, int& columns, int& rows);
+
+private:
+    void composeTile(int index, const cv::Mat& frame, const cv::Rect& tile);
+
+    ThreadPool m_pool;
+    cv::Mat m_canvas;
+
+    // Per-tile scratch and the frame size each tile was last laid out for
+    std::vector<cv::Mat> m_scaled;
+    std::vector<cv::Size> m_tileSources;
+};
+
+#endif // MOSAICCOMPOSITOR_H
@@ -0,0 +1,255 @@
+#include "ParallelDecodeSource.h"
+#include "FrameAllocator.h"
+#include "PipelineMetrics.h"
+#include <QDebug>
+
+ParallelDecodeSource::ParallelDecodeSource(std::unique_ptr<FrameSource> source, int threads, int maxInFlight)
+    : m_source(std::move(source))
+    , m_native(false)
+    , m_maxInFlight(maxInFlight)
+    , m_resolution(0, 0)
+    , m_fps(0.0)
+    , m_stopRequested(false)
+    , m_readFailed(false)
+    , m_nextSequence(0)
+    , m_nextOutput(0)
+    , m_decoding(0)
+    , m_decodedFrames(0)
+    , m_failedFrames(0)
+    , m_decodeNs(0)
+    , m_fourcc(0)
+    , m_pool(threads)
+{
+    if (m_maxInFlight <= 0) {
+        m_maxInFlight = m_pool.size() + 2;
+    }
+}
+
+ParallelDecodeSource::~ParallelDecodeSource()
+{
+    stopReader();
+}
+
+bool ParallelDecodeSource::open()
+{
+    m_native = m_source->setRawOutput(true);
+    if (!m_source->open()) {
+        return false;
+    }
+    m_resolution = m_source->resolution();
+    m_fps = m_source->fps();
+    if (m_native) {
+        startReader();
+    } else {
+        qDebug() << "No native format for" << QString::fromStdString(m_source->description())
+                 << "- decoding on the capture thread";
+    }
+    return true;
+}
+
+void ParallelDecodeSource::close()
+{
+    stopReader();
+    m_source->close();
+}
+
+bool ParallelDecodeSource::isOpened() const
+{
+    return m_source->isOpened();
+}
+
+bool ParallelDecodeSource::read(cv::Mat& frame)
+{
+    if (!m_native) {
+        return m_source->read(frame);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        auto next = m_decoded.find(m_nextOutput);
+        if (next == m_decoded.end()) {
+            // Nothing more is coming once the reader has stopped
+            if ((m_readFailed || m_stopRequested) && m_nextOutput >= m_nextSequence) {
+                return false;
+            }
+            m_changed.wait(lock);
+            continue;
+        }
+
+        Decoded decoded = std::move(next->second);
+        m_decoded.erase(next);
+        ++m_nextOutput;
+        m_changed.notify_all();
+
+        // A corrupt frame is skipped, as the device would have dropped it.
+        // Otherwise the decoded buffer replaces the caller's, which is taken
+        // in exchange (see FrameSource::read).
+        if (decoded.ok) {
+            std::swap(frame, decoded.frame);
+        }
+        // The buffer taken is decoded into again, unless someone else still
+        // holds it. Other holders release theirs on their own threads, so
+        // the count is read atomically.
+        if (decoded.frame.u && CV_XADD(&decoded.frame.u->refcount, 0) == 1
+            && static_cast<int>(m_spare.size()) < m_maxInFlight) {
+            m_spare.push_back(std::move(decoded.frame));
+        }
+        if (decoded.ok) {
+            return true;
+        }
+    }
+}
+
+bool ParallelDecodeSource::grab()
+{
+    if (!m_native) {
+        return m_source->grab();
+    }
+    // Frames ahead are already being decoded; skipping is taking one
+    return read(m_skipped);
+}
+
+std::pair<int, int> ParallelDecodeSource::setResolution(int width, int height)
+{
+    if (!m_native) {
+        m_resolution = m_source->setResolution(width, height);
+        return m_resolution;
+    }
+
+    // Frames read ahead in the old mode are dropped
+    stopReader();
+    m_resolution = m_source->setResolution(width, height);
+    m_fps = m_source->fps();
+    startReader();
+    return m_resolution;
+}
+
+std::pair<int, int> ParallelDecodeSource::resolution() const
+{
+    return m_native ? m_resolution : m_source->resolution();
+}
+
+std::string ParallelDecodeSource::description() const
+{
+    std::string description = m_source->description();
+    if (m_native) {
+        description += ", decoded on " + std::to_string(m_pool.size()) + " threads";
+    }
+    return description;
+}
+
+std::string ParallelDecodeSource::identity() const
+{
+    return m_source->identity();
+}
+
+ParallelDecodeSource::Stats ParallelDecodeSource::stats() const
+{
+    Stats stats;
+    stats.decoded = m_decodedFrames;
+    stats.failed = m_failedFrames;
+    uint64_t total = stats.decoded + stats.failed;
+    stats.decodeMs = total > 0 ? m_decodeNs / 1e6 / total : 0.0;
+    stats.threads = m_native ? m_pool.size() : 0;
+    stats.fourcc = m_fourcc;
+    return stats;
+}
+
+void ParallelDecodeSource::startReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = false;
+        m_readFailed = false;
+        m_nextSequence = 0;
+        m_nextOutput = 0;
+        m_decoded.clear();
+    }
+    m_reader = std::thread(&ParallelDecodeSource::readLoop, this);
+}
+
+void ParallelDecodeSource::stopReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_changed.notify_all();
+    if (m_reader.joinable()) {
+        m_reader.join();
+    }
+
+    // Let decodes already running finish before their results are dropped
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this] { return m_decoding == 0; });
+    m_decoded.clear();
+}
+
+void ParallelDecodeSource::readLoop()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [this] {
+                return m_stopRequested || m_nextSequence - m_nextOutput < m_maxInFlight;
+            });
+            if (m_stopRequested) {
+                return;
+            }
+        }
+
+        // A fresh frame each time: the last one may still be decoding. Its
+        // buffer comes from the frame pool.
+        RawFrame raw;
+        FrameAllocator::use(raw.data);
+        if (!m_source->readRaw(raw)) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_readFailed = true;
+            }
+            m_changed.notify_all();
+            return;
+        }
+
+        int64_t sequence;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            sequence = m_nextSequence++;
+            ++m_decoding;
+        }
+        m_pool.submit([this, sequence, raw] { decode(sequence, raw); });
+    }
+}
+
+void ParallelDecodeSource::decode(int64_t sequence, RawFrame raw)
+{
+    cv::Mat frame;
+    FrameAllocator::use(frame);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_spare.empty()) {
+            frame = std::move(m_spare.back());
+            m_spare.pop_back();
+        }
+    }
+
+    int64_t start = PipelineMetrics::now();
+    bool ok = decodeRawFrame(raw, frame);
+    m_decodeNs += PipelineMetrics::now() - start;
+    if (ok) {
+        ++m_decodedFrames;
+    } else {
+        ++m_failedFrames;
+    }
+    m_fourcc = raw.fourcc;
+    raw.data.release();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Decoded& decoded = m_decoded[sequence];
+        decoded.frame = std::move(frame);
+        decoded.ok = ok;
+        --m_decoding;
+    }
+    m_changed.notify_all();
+}
@@ -0,0 +1,104 @@
+#ifndef PARALLELDECODESOURCE_H
+#define PARALLELDECODESOURCE_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FrameSource.h"
+#include "ThreadPool.h"
+
+// Takes decoding off the capture thread for sources with a native format
+// (cameras in MJPEG or YUYV mode, recorded MJPEG streams).
+//
+// A reader thread pulls raw frames from the wrapped source as fast as it
+// delivers them and hands each to a worker pool for JPEG decode or YUV
+// conversion; read() returns the decoded frames in capture order. Several
+// frames decode at once, so the device is drained at its full rate even
+// when one decode takes longer than a frame interval. The reader stays at
+// most maxInFlight frames ahead of read(); beyond that it stops reading and
+// the device drops frames, as it would for a slow reader.
+//
+// Sources without a native format are read directly, as if unwrapped.
+class ParallelDecodeSource : public FrameSource
+{
+public:
+    struct Stats {
+        uint64_t decoded = 0;
+        uint64_t failed = 0;        // corrupt frames, skipped
+        double decodeMs = 0.0;      // mean per frame on one worker
+        int threads = 0;
+        uint32_t fourcc = 0;        // native format of the last frame, 0 if none
+    };
+
+    // threads 0 means one per hardware thread; maxInFlight 0 means two more
+    // than the number of threads
+    explicit ParallelDecodeSource(std::unique_ptr<FrameSource> source, int threads = 0, int maxInFlight = 0);
+    ~ParallelDecodeSource() override;
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override;
+    bool read(cv::Mat& frame) override;
+    bool grab() override;
+    std::pair<int, int> setResolution(int width, int height) override;
+    std::pair<int, int> resolution() const override;
+    std::string description() const override;
+    double fps() const override { return m_fps; }
+    std::string identity() const override;
+
+    // Already decoded here; raw output would undo the point of wrapping
+    bool setRawOutput(bool raw) override { return !raw; }
+
+    Stats stats() const;
+
+private:
+    struct Decoded {
+        cv::Mat frame;
+        bool ok = false;
+    };
+
+    void startReader();
+    void stopReader();
+    void readLoop();
+    void decode(int64_t sequence, RawFrame raw);
+
+    std::unique_ptr<FrameSource> m_source;
+    bool m_native;
+    int m_maxInFlight;
+
+    // Cached so control calls do not touch the source under the reader
+    std::pair<int, int> m_resolution;
+    double m_fps;
+
+    // Frames between the reader and read(), by sequence. Decoded buffers
+    // handed back by read() are reused for later frames when nobody else
+    // holds them.
+    std::thread m_reader;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_stopRequested;
+    bool m_readFailed;
+    int64_t m_nextSequence;
+    int64_t m_nextOutput;
+    int m_decoding;
+    std::map<int64_t, Decoded> m_decoded;
+    std::vector<cv::Mat> m_spare;
+    cv::Mat m_skipped;
+
+    std::atomic<uint64_t> m_decodedFrames;
+    std::atomic<uint64_t> m_failedFrames;
+    std::atomic<int64_t> m_decodeNs;
+    std::atomic<uint32_t> m_fourcc;
+
+    // Last, so workers are joined before anything they use goes away
+    ThreadPool m_pool;
+};
+
+#endif // PARALLELDECODESOURCE_H
@@ -0,0 +1,238 @@
+#include "PipelineMetrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+double toMilliseconds(int64_t nanoseconds)
+{
+    return nanoseconds / 1e6;
+}
+
+// Nearest-rank percentile of an already sorted sample set
+int64_t percentile(const std::vector<int64_t>& sorted, double fraction)
+{
+    size_t rank = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+void PipelineMetrics::Histogram::record(int64_t nanoseconds)
+{
+    uint64_t count = m_count.load(std::memory_order_relaxed);
+    m_samples[count % WINDOW].store(nanoseconds, std::memory_order_relaxed);
+    m_count.store(count + 1, std::memory_order_release);
+}
+
+PipelineMetrics::StageSummary PipelineMetrics::Histogram::summary() const
+{
+    StageSummary summary;
+    uint64_t count = m_count.load(std::memory_order_acquire);
+    size_t available = static_cast<size_t>(std::min<uint64_t>(count, WINDOW));
+    if (available == 0) {
+        return summary;
+    }
+
+    std::vector<int64_t> samples(available);
+    int64_t total = 0;
+    for (size_t i = 0; i < available; ++i) {
+        samples[i] = m_samples[i].load(std::memory_order_relaxed);
+        total += samples[i];
+    }
+    std::sort(samples.begin(), samples.end());
+
+    summary.p50Ms = toMilliseconds(percentile(samples, 0.50));
+    summary.p95Ms = toMilliseconds(percentile(samples, 0.95));
+    summary.p99Ms = toMilliseconds(percentile(samples, 0.99));
+    summary.meanMs = toMilliseconds(total / static_cast<int64_t>(available));
+    summary.samples = available;
+    return summary;
+}
+
+void PipelineMetrics::Histogram::reset()
+{
+    m_count.store(0, std::memory_order_release);
+}
+
+void PipelineMetrics::RateMeter::tick(int64_t timestamp)
+{
+    uint64_t count = m_count.load(std::memory_order_relaxed);
+    m_timestamps[count % WINDOW].store(timestamp, std::memory_order_relaxed);
+    m_count.store(count + 1, std::memory_order_release);
+}
+
+double PipelineMetrics::RateMeter::rate() const
+{
+    uint64_t count = m_count.load(std::memory_order_acquire);
+    if (count < 2) {
+        return 0.0;
+    }
+
+    uint64_t span = std::min<uint64_t>(count, WINDOW) - 1;
+    int64_t newest = m_timestamps[(count - 1) % WINDOW].load(std::memory_order_relaxed);
+    int64_t oldest = m_timestamps[(count - 1 - span) % WINDOW].load(std::memory_order_relaxed);
+    if (newest <= oldest) {
+        return 0.0;
+    }
+    return span * 1e9 / static_cast<double>(newest - oldest);
+}
+
+double PipelineMetrics::RateMeter::jitterMs() const
+{
+    uint64_t count = m_count.load(std::memory_order_acquire);
+    if (count < 3) {
+        return 0.0;
+    }
+
+    // Standard deviation of the intervals between recent events
+    uint64_t intervals = std::min<uint64_t>(count, WINDOW) - 1;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    for (uint64_t i = 0; i < intervals; ++i) {
+        int64_t later = m_timestamps[(count - 1 - i) % WINDOW].load(std::memory_order_relaxed);
+        int64_t earlier = m_timestamps[(count - 2 - i) % WINDOW].load(std::memory_order_relaxed);
+        double interval = toMilliseconds(later - earlier);
+        sum += interval;
+        sumSquares += interval * interval;
+    }
+    double mean = sum / intervals;
+    return std::sqrt(std::max(0.0, sumSquares / intervals - mean * mean));
+}
+
+void PipelineMetrics::RateMeter::reset()
+{
+    m_count.store(0, std::memory_order_release);
+}
+
+PipelineMetrics::PipelineMetrics()
+    : m_captured(0)
+    , m_displayed(0)
+    , m_dropped(0)
+    , m_startTime(now())
+{
+}
+
+void PipelineMetrics::record(Stage stage, int64_t nanoseconds)
+{
+    m_stages[stage].record(nanoseconds);
+}
+
+void PipelineMetrics::frameCaptured(int64_t timestamp)
+{
+    m_captureRate.tick(timestamp);
+    m_captured.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipelineMetrics::frameDisplayed(int64_t timestamp)
+{
+    m_displayRate.tick(timestamp);
+    m_displayed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipelineMetrics::framesDropped(uint64_t count)
+{
+    m_dropped.fetch_add(count, std::memory_order_relaxed);
+}
+
+PipelineMetrics::Snapshot PipelineMetrics::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.uptimeSeconds = (now() - m_startTime.load()) / 1e9;
+    snapshot.captureFps = m_captureRate.rate();
+    snapshot.displayFps = m_displayRate.rate();
+    snapshot.captureJitterMs = m_captureRate.jitterMs();
+    snapshot.displayJitterMs = m_displayRate.jitterMs();
+    snapshot.framesCaptured = m_captured.load(std::memory_order_relaxed);
+    snapshot.framesDisplayed = m_displayed.load(std::memory_order_relaxed);
+    snapshot.framesDropped = m_dropped.load(std::memory_order_relaxed);
+    for (int stage = 0; stage < StageCount; ++stage) {
+        snapshot.stages[stage] = m_stages[stage].summary();
+    }
+    return snapshot;
+}
+
+void PipelineMetrics::reset()
+{
+    for (auto& stage : m_stages) {
+        stage.reset();
+    }
+    m_captureRate.reset();
+    m_displayRate.reset();
+    m_captured = 0;
+    m_displayed = 0;
+    m_dropped = 0;
+    m_startTime = now();
+}
+
+const char* PipelineMetrics::stageName(Stage stage)
+{
+    switch (stage) {
+        case Capture: return "capture";
+        case Queue: return "queue";
+        case Convert: return "convert";
+        case Paint: return "paint";
+        case EndToEnd: return "end_to_end";
+        default: return "unknown";
+    }
+}
+
+std::string PipelineMetrics::toJson(const Snapshot& snapshot)
+{
+    char buffer[384];
+    std::string json;
+
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"uptime_s\":%.3f,\"capture_fps\":%.2f,\"display_fps\":%.2f,"
+                  "\"capture_jitter_ms\":%.3f,\"display_jitter_ms\":%.3f,"
+                  "\"captured\":%llu,\"displayed\":%llu,\"dropped\":%llu,\"stages\":{",
+                  snapshot.uptimeSeconds, snapshot.captureFps, snapshot.displayFps,
+                  snapshot.captureJitterMs, snapshot.displayJitterMs,
+                  static_cast<unsigned long long>(snapshot.framesCaptured),
+                  static_cast<unsigned long long>(snapshot.framesDisplayed),
+                  static_cast<unsigned long long>(snapshot.framesDropped));
+    json += buffer;
+
+    for (int stage = 0; stage < StageCount; ++stage) {
+        const StageSummary& summary = snapshot.stages[stage];
+        std::snprintf(buffer, sizeof(buffer),
+                      "%s\"%s\":{\"p50_ms\":%.3f,\"p95_ms\":%.3f,\"p99_ms\":%.3f,\"mean_ms\":%.3f,\"samples\":%zu}",
+                      stage == 0 ? "" : ",", stageName(static_cast<Stage>(stage)),
+                      summary.p50Ms, summary.p95Ms, summary.p99Ms, summary.meanMs, summary.samples);
+        json += buffer;
+    }
+
+    json += "}}";
+    return json;
+}
+
+std::string PipelineMetrics::csvHeader()
+{
+    std::string header = "uptime_s,capture_fps,display_fps,captured,displayed,dropped,"
+                         "capture_jitter_ms,display_jitter_ms";
+    for (int stage = 0; stage < StageCount; ++stage) {
+        std::string name = stageName(static_cast<Stage>(stage));
+        header += "," + name + "_p50_ms," + name + "_p95_ms," + name + "_p99_ms";
+    }
+    return header;
+}
+
+std::string PipelineMetrics::toCsv(const Snapshot& snapshot)
+{
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), "%.3f,%.2f,%.2f,%llu,%llu,%llu,%.3f,%.3f",
+                  snapshot.uptimeSeconds, snapshot.captureFps, snapshot.displayFps,
+                  static_cast<unsigned long long>(snapshot.framesCaptured),
+                  static_cast<unsigned long long>(snapshot.framesDisplayed),
+                  static_cast<unsigned long long>(snapshot.framesDropped),
+                  snapshot.captureJitterMs, snapshot.displayJitterMs);
+    std::string row = buffer;
+
+    for (const auto& summary : snapshot.stages) {
+        std::snprintf(buffer, sizeof(buffer), ",%.3f,%.3f,%.3f", summary.p50Ms, summary.p95Ms, summary.p99Ms);
+        row += buffer;
+    }
+    return row;
+}
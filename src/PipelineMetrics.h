@@ -0,0 +1,107 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Low-overhead per-stage timing for the capture -> display path. Each stage
+// keeps a rolling window of recent samples from which percentiles are
+// computed on demand; recording is a clock read and an atomic store. Every
+// stage and rate meter must be fed from a single thread.
+class PipelineMetrics
+{
+public:
+    enum Stage {
+        Capture,    // blocked in FrameSource::read on the capture thread
+        Queue,      // captured until picked up by the GUI
+        Convert,    // cv::Mat to QPixmap/QImage
+        Paint,      // widget paint, including scaling
+        EndToEnd,   // captured until painted
+        StageCount
+    };
+
+    struct StageSummary {
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        double meanMs = 0.0;
+        size_t samples = 0;
+    };
+
+    struct Snapshot {
+        double uptimeSeconds = 0.0;
+        double captureFps = 0.0;        // measured device frame rate
+        double displayFps = 0.0;
+        double captureJitterMs = 0.0;   // std deviation of frame intervals
+        double displayJitterMs = 0.0;
+        uint64_t framesCaptured = 0;
+        uint64_t framesDisplayed = 0;
+        uint64_t framesDropped = 0;
+        std::array<StageSummary, StageCount> stages;
+    };
+
+    PipelineMetrics();
+
+    // Monotonic timestamp in nanoseconds
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(Stage stage, int64_t nanoseconds);
+    void frameCaptured(int64_t timestamp);
+    void frameDisplayed(int64_t timestamp);
+    void framesDropped(uint64_t count);
+
+    Snapshot snapshot() const;
+    void reset();
+
+    static const char* stageName(Stage stage);
+    static std::string toJson(const Snapshot& snapshot);
+    static std::string csvHeader();
+    static std::string toCsv(const Snapshot& snapshot);
+
+private:
+    class Histogram
+    {
+    public:
+        void record(int64_t nanoseconds);
+        StageSummary summary() const;
+        void reset();
+
+    private:
+        static constexpr size_t WINDOW = 512;
+        std::array<std::atomic<int64_t>, WINDOW> m_samples{};
+        std::atomic<uint64_t> m_count{0};
+    };
+
+    // Frames per second over the most recent events
+    class RateMeter
+    {
+    public:
+        void tick(int64_t timestamp);
+        double rate() const;
+        double jitterMs() const;
+        void reset();
+
+    private:
+        static constexpr size_t WINDOW = 64;
+        std::array<std::atomic<int64_t>, WINDOW> m_timestamps{};
+        std::atomic<uint64_t> m_count{0};
+    };
+
+    std::array<Histogram, StageCount> m_stages;
+    RateMeter m_captureRate;
+    RateMeter m_displayRate;
+    std::atomic<uint64_t> m_captured;
+    std::atomic<uint64_t> m_displayed;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<int64_t> m_startTime;
+};
+
+#endif // PIPELINEMETRICS_H
@@ -0,0 +1,541 @@
+#include "PixelKernels.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PIXELKERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PIXELKERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PIXELKERNELS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PIXELKERNELS_TARGET(isa)
+#endif
+
+namespace PixelKernels {
+
+namespace {
+
+using RowFunction = void (*)(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width);
+
+// OpenCV's BT.601 fixed-point coefficients for YUV -> RGB
+const int YUV_SHIFT = 20;
+const int YUV_HALF = 1 << (YUV_SHIFT - 1);
+const int YUV_CY = 1220542;
+const int YUV_CUB = 2116026;
+const int YUV_CUG = -409993;
+const int YUV_CVG = -852492;
+const int YUV_CVR = 1673527;
+
+inline uint8_t saturate(int value)
+{
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+inline void yuvToRgb(int y, int u, int v, uint8_t* dst)
+{
+    int yy = std::max(0, y - 16) * YUV_CY;
+    int uu = u - 128;
+    int vv = v - 128;
+    dst[0] = saturate((yy + YUV_HALF + YUV_CVR * vv) >> YUV_SHIFT);
+    dst[1] = saturate((yy + YUV_HALF + YUV_CVG * vv + YUV_CUG * uu) >> YUV_SHIFT);
+    dst[2] = saturate((yy + YUV_HALF + YUV_CUB * uu) >> YUV_SHIFT);
+}
+
+// Scalar kernels; the SIMD kernels use these for the row tail
+
+void bgr2rgbScalar(const uint8_t* src, const uint8_t*, uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x, src += 3, dst += 3) {
+        uint8_t b = src[0];
+        dst[1] = src[1];
+        dst[0] = src[2];
+        dst[2] = b;
+    }
+}
+
+void bgr2bgrxScalar(const uint8_t* src, const uint8_t*, uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x, src += 3, dst += 4) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = 0xff;
+    }
+}
+
+void bgra2rgbaScalar(const uint8_t* src, const uint8_t*, uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x, src += 4, dst += 4) {
+        uint8_t b = src[0];
+        dst[1] = src[1];
+        dst[0] = src[2];
+        dst[2] = b;
+        dst[3] = src[3];
+    }
+}
+
+void grayCopy(const uint8_t* src, const uint8_t*, uint8_t* dst, int width)
+{
+    std::memcpy(dst, src, static_cast<size_t>(width));
+}
+
+void yuyv2rgbScalar(const uint8_t* src, const uint8_t*, uint8_t* dst, int width)
+{
+    for (int x = 0; x + 1 < width; x += 2, src += 4, dst += 6) {
+        yuvToRgb(src[0], src[1], src[3], dst);
+        yuvToRgb(src[2], src[1], src[3], dst + 3);
+    }
+}
+
+void nv12ToRgbScalar(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    for (int x = 0; x + 1 < width; x += 2, src += 2, uv += 2, dst += 6) {
+        yuvToRgb(src[0], uv[0], uv[1], dst);
+        yuvToRgb(src[1], uv[0], uv[1], dst + 3);
+    }
+}
+
+#if defined(PIXELKERNELS_X86)
+
+// SSE4.1 kernels
+
+PIXELKERNELS_TARGET("sse4.1")
+void bgr2rgbSse41(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    // Five pixels per 16-byte load; the 16th byte is rewritten next round
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+    int x = 0;
+    for (; x + 6 <= width; x += 5) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 3), _mm_shuffle_epi8(pixels, mask));
+    }
+    bgr2rgbScalar(src + x * 3, uv, dst + x * 3, width - x);
+}
+
+PIXELKERNELS_TARGET("sse4.1")
+void bgr2bgrxSse41(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    const __m128i mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    int x = 0;
+    for (; x + 6 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+        pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, mask), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), pixels);
+    }
+    bgr2bgrxScalar(src + x * 3, uv, dst + x * 4, width - x);
+}
+
+PIXELKERNELS_TARGET("sse4.1")
+void bgra2rgbaSse41(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_shuffle_epi8(pixels, mask));
+    }
+    bgra2rgbaScalar(src + x * 4, uv, dst + x * 4, width - x);
+}
+
+// Four pixels of 32-bit Y, U, V lanes to 12 RGB bytes (16 bytes stored)
+PIXELKERNELS_TARGET("sse4.1")
+inline void yuvToRgbSse41(__m128i y, __m128i u, __m128i v, uint8_t* dst)
+{
+    const __m128i half = _mm_set1_epi32(YUV_HALF);
+    y = _mm_mullo_epi32(_mm_max_epi32(_mm_sub_epi32(y, _mm_set1_epi32(16)), _mm_setzero_si128()),
+                        _mm_set1_epi32(YUV_CY));
+    u = _mm_sub_epi32(u, _mm_set1_epi32(128));
+    v = _mm_sub_epi32(v, _mm_set1_epi32(128));
+
+    __m128i ruv = _mm_add_epi32(half, _mm_mullo_epi32(v, _mm_set1_epi32(YUV_CVR)));
+    __m128i guv = _mm_add_epi32(half, _mm_add_epi32(_mm_mullo_epi32(v, _mm_set1_epi32(YUV_CVG)),
+                                                    _mm_mullo_epi32(u, _mm_set1_epi32(YUV_CUG))));
+    __m128i buv = _mm_add_epi32(half, _mm_mullo_epi32(u, _mm_set1_epi32(YUV_CUB)));
+
+    __m128i r = _mm_srai_epi32(_mm_add_epi32(y, ruv), YUV_SHIFT);
+    __m128i g = _mm_srai_epi32(_mm_add_epi32(y, guv), YUV_SHIFT);
+    __m128i b = _mm_srai_epi32(_mm_add_epi32(y, buv), YUV_SHIFT);
+
+    // r0-3 g0-3 b0-3 b0-3 with unsigned saturation, then interleave
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(r, g), _mm_packs_epi32(b, b));
+    const __m128i interleave = _mm_setr_epi8(0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(packed, interleave));
+}
+
+PIXELKERNELS_TARGET("sse4.1")
+void yuyv2rgbSse41(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    const __m128i yMask = _mm_setr_epi8(0, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i uMask = _mm_setr_epi8(1, 1, 5, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i vMask = _mm_setr_epi8(3, 3, 7, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    int x = 0;
+    for (; x + 6 <= width; x += 4) {
+        __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x * 2));
+        yuvToRgbSse41(_mm_cvtepu8_epi32(_mm_shuffle_epi8(pixels, yMask)),
+                      _mm_cvtepu8_epi32(_mm_shuffle_epi8(pixels, uMask)),
+                      _mm_cvtepu8_epi32(_mm_shuffle_epi8(pixels, vMask)),
+                      dst + x * 3);
+    }
+    yuyv2rgbScalar(src + x * 2, uv, dst + x * 3, width - x);
+}
+
+PIXELKERNELS_TARGET("sse4.1")
+void nv12ToRgbSse41(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    const __m128i uMask = _mm_setr_epi8(0, 0, 2, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i vMask = _mm_setr_epi8(1, 1, 3, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    int x = 0;
+    for (; x + 6 <= width; x += 4) {
+        int32_t luma = 0;
+        int32_t chroma = 0;
+        std::memcpy(&luma, src + x, sizeof(luma));
+        std::memcpy(&chroma, uv + x, sizeof(chroma));
+        __m128i uvPixels = _mm_cvtsi32_si128(chroma);
+        yuvToRgbSse41(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(luma)),
+                      _mm_cvtepu8_epi32(_mm_shuffle_epi8(uvPixels, uMask)),
+                      _mm_cvtepu8_epi32(_mm_shuffle_epi8(uvPixels, vMask)),
+                      dst + x * 3);
+    }
+    nv12ToRgbScalar(src + x, uv + x, dst + x * 3, width - x);
+}
+
+// AVX2 kernels. Byte shuffles only work within 128-bit lanes; for packed
+// 24-bit input the lane-crossing permutes cost more than the wider shuffle
+// saves (the conversion is memory bound), so those formats stay on SSE4.1.
+
+PIXELKERNELS_TARGET("avx2")
+inline void storeHalves(uint8_t* low, uint8_t* high, __m256i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(low), _mm256_castsi256_si128(value));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(high), _mm256_extracti128_si256(value, 1));
+}
+
+PIXELKERNELS_TARGET("avx2")
+void bgra2rgbaAvx2(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), _mm256_shuffle_epi8(pixels, mask));
+    }
+    bgra2rgbaSse41(src + x * 4, uv, dst + x * 4, width - x);
+}
+
+// Eight pixels of 32-bit Y, U, V lanes to 24 RGB bytes (28 bytes stored)
+PIXELKERNELS_TARGET("avx2")
+inline void yuvToRgbAvx2(__m256i y, __m256i u, __m256i v, uint8_t* dst)
+{
+    const __m256i half = _mm256_set1_epi32(YUV_HALF);
+    y = _mm256_mullo_epi32(_mm256_max_epi32(_mm256_sub_epi32(y, _mm256_set1_epi32(16)), _mm256_setzero_si256()),
+                           _mm256_set1_epi32(YUV_CY));
+    u = _mm256_sub_epi32(u, _mm256_set1_epi32(128));
+    v = _mm256_sub_epi32(v, _mm256_set1_epi32(128));
+
+    __m256i ruv = _mm256_add_epi32(half, _mm256_mullo_epi32(v, _mm256_set1_epi32(YUV_CVR)));
+    __m256i guv = _mm256_add_epi32(half, _mm256_add_epi32(_mm256_mullo_epi32(v, _mm256_set1_epi32(YUV_CVG)),
+                                                          _mm256_mullo_epi32(u, _mm256_set1_epi32(YUV_CUG))));
+    __m256i buv = _mm256_add_epi32(half, _mm256_mullo_epi32(u, _mm256_set1_epi32(YUV_CUB)));
+
+    __m256i r = _mm256_srai_epi32(_mm256_add_epi32(y, ruv), YUV_SHIFT);
+    __m256i g = _mm256_srai_epi32(_mm256_add_epi32(y, guv), YUV_SHIFT);
+    __m256i b = _mm256_srai_epi32(_mm256_add_epi32(y, buv), YUV_SHIFT);
+
+    // Per lane: r g b b (four pixels each), then interleave to RGB
+    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(r, g), _mm256_packs_epi32(b, b));
+    const __m256i interleave = _mm256_setr_epi8(0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1,
+                                                0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1);
+    storeHalves(dst, dst + 12, _mm256_shuffle_epi8(packed, interleave));
+}
+
+PIXELKERNELS_TARGET("avx2")
+void yuyv2rgbAvx2(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    const __m128i yMask = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i uMask = _mm_setr_epi8(1, 1, 5, 5, 9, 9, 13, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i vMask = _mm_setr_epi8(3, 3, 7, 7, 11, 11, 15, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+    int x = 0;
+    for (; x + 10 <= width; x += 8) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2));
+        yuvToRgbAvx2(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(pixels, yMask)),
+                     _mm256_cvtepu8_epi32(_mm_shuffle_epi8(pixels, uMask)),
+                     _mm256_cvtepu8_epi32(_mm_shuffle_epi8(pixels, vMask)),
+                     dst + x * 3);
+    }
+    yuyv2rgbSse41(src + x * 2, uv, dst + x * 3, width - x);
+}
+
+PIXELKERNELS_TARGET("avx2")
+void nv12ToRgbAvx2(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    const __m128i uMask = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i vMask = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+    int x = 0;
+    for (; x + 10 <= width; x += 8) {
+        __m128i luma = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x));
+        __m128i chroma = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(uv + x));
+        yuvToRgbAvx2(_mm256_cvtepu8_epi32(luma),
+                     _mm256_cvtepu8_epi32(_mm_shuffle_epi8(chroma, uMask)),
+                     _mm256_cvtepu8_epi32(_mm_shuffle_epi8(chroma, vMask)),
+                     dst + x * 3);
+    }
+    nv12ToRgbSse41(src + x, uv + x, dst + x * 3, width - x);
+}
+
+#endif // PIXELKERNELS_X86
+
+#if defined(PIXELKERNELS_NEON)
+
+// NEON kernels; de-interleaving loads make the channel swaps trivial. The
+// YUV formats use the scalar kernels on ARM.
+
+void bgr2rgbNeon(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x3_t pixels = vld3q_u8(src + x * 3);
+        uint8x16_t b = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = b;
+        vst3q_u8(dst + x * 3, pixels);
+    }
+    bgr2rgbScalar(src + x * 3, uv, dst + x * 3, width - x);
+}
+
+void bgr2bgrxNeon(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x3_t pixels = vld3q_u8(src + x * 3);
+        uint8x16x4_t out;
+        out.val[0] = pixels.val[0];
+        out.val[1] = pixels.val[1];
+        out.val[2] = pixels.val[2];
+        out.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(dst + x * 4, out);
+    }
+    bgr2bgrxScalar(src + x * 3, uv, dst + x * 4, width - x);
+}
+
+void bgra2rgbaNeon(const uint8_t* src, const uint8_t* uv, uint8_t* dst, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t pixels = vld4q_u8(src + x * 4);
+        uint8x16_t b = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = b;
+        vst4q_u8(dst + x * 4, pixels);
+    }
+    bgra2rgbaScalar(src + x * 4, uv, dst + x * 4, width - x);
+}
+
+#endif // PIXELKERNELS_NEON
+
+// Per-format kernel tables, resolved at compile time by the format tag
+template <typename Format>
+struct Kernels;
+
+template <>
+struct Kernels<Bgr2Rgb>
+{
+    static RowFunction row(Isa isa)
+    {
+        switch (isa) {
+#if defined(PIXELKERNELS_X86)
+            case Isa::Avx2:
+            case Isa::Sse41: return bgr2rgbSse41;
+#endif
+#if defined(PIXELKERNELS_NEON)
+            case Isa::Neon: return bgr2rgbNeon;
+#endif
+            default: return bgr2rgbScalar;
+        }
+    }
+};
+
+template <>
+struct Kernels<Bgr2Bgrx>
+{
+    static RowFunction row(Isa isa)
+    {
+        switch (isa) {
+#if defined(PIXELKERNELS_X86)
+            case Isa::Avx2:
+            case Isa::Sse41: return bgr2bgrxSse41;
+#endif
+#if defined(PIXELKERNELS_NEON)
+            case Isa::Neon: return bgr2bgrxNeon;
+#endif
+            default: return bgr2bgrxScalar;
+        }
+    }
+};
+
+template <>
+struct Kernels<Bgra2Rgba>
+{
+    static RowFunction row(Isa isa)
+    {
+        switch (isa) {
+#if defined(PIXELKERNELS_X86)
+            case Isa::Avx2: return bgra2rgbaAvx2;
+            case Isa::Sse41: return bgra2rgbaSse41;
+#endif
+#if defined(PIXELKERNELS_NEON)
+            case Isa::Neon: return bgra2rgbaNeon;
+#endif
+            default: return bgra2rgbaScalar;
+        }
+    }
+};
+
+template <>
+struct Kernels<GrayCopy>
+{
+    // memcpy is already vectorised by the C library
+    static RowFunction row(Isa) { return grayCopy; }
+};
+
+template <>
+struct Kernels<Yuyv2Rgb>
+{
+    static RowFunction row(Isa isa)
+    {
+        switch (isa) {
+#if defined(PIXELKERNELS_X86)
+            case Isa::Avx2: return yuyv2rgbAvx2;
+            case Isa::Sse41: return yuyv2rgbSse41;
+#endif
+            default: return yuyv2rgbScalar;
+        }
+    }
+};
+
+template <>
+struct Kernels<Nv12ToRgb>
+{
+    static RowFunction row(Isa isa)
+    {
+        switch (isa) {
+#if defined(PIXELKERNELS_X86)
+            case Isa::Avx2: return nv12ToRgbAvx2;
+            case Isa::Sse41: return nv12ToRgbSse41;
+#endif
+            default: return nv12ToRgbScalar;
+        }
+    }
+};
+
+template <typename Format>
+void convertRows(RowFunction row, const uint8_t* src, size_t srcStride,
+                 uint8_t* dst, size_t dstStride, int width, int height)
+{
+    const uint8_t* uvPlane = Format::planar ? src + srcStride * height : nullptr;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* uv = uvPlane ? uvPlane + srcStride * (y / 2) : nullptr;
+        row(src + srcStride * y, uv, dst + dstStride * y, width);
+    }
+}
+
+} // namespace
+
+Isa detectIsa()
+{
+    static const Isa detected = [] {
+#if defined(PIXELKERNELS_X86)
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return Isa::Avx2;
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return Isa::Sse41;
+        }
+#elif defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) {
+                return Isa::Avx2;
+            }
+        }
+        if (sse41) {
+            return Isa::Sse41;
+        }
+#endif
+#elif defined(PIXELKERNELS_NEON)
+        return Isa::Neon;
+#endif
+        return Isa::Scalar;
+    }();
+    return detected;
+}
+
+const char* isaName(Isa isa)
+{
+    switch (isa) {
+        case Isa::Sse41: return "SSE4.1";
+        case Isa::Avx2: return "AVX2";
+        case Isa::Neon: return "NEON";
+        default: return "scalar";
+    }
+}
+
+bool isSupported(Isa isa)
+{
+    Isa best = detectIsa();
+    switch (isa) {
+        case Isa::Scalar: return true;
+        case Isa::Sse41: return best == Isa::Sse41 || best == Isa::Avx2;
+        case Isa::Avx2: return best == Isa::Avx2;
+        case Isa::Neon: return best == Isa::Neon;
+    }
+    return false;
+}
+
+template <typename Format>
+void convert(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height)
+{
+    static const RowFunction row = Kernels<Format>::row(detectIsa());
+    convertRows<Format>(row, src, srcStride, dst, dstStride, width, height);
+}
+
+template <typename Format>
+void convert(Isa isa, const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height)
+{
+    RowFunction row = Kernels<Format>::row(isSupported(isa) ? isa : Isa::Scalar);
+    convertRows<Format>(row, src, srcStride, dst, dstStride, width, height);
+}
+
+#define PIXELKERNELS_INSTANTIATE(Format) \
+    template void convert<Format>(const uint8_t*, size_t, uint8_t*, size_t, int, int); \
+    template void convert<Format>(Isa, const uint8_t*, size_t, uint8_t*, size_t, int, int);
+
+PIXELKERNELS_INSTANTIATE(Bgr2Rgb)
+PIXELKERNELS_INSTANTIATE(Bgr2Bgrx)
+PIXELKERNELS_INSTANTIATE(Bgra2Rgba)
+PIXELKERNELS_INSTANTIATE(GrayCopy)
+PIXELKERNELS_INSTANTIATE(Yuyv2Rgb)
+PIXELKERNELS_INSTANTIATE(Nv12ToRgb)
+
+#undef PIXELKERNELS_INSTANTIATE
+
+} // namespace PixelKernels
@@ -0,0 +1,44 @@
+#ifndef PIXELKERNELS_H
+#define PIXELKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Pixel format conversion kernels, specialised per format at compile time
+// and dispatched at runtime to the widest instruction set the CPU supports
+// (AVX2, SSE4.1, NEON, or a scalar fallback). The YUV kernels reproduce
+// OpenCV's fixed-point BT.601 conversion bit for bit.
+namespace PixelKernels {
+
+enum class Isa {
+    Scalar,
+    Sse41,
+    Avx2,
+    Neon
+};
+
+Isa detectIsa();
+const char* isaName(Isa isa);
+bool isSupported(Isa isa);
+
+// Format tags. Packed formats read one source row per output row; NV12 reads
+// the luma plane followed by the interleaved UV plane from the same buffer.
+struct Bgr2Rgb   { static const int srcChannels = 3; static const int dstChannels = 3; static const bool planar = false; };
+struct Bgr2Bgrx  { static const int srcChannels = 3; static const int dstChannels = 4; static const bool planar = false; };
+struct Bgra2Rgba { static const int srcChannels = 4; static const int dstChannels = 4; static const bool planar = false; };
+struct GrayCopy  { static const int srcChannels = 1; static const int dstChannels = 1; static const bool planar = false; };
+struct Yuyv2Rgb  { static const int srcChannels = 2; static const int dstChannels = 3; static const bool planar = false; };
+struct Nv12ToRgb { static const int srcChannels = 1; static const int dstChannels = 3; static const bool planar = true; };
+
+// Convert a width x height frame using the best kernel for this CPU
+template <typename Format>
+void convert(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height);
+
+// Same, forcing a particular instruction set (for benchmarks); falls back
+// to scalar if the CPU or build does not support it
+template <typename Format>
+void convert(Isa isa, const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height);
+
+} // namespace PixelKernels
+
+#endif // PIXELKERNELS_H
@@ -0,0 +1,144 @@
+#include "ProcessingStage.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+ResizeStage::ResizeStage(int width, int height)
+    : m_width(width)
+    , m_height(height)
+{
+}
+
+std::string ResizeStage::name() const
+{
+    return "resize " + std::to_string(m_width) + "x" + std::to_string(m_height);
+}
+
+void ResizeStage::process(const std::vector<const cv::Mat*>& inputs, const Context&, cv::Mat& output)
+{
+    cv::resize(*inputs[0], output, cv::Size(m_width, m_height), 0.0, 0.0, cv::INTER_AREA);
+}
+
+void GrayscaleStage::process(const std::vector<const cv::Mat*>& inputs, const Context&, cv::Mat& output)
+{
+    const cv::Mat& input = *inputs[0];
+    if (input.channels() == 1) {
+        input.copyTo(output);
+        return;
+    }
+    cv::cvtColor(input, output, input.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+}
+
+DenoiseStage::DenoiseStage(int kernelSize)
+    : m_kernelSize(std::max(kernelSize, 1) | 1)
+{
+}
+
+std::string DenoiseStage::name() const
+{
+    return "denoise " + std::to_string(m_kernelSize);
+}
+
+void DenoiseStage::process(const std::vector<const cv::Mat*>& inputs, const Context&, cv::Mat& output)
+{
+    cv::GaussianBlur(*inputs[0], output, cv::Size(m_kernelSize, m_kernelSize), 0.0);
+}
+
+TemporalDenoiseStage::TemporalDenoiseStage(double weight)
+    : m_weight(std::min(std::max(weight, 0.0), 1.0))
+{
+}
+
+std::string TemporalDenoiseStage::name() const
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "temporal %.2f", m_weight);
+    return text;
+}
+
+void TemporalDenoiseStage::process(const std::vector<const cv::Mat*>& inputs, const Context&, cv::Mat& output)
+{
+    const cv::Mat& input = *inputs[0];
+    // Start over after a resolution change
+    if (m_previous.size() != input.size() || m_previous.type() != input.type()) {
+        input.copyTo(output);
+    } else {
+        cv::addWeighted(input, 1.0 - m_weight, m_previous, m_weight, 0.0, output);
+    }
+    output.copyTo(m_previous);
+}
+
+void OverlayStage::process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output)
+{
+    inputs[0]->copyTo(output);
+
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    // localtime() shares one buffer; this stage runs on several threads
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char clock[16];
+    std::strftime(clock, sizeof(clock), "%H:%M:%S", &local);
+    std::string text = "#" + std::to_string(context.sequence) + "  " + clock;
+
+    // Dark outline under white text stays readable on any background
+    double scale = std::max(0.5, output.rows / 720.0);
+    cv::Point origin(10, static_cast<int>(30 * scale));
+    cv::putText(output, text, origin, cv::FONT_HERSHEY_SIMPLEX, scale, cv::Scalar::all(0), 4, cv::LINE_AA);
+    cv::putText(output, text, origin, cv::FONT_HERSHEY_SIMPLEX, scale, cv::Scalar::all(255), 1, cv::LINE_AA);
+}
+
+FunctionStage::FunctionStage(std::string name, Function function, bool stateless)
+    : m_name(std::move(name))
+    , m_function(std::move(function))
+    , m_stateless(stateless)
+{
+}
+
+void FunctionStage::process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output)
+{
+    m_function(inputs, context, output);
+}
+
+std::unique_ptr<ProcessingStage> createProcessingStage(const std::string& spec)
+{
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string argument = colon == std::string::npos ? std::string() : spec.substr(colon + 1);
+
+    try {
+        if (kind == "resize") {
+            size_t x = argument.find('x');
+            if (x == std::string::npos) {
+                return nullptr;
+            }
+            int width = std::stoi(argument.substr(0, x));
+            int height = std::stoi(argument.substr(x + 1));
+            if (width <= 0 || height <= 0) {
+                return nullptr;
+            }
+            return std::make_unique<ResizeStage>(width, height);
+        }
+        if (kind == "gray" || kind == "grey") {
+            return std::make_unique<GrayscaleStage>();
+        }
+        if (kind == "denoise") {
+            return std::make_unique<DenoiseStage>(argument.empty() ? 5 : std::stoi(argument));
+        }
+        if (kind == "temporal") {
+            return std::make_unique<TemporalDenoiseStage>(argument.empty() ? 0.5 : std::stod(argument));
+        }
+        if (kind == "overlay") {
+            return std::make_unique<OverlayStage>();
+        }
+    }
+    catch (const std::exception&) {
+        return nullptr;
+    }
+    return nullptr;
+}
@@ -0,0 +1,121 @@
+#ifndef PROCESSINGSTAGE_H
+#define PROCESSINGSTAGE_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One step of frame processing between capture and display, run by a
+// FrameGraph. A stage reads the outputs of its input stages (or the captured
+// frame) and writes its own output, reusing the output's buffer from the
+// previous frame where the size allows.
+class ProcessingStage
+{
+public:
+    struct Context {
+        int64_t sequence = 0;
+        int64_t timestamp = 0;  // capture time, PipelineMetrics::now() units
+    };
+
+    virtual ~ProcessingStage() = default;
+
+    virtual std::string name() const = 0;
+
+    // Stateless stages may process several frames at once on different
+    // threads. Stateful ones (temporal filters) get frames one at a time, in
+    // capture order.
+    virtual bool isStateless() const { return true; }
+
+    // inputs are in the order the stage was connected in FrameGraph::addStage
+    virtual void process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output) = 0;
+};
+
+// Scale to a fixed size
+class ResizeStage : public ProcessingStage
+{
+public:
+    ResizeStage(int width, int height);
+
+    std::string name() const override;
+    void process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output) override;
+
+private:
+    int m_width;
+    int m_height;
+};
+
+// BGR to single-channel grey
+class GrayscaleStage : public ProcessingStage
+{
+public:
+    std::string name() const override { return "gray"; }
+    void process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output) override;
+};
+
+// Spatial noise reduction with a Gaussian blur of the given odd kernel size
+class DenoiseStage : public ProcessingStage
+{
+public:
+    explicit DenoiseStage(int kernelSize = 5);
+
+    std::string name() const override;
+    void process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output) override;
+
+private:
+    int m_kernelSize;
+};
+
+// Temporal noise reduction: blends each frame with the previous output.
+// weight is the share of the previous output, 0 to 1.
+class TemporalDenoiseStage : public ProcessingStage
+{
+public:
+    explicit TemporalDenoiseStage(double weight = 0.5);
+
+    std::string name() const override;
+    bool isStateless() const override { return false; }
+    void process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output) override;
+
+private:
+    double m_weight;
+    cv::Mat m_previous;
+};
+
+// Frame number and wall-clock time burnt into the top-left corner
+class OverlayStage : public ProcessingStage
+{
+public:
+    std::string name() const override { return "overlay"; }
+    void process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output) override;
+};
+
+// Wraps a function, for one-off stages
+class FunctionStage : public ProcessingStage
+{
+public:
+    using Function = std::function<void(const std::vector<const cv::Mat*>&, const Context&, cv::Mat&)>;
+
+    FunctionStage(std::string name, Function function, bool stateless = true);
+
+    std::string name() const override { return m_name; }
+    bool isStateless() const override { return m_stateless; }
+    void process(const std::vector<const cv::Mat*>& inputs, const Context& context, cv::Mat& output) override;
+
+private:
+    std::string m_name;
+    Function m_function;
+    bool m_stateless;
+};
+
+// Create a stage from a command-line style spec, or nullptr if unknown:
+//   "resize:1280x720"     scale to 1280x720
+//   "gray"                grayscale
+//   "denoise[:5]"         Gaussian blur, kernel size
+//   "temporal[:0.5]"      temporal denoise, weight of the previous frame
+//   "overlay"             frame number and time
+std::unique_ptr<ProcessingStage> createProcessingStage(const std::string& spec);
+
+#endif // PROCESSINGSTAGE_H
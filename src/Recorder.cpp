@@ -0,0 +1,251 @@
+#include "Recorder.h"
+#include "FrameAllocator.h"
+#include "PipelineMetrics.h"
+#include <opencv2/imgproc.hpp>
+#include <QDebug>
+#include <algorithm>
+#include <cctype>
+
+Recorder::Recorder(size_t queueCapacity, DropPolicy policy)
+    : m_capacity(std::max<size_t>(1, queueCapacity))
+    , m_policy(policy)
+    , m_recording(false)
+    , m_stopRequested(false)
+    , m_framesQueued(0)
+    , m_framesEncoded(0)
+    , m_framesDropped(0)
+    , m_startTime(0)
+{
+}
+
+Recorder::~Recorder()
+{
+    stop();
+}
+
+void Recorder::setQueueCapacity(size_t frames)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recording) {
+        m_capacity = std::max<size_t>(1, frames);
+    }
+}
+
+void Recorder::setDropPolicy(DropPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recording) {
+        m_policy = policy;
+    }
+}
+
+bool Recorder::start(const std::string& path, double fps, const cv::Size& size)
+{
+    stop();
+
+    std::string extension = path.substr(path.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    int fourcc = extension == "mp4" ? cv::VideoWriter::fourcc('m', 'p', '4', 'v')
+                                    : cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+
+    if (!m_writer.open(path, fourcc, fps > 0.0 ? fps : 30.0, size)) {
+        qDebug() << "Cannot open video writer for" << QString::fromStdString(path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_videoSize = size;
+
+    // Slots are allocated by the first copy into them and reused afterwards
+    m_slots.assign(m_capacity, cv::Mat());
+    for (auto& slot : m_slots) {
+        FrameAllocator::use(slot);
+    }
+    m_freeSlots.clear();
+    for (int i = static_cast<int>(m_capacity) - 1; i >= 0; --i) {
+        m_freeSlots.push_back(i);
+    }
+    m_queue.clear();
+    m_encodeTimes.clear();
+    m_framesQueued = 0;
+    m_framesEncoded = 0;
+    m_framesDropped = 0;
+    m_startTime = PipelineMetrics::now();
+    m_stopRequested = false;
+    m_recording = true;
+
+    m_encodeThread = std::thread(&Recorder::encodeLoop, this);
+
+    qDebug() << "Recording to" << QString::fromStdString(path) << "policy" << policyName(m_policy)
+             << "queue" << m_capacity;
+    return true;
+}
+
+void Recorder::stop()
+{
+    if (!m_encodeThread.joinable()) {
+        return;
+    }
+
+    // The encoder drains whatever is queued before it exits
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_frameQueued.notify_all();
+    m_slotFreed.notify_all();
+    m_encodeThread.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_recording = false;
+    qDebug() << "Recording stopped:" << m_framesEncoded << "frames written," << m_framesDropped << "dropped";
+}
+
+bool Recorder::isRecording() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recording && !m_stopRequested;
+}
+
+bool Recorder::push(const cv::Mat& frame)
+{
+    if (frame.empty()) {
+        return false;
+    }
+
+    int slot;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_recording || m_stopRequested) {
+            return false;
+        }
+
+        if (m_freeSlots.empty()) {
+            // With nothing queued the only busy slot is being encoded, so
+            // dropping the oldest falls back to dropping this frame
+            DropPolicy policy = m_policy;
+            if (policy == DropPolicy::DropOldest && m_queue.empty()) {
+                policy = DropPolicy::DropNewest;
+            }
+            switch (policy) {
+                case DropPolicy::DropNewest:
+                    ++m_framesDropped;
+                    return false;
+                case DropPolicy::DropOldest:
+                    // Reuse the slot of the oldest frame still waiting
+                    m_freeSlots.push_back(m_queue.front());
+                    m_queue.pop_front();
+                    ++m_framesDropped;
+                    break;
+                case DropPolicy::Block:
+                    m_slotFreed.wait(lock, [this] { return m_stopRequested || !m_freeSlots.empty(); });
+                    if (m_stopRequested) {
+                        return false;
+                    }
+                    break;
+            }
+        }
+
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+
+    // The slot is ours until queued; copy outside the lock
+    frame.copyTo(m_slots[slot]);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(slot);
+        ++m_framesQueued;
+    }
+    m_frameQueued.notify_one();
+    return true;
+}
+
+Recorder::Stats Recorder::stats() const
+{
+    Stats stats;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.queueDepth = m_queue.size();
+    stats.queueCapacity = m_capacity;
+    stats.framesQueued = m_framesQueued;
+    stats.framesEncoded = m_framesEncoded;
+    stats.framesDropped = m_framesDropped;
+    if (m_encodeTimes.size() >= 2 && m_encodeTimes.back() > m_encodeTimes.front()) {
+        stats.encodedFps = (m_encodeTimes.size() - 1) * 1e9 / (m_encodeTimes.back() - m_encodeTimes.front());
+    }
+    if (m_recording) {
+        stats.secondsRecorded = (PipelineMetrics::now() - m_startTime) / 1e9;
+    }
+    return stats;
+}
+
+const char* Recorder::policyName(DropPolicy policy)
+{
+    switch (policy) {
+        case DropPolicy::DropOldest: return "oldest";
+        case DropPolicy::DropNewest: return "newest";
+        case DropPolicy::Block: return "block";
+        default: return "unknown";
+    }
+}
+
+bool Recorder::parsePolicy(const std::string& name, DropPolicy& policy)
+{
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (lower == "oldest" || lower == "drop-oldest") {
+        policy = DropPolicy::DropOldest;
+    } else if (lower == "newest" || lower == "drop-newest") {
+        policy = DropPolicy::DropNewest;
+    } else if (lower == "block") {
+        policy = DropPolicy::Block;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void Recorder::encodeLoop()
+{
+    cv::Mat resized;
+
+    while (true) {
+        int slot;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_frameQueued.wait(lock, [this] { return m_stopRequested || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                break; // stop requested and drained
+            }
+            slot = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        // The video size is fixed; frames from a later resolution change
+        // are scaled to fit
+        const cv::Mat& frame = m_slots[slot];
+        if (frame.size() != m_videoSize) {
+            cv::resize(frame, resized, m_videoSize);
+            m_writer.write(resized);
+        } else {
+            m_writer.write(frame);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeSlots.push_back(slot);
+            ++m_framesEncoded;
+            m_encodeTimes.push_back(PipelineMetrics::now());
+            if (m_encodeTimes.size() > RATE_WINDOW) {
+                m_encodeTimes.pop_front();
+            }
+        }
+        m_slotFreed.notify_one();
+    }
+
+    m_writer.release();
+}
@@ -0,0 +1,92 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records frames to a video file with cv::VideoWriter on a background thread.
+//
+// push() is called from the capture thread and copies the frame into one of a
+// fixed number of preallocated queue slots; the encoder thread drains them in
+// order. When the queue is full the drop policy decides what gives: the
+// oldest queued frame, the incoming frame, or the caller (which blocks until
+// the encoder frees a slot).
+class Recorder
+{
+public:
+    enum class DropPolicy {
+        DropOldest,
+        DropNewest,
+        Block
+    };
+
+    struct Stats {
+        size_t queueDepth = 0;
+        size_t queueCapacity = 0;
+        uint64_t framesQueued = 0;
+        uint64_t framesEncoded = 0;
+        uint64_t framesDropped = 0;
+        double encodedFps = 0.0;
+        double secondsRecorded = 0.0;
+    };
+
+    explicit Recorder(size_t queueCapacity = 30, DropPolicy policy = DropPolicy::DropOldest);
+    ~Recorder();
+
+    // Only while stopped
+    void setQueueCapacity(size_t frames);
+    void setDropPolicy(DropPolicy policy);
+
+    // Open path for writing; the codec follows the extension (.avi MJPG,
+    // .mp4 mp4v). Frames of any other size are scaled to size.
+    bool start(const std::string& path, double fps, const cv::Size& size);
+    void stop();
+    bool isRecording() const;
+
+    // Queue a BGR frame; returns false if it was dropped
+    bool push(const cv::Mat& frame);
+
+    Stats stats() const;
+
+    static const char* policyName(DropPolicy policy);
+    static bool parsePolicy(const std::string& name, DropPolicy& policy);
+
+private:
+    void encodeLoop();
+
+    cv::VideoWriter m_writer;
+    cv::Size m_videoSize;
+
+    size_t m_capacity;
+    DropPolicy m_policy;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_frameQueued;
+    std::condition_variable m_slotFreed;
+    std::vector<cv::Mat> m_slots;
+    std::vector<int> m_freeSlots;
+    std::deque<int> m_queue;
+    bool m_recording;
+    bool m_stopRequested;
+
+    uint64_t m_framesQueued;
+    uint64_t m_framesEncoded;
+    uint64_t m_framesDropped;
+    int64_t m_startTime;
+
+    // Completion times of recent encodes, for the encoded frame rate
+    static const size_t RATE_WINDOW = 32;
+    std::deque<int64_t> m_encodeTimes;
+
+    std::thread m_encodeThread;
+};
+
+#endif // RECORDER_H
@@ -0,0 +1,308 @@
+#include "SegmentStore.h"
+#include <opencv2/imgcodecs.hpp>
+#include <QDebug>
+#include <QDir>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+SegmentStore::SegmentStore()
+    : m_segmentBytes(0)
+    , m_currentSegment(0)
+    , m_frames(0)
+    , m_bytesOnDisk(0)
+    , m_stopRequested(false)
+    , m_dropped(0)
+{
+}
+
+SegmentStore::~SegmentStore()
+{
+    close();
+}
+
+bool SegmentStore::open(const QString& directory, size_t budgetBytes, size_t segmentBytes)
+{
+    close();
+
+    // At least two segments, so one can be recycled while the other is live.
+    // Small budgets get smaller segments rather than being overrun.
+    segmentBytes = std::min(segmentBytes, budgetBytes / 2) / SEGMENT_ALIGNMENT * SEGMENT_ALIGNMENT;
+    if (segmentBytes < MIN_SEGMENT_BYTES) {
+        qDebug() << "Disk history budget of" << budgetBytes / (1024 * 1024) << "MB is below the minimum of"
+                 << MIN_BUDGET_BYTES / (1024 * 1024) << "MB";
+        return false;
+    }
+    size_t count = budgetBytes / segmentBytes;
+    m_segmentBytes = static_cast<qint64>(segmentBytes);
+
+    QDir dir(directory);
+    if (!dir.mkpath(".")) {
+        qDebug() << "Cannot create history directory" << directory;
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        auto segment = std::make_unique<Segment>();
+        segment->file.setFileName(dir.filePath(QString("segment-%1.dvr").arg(i, 3, 10, QChar('0'))));
+        if (!segment->file.open(QIODevice::ReadWrite) ||
+            !segment->file.resize(m_segmentBytes) ||
+            !(segment->data = segment->file.map(0, m_segmentBytes))) {
+            qDebug() << "Cannot map history segment" << segment->file.fileName()
+                     << segment->file.errorString();
+            m_segments.push_back(std::move(segment));
+            close();
+            return false;
+        }
+        m_segments.push_back(std::move(segment));
+    }
+
+    m_currentSegment = 0;
+    startWriter();
+
+    // Whole segments only, so up to one segment of the budget goes unused
+    qDebug() << "Disk history:" << count << "segments of" << segmentBytes / 1024 << "KB in" << dir.absolutePath()
+             << "-" << count * segmentBytes / (1024 * 1024) << "of" << budgetBytes / (1024 * 1024) << "MB budget";
+    return true;
+}
+
+void SegmentStore::close()
+{
+    stopWriter();
+
+    {
+        std::unique_lock<std::shared_mutex> lock(m_indexMutex);
+        m_index.clear();
+        m_frames = 0;
+        m_bytesOnDisk = 0;
+    }
+
+    // The index lives in memory only, so the files are useless once closed
+    for (auto& segment : m_segments) {
+        if (segment->data) {
+            segment->file.unmap(segment->data);
+        }
+        segment->file.close();
+        segment->file.remove();
+    }
+    m_segments.clear();
+}
+
+void SegmentStore::clear()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    stopWriter();
+    {
+        std::unique_lock<std::shared_mutex> lock(m_indexMutex);
+        m_index.clear();
+        m_frames = 0;
+        m_bytesOnDisk = 0;
+    }
+    for (auto& segment : m_segments) {
+        segment->writeOffset = 0;
+    }
+    m_currentSegment = 0;
+    m_dropped = 0;
+    startWriter();
+}
+
+void SegmentStore::append(int64_t sequence, int64_t timestamp, const std::vector<uchar>& encoded)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        if (m_stopRequested || m_pending.size() >= MAX_PENDING) {
+            ++m_dropped;
+            return;
+        }
+        std::vector<uchar> data;
+        if (!m_spareBuffers.empty()) {
+            data = std::move(m_spareBuffers.back());
+            m_spareBuffers.pop_back();
+        }
+        // Headroom so a recycled buffer fits the next few frames as their
+        // size wanders
+        if (data.capacity() < encoded.size()) {
+            data.clear();
+            data.reserve(encoded.size() + encoded.size() / 8);
+        }
+        data.assign(encoded.begin(), encoded.end());
+        m_pending.push_back({sequence, timestamp, std::move(data)});
+    }
+    m_pendingChanged.notify_one();
+}
+
+bool SegmentStore::decode(int64_t& sequence, int64_t& timestamp, cv::Mat& frame) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_indexMutex);
+    if (m_index.empty() || sequence < m_index.front().sequence) {
+        return false;
+    }
+
+    // Entries are contiguous by sequence, so the position is a subtraction
+    size_t position = static_cast<size_t>(
+        std::min<int64_t>(sequence - m_index.front().sequence, m_index.size() - 1));
+    while (m_index[position].size == 0) {
+        if (position == 0) {
+            return false;
+        }
+        --position;
+    }
+
+    // Decode straight from the mapping; the shared lock keeps the segment
+    // from being recycled underneath us
+    const IndexEntry& entry = m_index[position];
+    cv::Mat encoded(1, entry.size, CV_8UC1, m_segments[entry.segment]->data + entry.offset);
+    frame = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+    sequence = entry.sequence;
+    timestamp = entry.timestamp;
+    return !frame.empty();
+}
+
+int64_t SegmentStore::sequenceAt(int64_t timestamp) const
+{
+    // Placeholders carry their predecessor's timestamp, so the index stays
+    // sorted by time
+    std::shared_lock<std::shared_mutex> lock(m_indexMutex);
+    auto it = std::upper_bound(m_index.begin(), m_index.end(), timestamp,
+                               [](int64_t value, const IndexEntry& entry) { return value < entry.timestamp; });
+    if (it == m_index.begin()) {
+        return -1;
+    }
+    return std::prev(it)->sequence;
+}
+
+int64_t SegmentStore::nextSequence(int64_t sequence) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_indexMutex);
+    if (m_index.empty() || sequence > m_index.back().sequence) {
+        return -1;
+    }
+
+    // Placeholders stand in for frames that never reached disk; the index
+    // always ends on a stored frame, so the scan stops before running off it
+    size_t position = static_cast<size_t>(std::max<int64_t>(sequence - m_index.front().sequence, 0));
+    while (m_index[position].size == 0) {
+        ++position;
+    }
+    return m_index[position].sequence;
+}
+
+int64_t SegmentStore::oldestSequence() const
+{
+    // Recycling drops leading gaps too, so the front is always stored
+    std::shared_lock<std::shared_mutex> lock(m_indexMutex);
+    return m_index.empty() ? -1 : m_index.front().sequence;
+}
+
+SegmentStore::Stats SegmentStore::stats() const
+{
+    Stats stats;
+    stats.dropped = m_dropped;
+
+    std::shared_lock<std::shared_mutex> lock(m_indexMutex);
+    stats.bytesOnDisk = m_bytesOnDisk;
+    stats.frames = m_frames;
+    if (!m_index.empty()) {
+        stats.oldestSequence = m_index.front().sequence;
+        stats.latestSequence = m_index.back().sequence;
+        stats.secondsCovered = (m_index.back().timestamp - m_index.front().timestamp) / 1e9;
+    }
+    return stats;
+}
+
+void SegmentStore::startWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_pending.clear();
+        m_stopRequested = false;
+    }
+    m_writerThread = std::thread(&SegmentStore::writeLoop, this);
+}
+
+void SegmentStore::stopWriter()
+{
+    if (!m_writerThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_stopRequested = true;
+    }
+    m_pendingChanged.notify_all();
+    m_writerThread.join();
+}
+
+void SegmentStore::writeLoop()
+{
+    PendingFrame frame;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_pendingMutex);
+            // Hand the last frame's buffer back for append() to fill again
+            if (frame.data.capacity() > 0 && m_spareBuffers.size() < MAX_PENDING) {
+                m_spareBuffers.push_back(std::move(frame.data));
+            }
+            m_pendingChanged.wait(lock, [this] { return m_stopRequested || !m_pending.empty(); });
+            if (m_stopRequested) {
+                break;
+            }
+            frame = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+        write(frame);
+    }
+}
+
+void SegmentStore::write(const PendingFrame& frame)
+{
+    qint64 size = static_cast<qint64>(frame.data.size());
+    if (size == 0 || size > m_segmentBytes) {
+        ++m_dropped;
+        return;
+    }
+
+    // Move on to the next segment when this one is full, reclaiming it from
+    // the oldest part of the history
+    Segment* segment = m_segments[m_currentSegment].get();
+    if (segment->writeOffset + size > m_segmentBytes) {
+        m_currentSegment = (m_currentSegment + 1) % static_cast<int>(m_segments.size());
+        recycleSegment(m_currentSegment);
+        segment = m_segments[m_currentSegment].get();
+    }
+
+    // The region past writeOffset is not indexed yet, so no reader can be
+    // looking at it while we copy
+    qint64 offset = segment->writeOffset;
+    std::memcpy(segment->data + offset, frame.data.data(), frame.data.size());
+    segment->writeOffset += size;
+
+    std::unique_lock<std::shared_mutex> lock(m_indexMutex);
+    if (!m_index.empty()) {
+        // Keep the index contiguous across frames that never reached us
+        for (int64_t missing = m_index.back().sequence + 1; missing < frame.sequence; ++missing) {
+            m_index.push_back({missing, m_index.back().timestamp, -1, 0, 0});
+        }
+    }
+    m_index.push_back({frame.sequence, frame.timestamp, m_currentSegment, offset, static_cast<int>(size)});
+    ++m_frames;
+    m_bytesOnDisk += static_cast<size_t>(size);
+}
+
+void SegmentStore::recycleSegment(int segment)
+{
+    // Writes are sequential, so the recycled segment's frames are the oldest
+    std::unique_lock<std::shared_mutex> lock(m_indexMutex);
+    while (!m_index.empty() && (m_index.front().size == 0 || m_index.front().segment == segment)) {
+        if (m_index.front().size > 0) {
+            --m_frames;
+            m_bytesOnDisk -= static_cast<size_t>(m_index.front().size);
+        }
+        m_index.pop_front();
+    }
+    m_segments[segment]->writeOffset = 0;
+}
@@ -0,0 +1,130 @@
+#ifndef SEGMENTSTORE_H
+#define SEGMENTSTORE_H
+
+#include <opencv2/core.hpp>
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+// Disk-backed rewind history for long sessions.
+//
+// Encoded frames are appended sequentially to a fixed set of preallocated
+// segment files by a writer thread. Each frame gets an index entry (segment,
+// offset, size, timestamp) addressed directly by sequence number, so a seek
+// is O(1). Segments are memory-mapped and frames are decoded straight from
+// the mapping. When the last segment fills up, the oldest one is recycled
+// and its frames drop out of the index.
+class SegmentStore
+{
+public:
+    struct Stats {
+        size_t bytesOnDisk = 0;
+        size_t frames = 0;
+        int64_t oldestSequence = -1;
+        int64_t latestSequence = -1;
+        double secondsCovered = 0.0;
+        uint64_t dropped = 0;
+    };
+
+    SegmentStore();
+    ~SegmentStore();
+
+    // Create and map segment files in directory, using at most budgetBytes
+    // of disk. Segments are shrunk so that at least two fit the budget.
+    // Returns false if the files cannot be created, or the budget is below
+    // MIN_BUDGET_BYTES.
+    bool open(const QString& directory, size_t budgetBytes, size_t segmentBytes = DEFAULT_SEGMENT_BYTES);
+    void close();
+    bool isOpen() const { return !m_segments.empty(); }
+
+    // Drop every stored frame; the files are kept for reuse
+    void clear();
+
+    // Queue a copy of an encoded frame for the writer thread, in a buffer
+    // recycled from frames already written. Frames are dropped if the writer
+    // falls behind. Sequences must increase.
+    void append(int64_t sequence, int64_t timestamp, const std::vector<uchar>& encoded);
+
+    // Decode the newest stored frame at or before sequence. On success
+    // sequence and timestamp are updated to the frame actually returned.
+    bool decode(int64_t& sequence, int64_t& timestamp, cv::Mat& frame) const;
+
+    // Newest sequence captured at or before timestamp, or -1
+    int64_t sequenceAt(int64_t timestamp) const;
+
+    // Oldest stored sequence at or after sequence, or -1
+    int64_t nextSequence(int64_t sequence) const;
+
+    // Oldest sequence still stored, or -1; cheaper than stats()
+    int64_t oldestSequence() const;
+
+    Stats stats() const;
+
+    static const size_t DEFAULT_SEGMENT_BYTES = 64 * 1024 * 1024;
+
+    // Segments are whole multiples of this, and each must hold a few
+    // frames, which makes two of the smallest the least a budget can be
+    static const size_t SEGMENT_ALIGNMENT = 64 * 1024;
+    static const size_t MIN_SEGMENT_BYTES = 4 * 1024 * 1024;
+    static const size_t MIN_BUDGET_BYTES = 2 * MIN_SEGMENT_BYTES;
+
+private:
+    struct Segment {
+        QFile file;
+        uchar* data = nullptr;
+        qint64 writeOffset = 0;
+    };
+
+    // size == 0 marks a sequence that was never stored
+    struct IndexEntry {
+        int64_t sequence;
+        int64_t timestamp;
+        int segment;
+        qint64 offset;
+        int size;
+    };
+
+    struct PendingFrame {
+        int64_t sequence;
+        int64_t timestamp;
+        std::vector<uchar> data;
+    };
+
+    void startWriter();
+    void stopWriter();
+    void writeLoop();
+    void write(const PendingFrame& frame);
+    void recycleSegment(int segment);
+
+    std::vector<std::unique_ptr<Segment>> m_segments;
+    qint64 m_segmentBytes;
+    int m_currentSegment;
+
+    // Readers decode under a shared lock; the writer takes it exclusively
+    // only to publish index entries and recycle segments
+    mutable std::shared_mutex m_indexMutex;
+    std::deque<IndexEntry> m_index;
+    size_t m_frames;        // stored entries in the index, without gaps
+    size_t m_bytesOnDisk;
+
+    static const size_t MAX_PENDING = 64;
+    std::mutex m_pendingMutex;
+    std::condition_variable m_pendingChanged;
+    std::deque<PendingFrame> m_pending;
+    std::vector<std::vector<uchar>> m_spareBuffers;
+    bool m_stopRequested;
+    std::atomic<uint64_t> m_dropped;
+
+    std::thread m_writerThread;
+};
+
+#endif // SEGMENTSTORE_H
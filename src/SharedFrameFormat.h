@@ -0,0 +1,76 @@
+#ifndef SHAREDFRAMEFORMAT_H
+#define SHAREDFRAMEFORMAT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Memory layout of the shared-memory frame ring written by
+// SharedFramePublisher and mapped by SharedFrameReader. Plain C++ with no Qt
+// or OpenCV, so consumers need only this header and the reader.
+//
+// The object starts with a RingHeader page followed by slotCount slots of
+// slotBytes each. Frames go into the slots round-robin; each slot holds a
+// SlotHeader and then the pixels, rows packed at stride bytes.
+//
+// Slots are published seqlock-style. The slot's lock word is odd while the
+// publisher is writing it and even once the frame is complete. A reader
+// notes the word, uses the pixels in place, and then checks that the word
+// has not changed; if it has, the publisher lapped the ring meanwhile and
+// the frame must be discarded. Readers never write to the mapping, so any
+// number of them can attach without the publisher noticing.
+namespace SharedFrames {
+
+const uint32_t MAGIC = 0x52464351;  // "QCFR"
+const uint32_t VERSION = 1;
+const size_t HEADER_BYTES = 4096;
+const size_t SLOT_HEADER_BYTES = 64;
+const size_t SLOT_ALIGNMENT = 4096;
+
+enum State : uint32_t {
+    Publishing = 1,
+    Closed = 2      // the publisher has gone; reopen by name to follow a new one
+};
+
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t reserved;
+    uint64_t slotBytes;             // distance between slots, header included
+    uint64_t totalBytes;
+    std::atomic<uint32_t> state;
+    alignas(64) std::atomic<uint64_t> latest;  // sequence of the newest complete frame, 0 before the first
+};
+
+struct SlotHeader {
+    std::atomic<uint64_t> lock;     // seqlock word, odd while being written
+    uint64_t sequence;              // 1 for the first frame published, then +1 per frame
+    int64_t timestamp;              // capture time, steady clock (CLOCK_MONOTONIC) nanoseconds
+    int32_t width;
+    int32_t height;
+    int32_t type;                   // OpenCV type, e.g. CV_8UC3 (16) for BGR
+    int32_t stride;                 // bytes per row
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock-free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared atomics must be lock-free");
+static_assert(sizeof(RingHeader) <= HEADER_BYTES, "ring header does not fit its page");
+static_assert(sizeof(SlotHeader) <= SLOT_HEADER_BYTES, "slot header does not fit");
+
+// POSIX shared memory names start with a single slash
+inline std::string objectName(const std::string& name)
+{
+    return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+
+inline size_t slotBytesFor(size_t maxFrameBytes)
+{
+    size_t bytes = SLOT_HEADER_BYTES + maxFrameBytes;
+    return (bytes + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+}
+
+} // namespace SharedFrames
+
+#endif // SHAREDFRAMEFORMAT_H
@@ -0,0 +1,180 @@
+#include "SharedFramePublisher.h"
+#include "PipelineMetrics.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace SharedFrames;
+
+SharedFramePublisher::SharedFramePublisher()
+    : m_mapping(nullptr)
+    , m_mappedBytes(0)
+    , m_header(nullptr)
+    , m_maxFrameBytes(0)
+    , m_sequence(0)
+    , m_published(0)
+    , m_tooLarge(0)
+    , m_publishNs(0)
+{
+}
+
+SharedFramePublisher::~SharedFramePublisher()
+{
+    close();
+}
+
+bool SharedFramePublisher::open(const std::string& name, size_t slotCount, size_t maxFrameBytes)
+{
+    close();
+    if (name.empty() || slotCount == 0 || maxFrameBytes == 0) {
+        return false;
+    }
+
+#ifdef _WIN32
+    qDebug() << "Shared-memory frame export needs POSIX shared memory";
+    return false;
+#else
+    std::string objectName = SharedFrames::objectName(name);
+    size_t slotBytes = slotBytesFor(maxFrameBytes);
+    size_t totalBytes = HEADER_BYTES + slotCount * slotBytes;
+
+    // A ring left behind by a crashed run is replaced, not reused; readers
+    // still mapping it keep their old copy
+    shm_unlink(objectName.c_str());
+    int fd = shm_open(objectName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        qDebug() << "Cannot create shared memory" << objectName.c_str() << ":" << std::strerror(errno);
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(totalBytes)) != 0) {
+        qDebug() << "Cannot size shared memory" << objectName.c_str() << ":" << std::strerror(errno);
+        ::close(fd);
+        shm_unlink(objectName.c_str());
+        return false;
+    }
+    void* mapping = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        qDebug() << "Cannot map shared memory" << objectName.c_str() << ":" << std::strerror(errno);
+        shm_unlink(objectName.c_str());
+        return false;
+    }
+
+    // The object comes back zero-filled, so every slot lock starts even
+    m_mapping = static_cast<uchar*>(mapping);
+    m_mappedBytes = totalBytes;
+    m_header = new (m_mapping) RingHeader;
+    m_header->magic = MAGIC;
+    m_header->version = VERSION;
+    m_header->slotCount = static_cast<uint32_t>(slotCount);
+    m_header->reserved = 0;
+    m_header->slotBytes = slotBytes;
+    m_header->totalBytes = totalBytes;
+    m_header->latest.store(0, std::memory_order_relaxed);
+    m_header->state.store(Publishing, std::memory_order_release);
+
+    m_name = objectName;
+    m_maxFrameBytes = slotBytes - SLOT_HEADER_BYTES;
+    m_sequence = 0;
+    m_published = 0;
+    m_tooLarge = 0;
+    m_publishNs = 0;
+
+    qDebug() << "Publishing frames to shared memory" << m_name.c_str() << "-" << slotCount << "slots,"
+             << totalBytes / (1024 * 1024) << "MB";
+    return true;
+#endif
+}
+
+void SharedFramePublisher::close()
+{
+    if (!m_header) {
+        return;
+    }
+
+#ifndef _WIN32
+    m_header->state.store(Closed, std::memory_order_release);
+    munmap(m_mapping, m_mappedBytes);
+    shm_unlink(m_name.c_str());
+#endif
+
+    Stats totals = stats();
+    qDebug() << "Shared memory" << m_name.c_str() << "closed after" << totals.published << "frames,"
+             << totals.publishMs << "ms per frame," << totals.tooLarge << "too large";
+
+    m_mapping = nullptr;
+    m_mappedBytes = 0;
+    m_header = nullptr;
+    m_name.clear();
+}
+
+void SharedFramePublisher::publish(const cv::Mat& frame, int64_t timestamp)
+{
+    if (!m_header || frame.empty()) {
+        return;
+    }
+
+    size_t rowBytes = frame.cols * frame.elemSize();
+    size_t frameBytes = rowBytes * frame.rows;
+    if (frameBytes > m_maxFrameBytes) {
+        if (m_tooLarge++ == 0) {
+            qDebug() << "Frames of" << frame.cols << "x" << frame.rows << "do not fit the shared-memory slots";
+        }
+        return;
+    }
+
+    int64_t start = PipelineMetrics::now();
+    uint64_t sequence = m_sequence + 1;
+    SlotHeader* target = slot(sequence - 1);
+
+    // Odd lock word: readers that catch the slot now discard what they read
+    uint64_t lock = target->lock.load(std::memory_order_relaxed);
+    target->lock.store(lock + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    target->sequence = sequence;
+    target->timestamp = timestamp;
+    target->width = frame.cols;
+    target->height = frame.rows;
+    target->type = frame.type();
+    target->stride = static_cast<int32_t>(rowBytes);
+
+    uchar* pixels = reinterpret_cast<uchar*>(target) + SLOT_HEADER_BYTES;
+    if (frame.isContinuous()) {
+        std::memcpy(pixels, frame.data, frameBytes);
+    } else {
+        for (int row = 0; row < frame.rows; ++row) {
+            std::memcpy(pixels + row * rowBytes, frame.ptr(row), rowBytes);
+        }
+    }
+
+    target->lock.store(lock + 2, std::memory_order_release);
+    m_header->latest.store(sequence, std::memory_order_release);
+    m_sequence = sequence;
+
+    m_publishNs += PipelineMetrics::now() - start;
+    ++m_published;
+}
+
+SharedFramePublisher::Stats SharedFramePublisher::stats() const
+{
+    Stats stats;
+    stats.published = m_published;
+    stats.tooLarge = m_tooLarge;
+    stats.publishMs = stats.published > 0 ? m_publishNs / 1e6 / stats.published : 0.0;
+    stats.mappedBytes = m_mappedBytes;
+    return stats;
+}
+
+SlotHeader* SharedFramePublisher::slot(uint64_t index) const
+{
+    uchar* base = m_mapping + HEADER_BYTES + (index % m_header->slotCount) * m_header->slotBytes;
+    return reinterpret_cast<SlotHeader*>(base);
+}
@@ -0,0 +1,68 @@
+#ifndef SHAREDFRAMEPUBLISHER_H
+#define SHAREDFRAMEPUBLISHER_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SharedFrameFormat.h"
+
+// Writes captured frames into a named POSIX shared-memory ring (see
+// SharedFrameFormat.h) for other local processes to read in place with
+// SharedFrameReader. Publishing costs one copy of the frame into the next
+// slot and no system calls; readers do not slow the publisher down.
+//
+// The ring is sized once for the largest frame it will carry. Larger frames
+// are skipped and counted rather than reallocating under mapped readers.
+class SharedFramePublisher
+{
+public:
+    struct Stats {
+        uint64_t published = 0;
+        uint64_t tooLarge = 0;
+        double publishMs = 0.0;     // mean copy time per frame
+        size_t mappedBytes = 0;
+    };
+
+    SharedFramePublisher();
+    ~SharedFramePublisher();
+
+    SharedFramePublisher(const SharedFramePublisher&) = delete;
+    SharedFramePublisher& operator=(const SharedFramePublisher&) = delete;
+
+    // Create (or replace) the named ring. Returns false if shared memory is
+    // unavailable or the object cannot be created.
+    bool open(const std::string& name, size_t slotCount = DEFAULT_SLOTS,
+              size_t maxFrameBytes = DEFAULT_MAX_FRAME_BYTES);
+    // Marks the ring closed for readers and removes the name
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    const std::string& name() const { return m_name; }
+
+    // Producer side; one thread at a time. The timestamp is the capture time
+    // in PipelineMetrics::now() units.
+    void publish(const cv::Mat& frame, int64_t timestamp);
+
+    Stats stats() const;
+
+    static const size_t DEFAULT_SLOTS = 4;
+    static const size_t DEFAULT_MAX_FRAME_BYTES = 3840 * 2160 * 3;
+
+private:
+    SharedFrames::SlotHeader* slot(uint64_t index) const;
+
+    std::string m_name;
+    uchar* m_mapping;
+    size_t m_mappedBytes;
+    SharedFrames::RingHeader* m_header;
+    size_t m_maxFrameBytes;
+    uint64_t m_sequence;
+
+    std::atomic<uint64_t> m_published;
+    std::atomic<uint64_t> m_tooLarge;
+    std::atomic<int64_t> m_publishNs;
+};
+
+#endif // SHAREDFRAMEPUBLISHER_H
@@ -0,0 +1,186 @@
+#include "SharedFrameReader.h"
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace SharedFrames;
+
+SharedFrameReader::SharedFrameReader()
+    : m_mapping(nullptr)
+    , m_mappedBytes(0)
+    , m_header(nullptr)
+{
+}
+
+SharedFrameReader::~SharedFrameReader()
+{
+    close();
+}
+
+bool SharedFrameReader::open(const std::string& name)
+{
+    close();
+
+#ifdef _WIN32
+    m_error = "POSIX shared memory is not available";
+    return false;
+#else
+    std::string objectName = SharedFrames::objectName(name);
+    int fd = shm_open(objectName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        m_error = "cannot open " + objectName + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < HEADER_BYTES) {
+        m_error = objectName + " is not a frame ring";
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        m_error = "cannot map " + objectName + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // The publisher sizes the object before writing the header, so a ring
+    // caught mid-creation simply fails the checks below
+    const RingHeader* header = static_cast<const RingHeader*>(mapping);
+    if (header->magic != MAGIC || header->version != VERSION || header->slotCount == 0 ||
+        header->slotBytes <= SLOT_HEADER_BYTES || header->totalBytes > size ||
+        HEADER_BYTES + header->slotCount * header->slotBytes > header->totalBytes) {
+        m_error = objectName + " is not a frame ring of version " + std::to_string(VERSION);
+        munmap(mapping, size);
+        return false;
+    }
+
+    m_mapping = static_cast<const uint8_t*>(mapping);
+    m_mappedBytes = size;
+    m_header = header;
+    m_error.clear();
+    return true;
+#endif
+}
+
+void SharedFrameReader::close()
+{
+    if (!m_header) {
+        return;
+    }
+#ifndef _WIN32
+    munmap(const_cast<uint8_t*>(m_mapping), m_mappedBytes);
+#endif
+    m_mapping = nullptr;
+    m_mappedBytes = 0;
+    m_header = nullptr;
+}
+
+bool SharedFrameReader::publisherClosed() const
+{
+    return !m_header || m_header->state.load(std::memory_order_acquire) == Closed;
+}
+
+uint64_t SharedFrameReader::latestSequence() const
+{
+    return m_header ? m_header->latest.load(std::memory_order_acquire) : 0;
+}
+
+int SharedFrameReader::slotCount() const
+{
+    return m_header ? static_cast<int>(m_header->slotCount) : 0;
+}
+
+bool SharedFrameReader::acquire(Frame& frame, uint64_t after) const
+{
+    if (!m_header) {
+        return false;
+    }
+
+    // A lost race means the publisher moved on, so retry with the newer
+    // frame; give up after a lap rather than spin against a fast publisher
+    for (uint32_t attempt = 0; attempt < m_header->slotCount; ++attempt) {
+        uint64_t sequence = m_header->latest.load(std::memory_order_acquire);
+        if (sequence == 0 || sequence <= after) {
+            return false;
+        }
+
+        int slot = static_cast<int>((sequence - 1) % m_header->slotCount);
+        const SlotHeader* header = slotHeader(slot);
+        uint64_t lock = header->lock.load(std::memory_order_acquire);
+        if (lock & 1) {
+            continue;
+        }
+
+        Frame candidate;
+        candidate.data = reinterpret_cast<const uint8_t*>(header) + SLOT_HEADER_BYTES;
+        candidate.width = header->width;
+        candidate.height = header->height;
+        candidate.type = header->type;
+        candidate.stride = header->stride;
+        candidate.sequence = header->sequence;
+        candidate.timestamp = header->timestamp;
+        candidate.lock = lock;
+        candidate.slot = slot;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->lock.load(std::memory_order_relaxed) != lock || candidate.sequence != sequence) {
+            continue;
+        }
+        if (candidate.width <= 0 || candidate.height <= 0 || candidate.stride <= 0 ||
+            static_cast<uint64_t>(candidate.stride) * candidate.height > m_header->slotBytes - SLOT_HEADER_BYTES) {
+            return false;
+        }
+
+        frame = candidate;
+        return true;
+    }
+    return false;
+}
+
+bool SharedFrameReader::isValid(const Frame& frame) const
+{
+    if (!m_header || frame.slot < 0) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slotHeader(frame.slot)->lock.load(std::memory_order_relaxed) == frame.lock;
+}
+
+bool SharedFrameReader::copyLatest(Frame& frame, std::vector<uint8_t>& buffer, uint64_t after) const
+{
+    for (uint32_t attempt = 0; m_header && attempt < m_header->slotCount; ++attempt) {
+        if (!acquire(frame, after)) {
+            return false;
+        }
+        size_t bytes = static_cast<size_t>(frame.stride) * frame.height;
+        buffer.resize(bytes);
+        std::memcpy(buffer.data(), frame.data, bytes);
+        if (isValid(frame)) {
+            frame.data = buffer.data();
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t SharedFrameReader::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const SlotHeader* SharedFrameReader::slotHeader(int slot) const
+{
+    return reinterpret_cast<const SlotHeader*>(m_mapping + HEADER_BYTES + slot * m_header->slotBytes);
+}
@@ -0,0 +1,88 @@
+#ifndef SHAREDFRAMEREADER_H
+#define SHAREDFRAMEREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SharedFrameFormat.h"
+
+// Reader side of the shared-memory frame ring, for processes that want the
+// camera feed without opening the camera. Depends on nothing but POSIX.
+//
+// Frames are read in place: acquire() returns a pointer into the mapping,
+// and once done with the pixels the caller asks isValid() whether the
+// publisher overwrote the slot in the meantime. Neither call makes a system
+// call. With the default four slots a reader has about four frame intervals
+// to finish with a frame.
+//
+//   SharedFrameReader reader;
+//   reader.open("qtcamera");
+//   SharedFrameReader::Frame frame;
+//   uint64_t seen = 0;
+//   while (running) {
+//       if (reader.acquire(frame, seen)) {
+//           analyse(frame.data, frame.width, frame.height, frame.stride);
+//           if (reader.isValid(frame)) { seen = frame.sequence; use the result; }
+//       }
+//   }
+class SharedFrameReader
+{
+public:
+    struct Frame {
+        const uint8_t* data = nullptr;
+        int width = 0;
+        int height = 0;
+        int type = 0;       // OpenCV type, e.g. CV_8UC3 for BGR
+        int stride = 0;     // bytes per row
+        uint64_t sequence = 0;
+        int64_t timestamp = 0;
+        uint64_t lock = 0;  // slot lock word when acquired, for isValid()
+        int slot = -1;
+    };
+
+    SharedFrameReader();
+    ~SharedFrameReader();
+
+    SharedFrameReader(const SharedFrameReader&) = delete;
+    SharedFrameReader& operator=(const SharedFrameReader&) = delete;
+
+    // Map the ring the publisher created under name. Returns false, with the
+    // reason in error(), if there is none or it is not a frame ring.
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    const std::string& error() const { return m_error; }
+
+    // The publisher closed the ring; open() again to follow its next one
+    bool publisherClosed() const;
+
+    // Sequence of the newest complete frame, 0 before the first
+    uint64_t latestSequence() const;
+    int slotCount() const;
+
+    // Newest frame with a sequence above after. Returns false if there is
+    // none yet, or it was being overwritten.
+    bool acquire(Frame& frame, uint64_t after = 0) const;
+
+    // Whether the frame's slot is still intact. Check after reading the
+    // pixels and discard any result computed from them if it is not.
+    bool isValid(const Frame& frame) const;
+
+    // acquire() plus a copy into buffer, retried until the copy is intact
+    bool copyLatest(Frame& frame, std::vector<uint8_t>& buffer, uint64_t after = 0) const;
+
+    // Current time on the clock frame timestamps use
+    static int64_t now();
+
+private:
+    const SharedFrames::SlotHeader* slotHeader(int slot) const;
+
+    std::string m_error;
+    const uint8_t* m_mapping;
+    size_t m_mappedBytes;
+    const SharedFrames::RingHeader* m_header;
+};
+
+#endif // SHAREDFRAMEREADER_H
@@ -0,0 +1,94 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(int threads)
+    : m_stopRequested(false)
+{
+    if (threads <= 0) {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    m_workers.reserve(threads);
+    for (int i = 0; i < threads; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_taskAvailable.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_taskAvailable.notify_one();
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    // Workers and the caller pull indices from a shared counter, so uneven
+    // items balance themselves; the caller waits for every helper to finish
+    // because they reference this stack frame
+    struct Shared {
+        std::atomic<int> next{0};
+        int helpersRunning = 0;
+        std::mutex mutex;
+        std::condition_variable done;
+    } shared;
+
+    auto run = [&shared, &fn, count] {
+        for (int i = shared.next++; i < count; i = shared.next++) {
+            fn(i);
+        }
+    };
+
+    int helpers = std::min(count - 1, size());
+    shared.helpersRunning = helpers;
+    for (int i = 0; i < helpers; ++i) {
+        submit([&shared, run] {
+            run();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            if (--shared.helpersRunning == 0) {
+                shared.done.notify_one();
+            }
+        });
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(shared.mutex);
+    shared.done.wait(lock, [&shared] { return shared.helpersRunning == 0; });
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskAvailable.wait(lock, [this] { return m_stopRequested || !m_tasks.empty(); });
+            if (m_stopRequested && m_tasks.empty()) {
+                break;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
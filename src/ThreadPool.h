@@ -0,0 +1,38 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for CPU-bound work such as compositing and
+// encoding. Tasks must not throw.
+class ThreadPool
+{
+public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(m_workers.size()); }
+
+    void submit(std::function<void()> task);
+
+    // Run fn(0) .. fn(count - 1) across the pool and the calling thread, and
+    // return once every call has finished
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stopRequested;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,117 @@
+#include "VideoWidget.h"
+#include "PipelineMetrics.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QWheelEvent>
+#include <algorithm>
+
+VideoWidget::VideoWidget(QWidget* parent)
+    : QWidget(parent)
+    , m_updatePending(false)
+    , m_coalescedFrames(0)
+{
+    // Every pixel is painted below, so Qt need not clear the background first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void VideoWidget::setImage(const QImage& image)
+{
+    // Same buffer as last time: nothing new to show
+    if (!image.isNull() && image.cacheKey() == m_image.cacheKey()) {
+        return;
+    }
+
+    if (m_updatePending) {
+        ++m_coalescedFrames;
+    }
+    m_image = image;
+    m_updatePending = true;
+    update();
+}
+
+void VideoWidget::clear()
+{
+    m_image = QImage();
+    m_updatePending = true;
+    update();
+}
+
+void VideoWidget::setPlaceholderText(const QString& text)
+{
+    m_placeholder = text;
+    update();
+}
+
+QSize VideoWidget::targetSize() const
+{
+    return size() * devicePixelRatioF();
+}
+
+void VideoWidget::setPaintCallback(PaintCallback callback)
+{
+    m_paintCallback = std::move(callback);
+}
+
+void VideoWidget::setZoomCallback(ZoomCallback callback)
+{
+    m_zoomCallback = std::move(callback);
+}
+
+void VideoWidget::wheelEvent(QWheelEvent* event)
+{
+    if (!m_zoomCallback || m_imageRect.isEmpty()) {
+        event->ignore();
+        return;
+    }
+    
+    // One notch is 120; touchpads send smaller steps
+    QPointF position = event->position();
+    double x = std::clamp((position.x() - m_imageRect.left()) / m_imageRect.width(), 0.0, 1.0);
+    double y = std::clamp((position.y() - m_imageRect.top()) / m_imageRect.height(), 0.0, 1.0);
+    m_zoomCallback(event->angleDelta().y() / 120.0, x, y);
+    event->accept();
+}
+
+void VideoWidget::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    if (m_zoomCallback) {
+        m_zoomCallback(0.0, 0.5, 0.5);
+    }
+    event->accept();
+}
+
+void VideoWidget::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+    m_updatePending = false;
+
+    int64_t paintStart = PipelineMetrics::now();
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    if (m_image.isNull()) {
+        m_imageRect = QRectF();
+        painter.setPen(Qt::gray);
+        painter.drawText(rect(), Qt::AlignCenter, m_placeholder);
+        return;
+    }
+
+    // Frames sized for the device pixels are drawn without scaling; others
+    // are fitted once here, keeping the aspect ratio
+    qreal ratio = devicePixelRatioF();
+    QSizeF logical = QSizeF(m_image.size()) / ratio;
+    if (logical.width() > width() + 1 || logical.height() > height() + 1 ||
+        (logical.width() < width() - 1 && logical.height() < height() - 1)) {
+        logical.scale(size(), Qt::KeepAspectRatio);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    }
+
+    QRectF target(QPointF((width() - logical.width()) / 2.0, (height() - logical.height()) / 2.0), logical);
+    painter.drawImage(target, m_image);
+    m_imageRect = target;
+    painter.end();
+
+    if (m_paintCallback) {
+        m_paintCallback(paintStart, PipelineMetrics::now());
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef VIDEOWIDGET_H
+#define VIDEOWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <cstdint>
+#include <functional>
+
+// Paints video frames straight from a QImage. Frames are expected to arrive
+// already scaled to targetSize(), in which case they are blitted 1:1 and
+// centred on a black background; anything else is scaled once at paint time.
+//
+// setImage() only schedules a repaint, so several frames arriving before the
+// next paint collapse into one and only the newest is drawn.
+class VideoWidget : public QWidget
+{
+public:
+    using PaintCallback = std::function<void(int64_t paintStart, int64_t paintEnd)>;
+    
+    // Wheel steps (positive zooms in) at a position given in fractions of
+    // the frame on screen; 0 steps is a double-click, to reset the zoom
+    using ZoomCallback = std::function<void(double steps, double x, double y)>;
+
+    explicit VideoWidget(QWidget* parent = nullptr);
+
+    void setImage(const QImage& image);
+    void clear();
+    void setPlaceholderText(const QString& text);
+
+    // Size in device pixels that frames should be scaled to
+    QSize targetSize() const;
+
+    // Called after each paint that drew a frame, with PipelineMetrics times
+    void setPaintCallback(PaintCallback callback);
+    void setZoomCallback(ZoomCallback callback);
+
+    // Frames replaced before they were ever painted
+    uint64_t coalescedFrames() const { return m_coalescedFrames; }
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+
+private:
+    QImage m_image;
+    QString m_placeholder;
+    PaintCallback m_paintCallback;
+    ZoomCallback m_zoomCallback;
+    QRectF m_imageRect;     // where the last frame was drawn
+    bool m_updatePending;
+    uint64_t m_coalescedFrames;
+};
+
+#endif // VIDEOWIDGET_H
@@ -1,20 +1,264 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <csignal>
+#include <memory>
+#include "HeadlessSession.h"
+
+// QtCameraHeadless is built from this file with QTCAMERA_NO_GUI, and runs
+// headless only without linking Qt Gui or Widgets
+#ifndef QTCAMERA_NO_GUI
 #include <QApplication>
 #include <QMessageBox>
 #include "MainWindow.h"
+#endif
+
+namespace {
+
+// Set by SIGINT/SIGTERM in headless mode and polled from the event loop,
+// so recordings and the shared-memory ring are closed properly
+volatile std::sig_atomic_t quitRequested = 0;
+
+void requestQuit(int)
+{
+    quitRequested = 1;
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    // QApplication loads a platform plugin and needs a display, so headless
+    // mode has to be picked before any application object exists
+#ifdef QTCAMERA_NO_GUI
+    bool headless = true;
+#else
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        }
+    }
+#endif
+    std::unique_ptr<QCoreApplication> app;
+    if (headless) {
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    }
+#ifndef QTCAMERA_NO_GUI
+    else {
+        app = std::make_unique<QApplication>(argc, argv);
+    }
+#endif
+    QCoreApplication::setApplicationName("QtCameraApp");
+    QCoreApplication::setApplicationVersion("1.0.0");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Live camera feed with playback controls");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption sourceOption(QStringList() << "s" << "source",
+        "Frame source: camera index, synthetic:WxH@FPS, file:PATH[@FPS], mjpeg:PATH[@FPS] or images:DIR[@FPS]. "
+        "Repeat for several cameras.",
+        "spec", "0");
+    parser.addOption(sourceOption);
+    QCommandLineOption metricsDumpOption("metrics-dump",
+        "Periodically write pipeline metrics to file (CSV if it ends in .csv, JSON lines otherwise).",
+        "path");
+    parser.addOption(metricsDumpOption);
+    QCommandLineOption metricsIntervalOption("metrics-interval",
+        "Metrics dump interval in milliseconds.", "ms", "1000");
+    parser.addOption(metricsIntervalOption);
+    QCommandLineOption historyOption("history-mb",
+        "Memory budget for the compressed rewind history, in megabytes.", "MB");
+    parser.addOption(historyOption);
+    QCommandLineOption dvrDirOption("dvr-dir",
+        "Also keep rewind history on disk in this directory.", "dir");
+    parser.addOption(dvrDirOption);
+    QCommandLineOption dvrSizeOption("dvr-mb",
+        "Disk budget for the on-disk rewind history, in megabytes.", "MB", "8192");
+    parser.addOption(dvrSizeOption);
+    QCommandLineOption recordDirOption("record-dir",
+        "Directory for recordings (default: the Movies folder).", "dir");
+    parser.addOption(recordDirOption);
+    QCommandLineOption recordQueueOption("record-queue",
+        "Frames the recording encoder may fall behind by.", "frames", "30");
+    parser.addOption(recordQueueOption);
+    QCommandLineOption recordPolicyOption("record-policy",
+        "What to do when the recording queue is full: oldest, newest or block.", "policy", "oldest");
+    parser.addOption(recordPolicyOption);
+    QCommandLineOption snapshotDirOption("snapshot-dir",
+        "Directory for burst snapshots (default: the Pictures folder).", "dir");
+    parser.addOption(snapshotDirOption);
+    QCommandLineOption snapshotFormatOption("snapshot-format",
+        "Image format for burst snapshots: png or jpeg.", "format", "png");
+    parser.addOption(snapshotFormatOption);
+    QCommandLineOption streamPortOption("stream-port",
+        "Serve the first camera as MJPEG over HTTP on this port (/stream, /snapshot.jpg).", "port");
+    parser.addOption(streamPortOption);
+    QCommandLineOption decodeThreadsOption("decode-threads",
+        "Capture cameras in their native format (MJPEG, YUYV) and decode on this many threads, "
+        "in order, instead of on the capture thread (0 = off).", "threads");
+    parser.addOption(decodeThreadsOption);
+    QCommandLineOption changeThresholdOption("change-threshold",
+        "Skip frames that differ from the last one kept by less than this many grey levels (0 = off).", "levels");
+    parser.addOption(changeThresholdOption);
+    QCommandLineOption processOption("process",
+        "Process live frames before display: comma-separated stages from resize:WxH, gray, denoise[:kernel], "
+        "temporal[:weight] and overlay.", "stages");
+    parser.addOption(processOption);
+    QCommandLineOption shmNameOption("shm-name",
+        "Publish frames to a POSIX shared-memory ring under this name for other local processes.", "name");
+    parser.addOption(shmNameOption);
+    QCommandLineOption reprobeOption("reprobe",
+        "Probe camera resolutions again instead of using the cached capabilities.");
+    parser.addOption(reprobeOption);
+    QCommandLineOption headlessOption("headless",
+        "Run without a window under QCoreApplication, e.g. on capture nodes with no display.");
+    parser.addOption(headlessOption);
+    QCommandLineOption recordOption("record",
+        "Headless: record every camera from startup until exit.");
+    parser.addOption(recordOption);
+    QCommandLineOption burstOption("burst",
+        "Headless: save a burst of this many snapshots from every camera at startup "
+        "(see --snapshot-dir and --snapshot-format).", "frames");
+    parser.addOption(burstOption);
+    QCommandLineOption durationOption("duration",
+        "Headless: exit after this many seconds (default: run until interrupted).", "seconds", "0");
+    parser.addOption(durationOption);
+    QCommandLineOption resolutionOption("resolution",
+        "Headless: capture mode to open the cameras in.", "WxH");
+    parser.addOption(resolutionOption);
+    parser.process(*app);
+    
+    Recorder::DropPolicy recordPolicy;
+    if (!Recorder::parsePolicy(parser.value(recordPolicyOption).toStdString(), recordPolicy)) {
+        qWarning("Unknown recording drop policy '%s'", qPrintable(parser.value(recordPolicyOption)));
+        return -1;
+    }
+    BurstWriter::Format snapshotFormat;
+    if (!BurstWriter::parseFormat(parser.value(snapshotFormatOption).toStdString(), snapshotFormat)) {
+        qWarning("Unknown snapshot format '%s'", qPrintable(parser.value(snapshotFormatOption)));
+        return -1;
+    }
     
+    if (headless) {
+        HeadlessSession session(parser.values(sourceOption));
+        session.setReprobeDevices(parser.isSet(reprobeOption));
+        session.setRecordingOptions(parser.value(recordDirOption), parser.value(recordQueueOption).toInt(),
+                                    recordPolicy);
+        session.setRecording(parser.isSet(recordOption));
+        session.setDuration(parser.value(durationOption).toInt());
+        
+        // Snapshots are only taken by a burst, so the options would do nothing
+        if (parser.isSet(burstOption)) {
+            if (parser.value(burstOption).toInt() <= 0) {
+                qWarning("Invalid burst length '%s', expected a number of frames",
+                         qPrintable(parser.value(burstOption)));
+                return -1;
+            }
+            session.setBurst(parser.value(burstOption).toInt(), parser.value(snapshotDirOption), snapshotFormat);
+        }
+        else if (parser.isSet(snapshotDirOption) || parser.isSet(snapshotFormatOption)) {
+            qWarning("--snapshot-dir and --snapshot-format need --burst in headless mode");
+            return -1;
+        }
+        
+        if (parser.isSet(resolutionOption)) {
+            QStringList size = parser.value(resolutionOption).split('x');
+            if (size.size() != 2 || size[0].toInt() <= 0 || size[1].toInt() <= 0) {
+                qWarning("Invalid resolution '%s', expected WxH", qPrintable(parser.value(resolutionOption)));
+                return -1;
+            }
+            session.setCaptureMode(size[0].toInt(), size[1].toInt());
+        }
+        if (parser.isSet(historyOption)) {
+            session.setHistoryBudget(parser.value(historyOption).toInt());
+        }
+        if (parser.isSet(dvrDirOption)
+            && !session.enableDiskHistory(parser.value(dvrDirOption), parser.value(dvrSizeOption).toInt())) {
+            return -1;
+        }
+        if (parser.isSet(decodeThreadsOption)) {
+            session.setDecodeThreads(parser.value(decodeThreadsOption).toInt());
+        }
+        if (parser.isSet(changeThresholdOption)) {
+            session.setChangeThreshold(parser.value(changeThresholdOption).toDouble());
+        }
+        if (parser.isSet(processOption) && !session.setProcessingChain(parser.value(processOption))) {
+            return -1;
+        }
+        if (parser.isSet(shmNameOption) && !session.enableSharedFrames(parser.value(shmNameOption))) {
+            return -1;
+        }
+        if (parser.isSet(streamPortOption)
+            && !session.startStreaming(static_cast<quint16>(parser.value(streamPortOption).toUInt()))) {
+            return -1;
+        }
+        if (!session.start()) {
+            return 1;
+        }
+        if (parser.isSet(metricsDumpOption)
+            && !session.setMetricsDump(parser.value(metricsDumpOption), parser.value(metricsIntervalOption).toInt())) {
+            return -1;
+        }
+        
+        std::signal(SIGINT, requestQuit);
+        std::signal(SIGTERM, requestQuit);
+        QTimer signalTimer;
+        QObject::connect(&signalTimer, &QTimer::timeout, [] {
+            if (quitRequested) {
+                QCoreApplication::quit();
+            }
+        });
+        signalTimer.start(100);
+        
+        int result = app->exec();
+        session.stop();
+        return result;
+    }
+    
+#ifndef QTCAMERA_NO_GUI
     try {
-        MainWindow window;
+        MainWindow window(parser.values(sourceOption));
+        window.setReprobeDevices(parser.isSet(reprobeOption));
+        window.setRecordingOptions(parser.value(recordDirOption), parser.value(recordQueueOption).toInt(),
+                                   recordPolicy);
+        window.setSnapshotOptions(parser.value(snapshotDirOption), snapshotFormat);
+        
+        if (parser.isSet(historyOption)) {
+            window.setHistoryBudget(parser.value(historyOption).toInt());
+        }
+        if (parser.isSet(dvrDirOption)) {
+            window.enableDiskHistory(parser.value(dvrDirOption), parser.value(dvrSizeOption).toInt());
+        }
+        if (parser.isSet(decodeThreadsOption)) {
+            window.setDecodeThreads(parser.value(decodeThreadsOption).toInt());
+        }
+        if (parser.isSet(changeThresholdOption)) {
+            window.setChangeThreshold(parser.value(changeThresholdOption).toDouble());
+        }
+        if (parser.isSet(processOption)) {
+            window.setProcessingChain(parser.value(processOption));
+        }
+        if (parser.isSet(shmNameOption)) {
+            window.enableSharedFrames(parser.value(shmNameOption));
+        }
+        if (parser.isSet(streamPortOption)) {
+            window.startStreaming(static_cast<quint16>(parser.value(streamPortOption).toUInt()));
+        }
+        if (parser.isSet(metricsDumpOption)) {
+            window.setMetricsDump(parser.value(metricsDumpOption),
+                                  parser.value(metricsIntervalOption).toInt());
+        }
         window.show();
         
-        return app.exec();
+        return app->exec();
     }
     catch (const std::exception& e) {
         QMessageBox::critical(nullptr, "Application Error", 
                             QString("Failed to start application: %1").arg(e.what()));
         return -1;
     }
-} 
\ No newline at end of file
+#endif
+    return 0;
+}